@@ -0,0 +1,248 @@
+/***********************************************************************
+ * Header:
+ *    ARENA
+ * Summary:
+ *    A bump allocator for containers that live and die together
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        arena                : Hands out memory from chunks, frees it all at once
+ *        arena_allocator      : An allocator drawing from an arena
+ *        arena_unordered_set  : An unordered_set whose nodes and buckets live in an arena
+ *
+ *    Nothing allocated from an arena is freed until the arena is
+ *    reset or released, so a container built on one never pays for
+ *    a deallocation. When the elements are also trivially
+ *    destructible, clearing or destroying the container does not
+ *    even visit them.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>          // for std::max_align_t
+#include <cstdint>          // for uintptr_t
+#include <memory_resource>  // for std::pmr::memory_resource
+#include <type_traits>      // for std::true_type
+#include "hash.h"           // for unordered_set
+
+class TestHash;             // forward declaration for Hash unit tests
+
+namespace custom
+{
+
+/************************************************
+ * ARENA
+ * Carve allocations off the front of a chunk, getting a new chunk
+ * from upstream when the current one runs out. Each new chunk is
+ * twice the size of the last. reset() rewinds to the first chunk
+ * and keeps them all for reuse; release() gives them back.
+ ************************************************/
+class arena : public std::pmr::memory_resource
+{
+   friend class ::TestHash;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   arena(size_t firstChunk = 64 * 1024,
+         std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : upstream(upstream), pFirst(nullptr), pCurrent(nullptr), pNext(nullptr), pEnd(nullptr),
+        nextChunk(firstChunk < 1024 ? 1024 : firstChunk), numUsed(0), numReserved(0)
+   {}
+   arena(const arena& rhs) = delete;
+   arena& operator = (const arena& rhs) = delete;
+   ~arena()
+   {
+      release();
+   }
+
+   //
+   // Remove
+   //
+   void reset() noexcept
+   {
+      pCurrent = pFirst;
+      pNext = pCurrent ? pCurrent->begin() : nullptr;
+      pEnd  = pCurrent ? pCurrent->end()   : nullptr;
+      numUsed = 0;
+   }
+   void release() noexcept
+   {
+      while (pFirst)
+      {
+         Chunk* p = pFirst;
+         pFirst = p->pNext;
+         upstream->deallocate(p, p->size, alignof(std::max_align_t));
+      }
+      pCurrent = nullptr;
+      pNext = pEnd = nullptr;
+      numUsed = numReserved = 0;
+   }
+
+   //
+   // Status
+   //
+   size_t bytes_used()     const { return numUsed;     }
+   size_t bytes_reserved() const { return numReserved; }
+
+private:
+   // a chunk header sits in front of the memory it hands out
+   struct alignas(std::max_align_t) Chunk
+   {
+      Chunk* pNext;   // the next chunk, in the order they were made
+      size_t size;    // bytes in the chunk, header included
+      char* begin() { return (char*)(this + 1);   }
+      char* end()   { return (char*)this + size;  }
+   };
+
+   void* do_allocate(size_t bytes, size_t alignment) override
+   {
+      char* p = align(pNext, alignment);
+      if (!p || p + bytes > pEnd)
+         p = advance(bytes, alignment);
+      pNext = p + bytes;
+      numUsed += bytes;
+      return p;
+   }
+
+   // individual allocations are never given back
+   void do_deallocate(void* p, size_t bytes, size_t alignment) override
+   {}
+
+   bool do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override
+   {
+      return this == &rhs;
+   }
+
+   static char* align(char* p, size_t alignment)
+   {
+      uintptr_t n = (uintptr_t)p;
+      return (char*)((n + alignment - 1) & ~(uintptr_t)(alignment - 1));
+   }
+
+   char* advance(size_t bytes, size_t alignment);
+
+   std::pmr::memory_resource* upstream;   // where the chunks come from
+   Chunk* pFirst;                         // the oldest chunk
+   Chunk* pCurrent;                       // the chunk we are carving from
+   char* pNext;                           // the next free byte in pCurrent
+   char* pEnd;                            // one past the last byte of pCurrent
+   size_t nextChunk;                      // the size of the next new chunk
+   size_t numUsed;                        // bytes handed out since the last reset
+   size_t numReserved;                    // bytes held from upstream
+};
+
+/************************************************
+ * ARENA :: ADVANCE
+ * The current chunk is full. Move on to the first chunk after it
+ * that is big enough, which after a reset() is usually the very
+ * next one, or get a new one from upstream.
+ ************************************************/
+inline char* arena::advance(size_t bytes, size_t alignment)
+{
+   Chunk* pPrev = pCurrent;
+   for (Chunk* p = pCurrent ? pCurrent->pNext : nullptr; p; p = p->pNext)
+   {
+      pPrev = p;
+      char* pAligned = align(p->begin(), alignment);
+      if (pAligned + bytes <= p->end())
+      {
+         pCurrent = p;
+         pEnd = p->end();
+         return pAligned;
+      }
+   }
+
+   size_t size = sizeof(Chunk) + bytes + alignment;
+   if (size < nextChunk)
+      size = nextChunk;
+   nextChunk *= 2;
+
+   Chunk* pNew = (Chunk*)upstream->allocate(size, alignof(std::max_align_t));
+   pNew->pNext = nullptr;
+   pNew->size = size;
+   numReserved += size;
+   if (pPrev)
+      pPrev->pNext = pNew;
+   else
+      pFirst = pNew;
+
+   pCurrent = pNew;
+   pEnd = pNew->end();
+   return align(pNew->begin(), alignment);
+}
+
+/************************************************
+ * ARENA ALLOCATOR
+ * A standard allocator over an arena. Deallocation does nothing,
+ * which list picks up through is_monotonic. Like the pmr
+ * allocators, construct() hands the allocator on to anything that
+ * takes one, so each bucket list uses the same arena as the set.
+ ************************************************/
+template <typename T>
+class arena_allocator
+{
+public:
+   typedef T value_type;
+   typedef std::true_type is_monotonic;
+
+   arena_allocator(arena* pArena) noexcept : pArena(pArena) {}
+   template <typename U>
+   arena_allocator(const arena_allocator<U>& rhs) noexcept : pArena(rhs.resource()) {}
+
+   T* allocate(size_t num)
+   {
+      return (T*)pArena->allocate(num * sizeof(T), alignof(T));
+   }
+   void deallocate(T* p, size_t num) noexcept
+   {}
+
+   template <typename U, typename ... Args>
+   void construct(U* p, Args&& ... args)
+   {
+      if constexpr (std::uses_allocator<U, arena_allocator>::value &&
+                    std::is_constructible<U, Args..., const arena_allocator&>::value)
+         ::new ((void*)p) U(std::forward<Args>(args)..., *this);
+      else
+         ::new ((void*)p) U(std::forward<Args>(args)...);
+   }
+
+   arena* resource() const noexcept { return pArena; }
+
+private:
+   arena* pArena;
+};
+
+template <typename T, typename U>
+bool operator == (const arena_allocator<T>& lhs, const arena_allocator<U>& rhs) noexcept
+{
+   return lhs.resource() == rhs.resource();
+}
+
+template <typename T, typename U>
+bool operator != (const arena_allocator<T>& lhs, const arena_allocator<U>& rhs) noexcept
+{
+   return !(lhs == rhs);
+}
+
+/************************************************
+ * ARENA UNORDERED SET
+ * A set for the lifetime of one request:
+ *    custom::arena a;
+ *    custom::arena_unordered_set<int> us(&a);
+ *    ...
+ *    a.reset();   // once us is gone, ready for the next request
+ ************************************************/
+template <typename T,
+   typename Hash = std::hash<T>,
+   typename EqPred = std::equal_to<T>>
+using arena_unordered_set = unordered_set<T, Hash, EqPred, arena_allocator<T>>;
+
+} // namespace custom
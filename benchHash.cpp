@@ -0,0 +1,379 @@
+/***********************************************************************
+ * Program:
+ *    BENCH HASH
+ * Summary:
+ *    Time custom::unordered_set against std::unordered_set, operation
+ *    by operation, across key types and sizes, and write the results
+ *    as JSON on stdout. Progress goes to stderr. Build and run:
+ *       make benchHash
+ *       ./benchHash --max 100000000 > results.json
+ *    Sizes go up by powers of ten from --min (10) to --max (1000000
+ *    unless given). --keys picks from int,uint64,str16,str64,spy.
+ *    Each run is made in its own process, so that its peak RSS is
+ *    its own. Linux only: it uses fork() and malloc_usable_size().
+ *    Last comes a memory report: for each key type, at load factors
+ *    of 0.5, 1, 2, and 4, the bytes per element that memory_usage()
+ *    accounts for, part by part, next to what the heap measured.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#include "hash.h"        // for custom::unordered_set
+#include "spy.h"         // for the Spy key type
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <malloc.h>        // for malloc_usable_size
+#include <sys/resource.h>  // for getrusage
+#include <sys/wait.h>      // for waitpid
+#include <unistd.h>        // for fork and pipe
+
+int Spy::counters[] = {};
+
+/**********************************************
+ * HEAP ACCOUNTING
+ * Every global new and delete passes through here, so the bytes a
+ * set holds are the difference in liveBytes across building it.
+ * Counting what malloc actually handed out, rather than what was
+ * asked for, includes the rounding up that malloc does.
+ **********************************************/
+static size_t liveBytes = 0;
+
+void* operator new(size_t num)
+{
+   void* p = malloc(num ? num : 1);
+   if (!p)
+      throw std::bad_alloc();
+   liveBytes += malloc_usable_size(p);
+   return p;
+}
+void operator delete(void* p) noexcept
+{
+   if (p)
+   {
+      liveBytes -= malloc_usable_size(p);
+      free(p);
+   }
+}
+void operator delete(void* p, size_t num) noexcept
+{
+   operator delete(p);
+}
+
+/**********************************************
+ * KEYS
+ * Key number i as each type. Every mapping is one to one, so keys
+ * 0 to n-1 are distinct and none of n to 2n-1 is among them.
+ **********************************************/
+static int intKey(uint64_t i)
+{
+   return (int)(uint32_t)(i * 2654435761u);
+}
+static uint64_t uint64Key(uint64_t i)
+{
+   return i * 0x9E3779B97F4A7C15ull;
+}
+static std::string str16Key(uint64_t i)
+{
+   char buffer[17];
+   snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)uint64Key(i));
+   return std::string(buffer, 16);
+}
+static std::string str64Key(uint64_t i)
+{
+   std::string s = str16Key(i);
+   return s + s + s + s;
+}
+static Spy spyKey(uint64_t i)
+{
+   return Spy(intKey(i));
+}
+
+/**********************************************
+ * NANOSECONDS
+ * Time one call of f
+ **********************************************/
+template <class F>
+double nanoseconds(F f)
+{
+   auto start = std::chrono::steady_clock::now();
+   f();
+   return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static volatile size_t sink;   // keeps the loops from being optimized away
+
+/**********************************************
+ * BENCH
+ * Run every operation on one container type with n keys, repeating
+ * small sizes until about a million operations have been timed, and
+ * return the JSON object for the run
+ **********************************************/
+template <class Set, class K>
+std::string bench(const char* container, const char* keyName, size_t n, K (*makeKey)(uint64_t))
+{
+   std::vector<K> hits;
+   std::vector<K> misses;
+   hits.reserve(n);
+   misses.reserve(n);
+   for (size_t i = 0; i < n; i++)
+   {
+      hits.push_back(makeKey(i));
+      misses.push_back(makeKey(n + i));
+   }
+
+   enum { INSERT, INSERT_RESERVE, FIND_HIT, FIND_MISS, ITERATE, COPY, REHASH, ERASE, DESTROY, NUM_OPS };
+   const char* names[NUM_OPS] = { "insert", "insert_reserve", "find_hit", "find_miss",
+                                  "iterate", "copy", "rehash", "erase", "destroy" };
+   double ns[NUM_OPS] = {};
+   size_t reps = n >= 1000000 ? 1 : 1000000 / n;
+   size_t bytes = 0;
+
+   for (size_t rep = 0; rep < reps; rep++)
+   {
+      size_t before = liveBytes;
+      Set* pSet = new Set;
+      ns[INSERT] += nanoseconds([&] {
+         for (size_t i = 0; i < n; i++)
+            pSet->insert(hits[i]);
+      });
+      if (rep == 0)
+         bytes = liveBytes - before;
+
+      Set* pReserved = new Set;
+      ns[INSERT_RESERVE] += nanoseconds([&] {
+         pReserved->reserve(n);
+         for (size_t i = 0; i < n; i++)
+            pReserved->insert(hits[i]);
+      });
+      delete pReserved;
+
+      ns[FIND_HIT] += nanoseconds([&] {
+         size_t found = 0;
+         for (size_t i = 0; i < n; i++)
+            found += pSet->find(hits[i]) != pSet->end();
+         sink = found;
+      });
+      ns[FIND_MISS] += nanoseconds([&] {
+         size_t found = 0;
+         for (size_t i = 0; i < n; i++)
+            found += pSet->find(misses[i]) != pSet->end();
+         sink = found;
+      });
+      ns[ITERATE] += nanoseconds([&] {
+         size_t count = 0;
+         for (auto it = pSet->begin(); it != pSet->end(); ++it)
+            count++;
+         sink = count;
+      });
+
+      Set* pCopy = nullptr;
+      ns[COPY] += nanoseconds([&] {
+         pCopy = new Set(*pSet);
+      });
+      ns[REHASH] += nanoseconds([&] {
+         pSet->rehash(pSet->bucket_count() * 2);
+      });
+      ns[ERASE] += nanoseconds([&] {
+         for (size_t i = 0; i < n; i++)
+            pSet->erase(hits[i]);
+      });
+      ns[DESTROY] += nanoseconds([&] {
+         delete pCopy;
+      });
+      delete pSet;
+   }
+
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+
+   char buffer[256];
+   std::string json = "    {\"container\": \"";
+   json += container;
+   json += "\", \"key\": \"";
+   json += keyName;
+   snprintf(buffer, sizeof(buffer), "\", \"size\": %zu, \"reps\": %zu,\n     \"ns_per_op\": {", n, reps);
+   json += buffer;
+   for (int op = 0; op < NUM_OPS; op++)
+   {
+      snprintf(buffer, sizeof(buffer), "%s\"%s\": %.2f", op ? ", " : "", names[op], ns[op] / reps / n);
+      json += buffer;
+   }
+   snprintf(buffer, sizeof(buffer), "},\n     \"bytes_per_element\": %.1f, \"peak_rss_kb\": %ld}",
+            (double)bytes / n, (long)usage.ru_maxrss);
+   json += buffer;
+   return json;
+}
+
+/**********************************************
+ * IN CHILD
+ * Run bench() in a child process and return what it printed, or
+ * an empty string if it died, say from running out of memory
+ **********************************************/
+template <class Set, class K>
+std::string inChild(const char* container, const char* keyName, size_t n, K (*makeKey)(uint64_t))
+{
+   int fds[2];
+   if (pipe(fds) != 0)
+      return std::string();
+   fflush(stdout);
+   pid_t pid = fork();
+   if (pid == 0)
+   {
+      close(fds[0]);
+      std::string json = bench<Set, K>(container, keyName, n, makeKey);
+      ssize_t written = write(fds[1], json.data(), json.size());
+      _exit(written == (ssize_t)json.size() ? 0 : 1);
+   }
+   close(fds[1]);
+   std::string json;
+   char buffer[4096];
+   ssize_t num;
+   while ((num = read(fds[0], buffer, sizeof(buffer))) > 0)
+      json.append(buffer, (size_t)num);
+   close(fds[0]);
+   int status = 0;
+   waitpid(pid, &status, 0);
+   return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? json : std::string();
+}
+
+/**********************************************
+ * RUN KEY
+ * Both containers at every size for one key type
+ **********************************************/
+static bool isFirst = true;
+
+template <class K>
+void runKey(const char* keyName, K (*makeKey)(uint64_t), size_t sizeMin, size_t sizeMax)
+{
+   for (size_t n = sizeMin; n <= sizeMax; n *= 10)
+   {
+      std::string results[2];
+      fprintf(stderr, "%-7s %11zu\n", keyName, n);
+      results[0] = inChild<custom::unordered_set<K>, K>("custom::unordered_set", keyName, n, makeKey);
+      results[1] = inChild<std::unordered_set<K>, K>("std::unordered_set", keyName, n, makeKey);
+      for (const std::string& json : results)
+      {
+         if (json.empty())
+         {
+            fprintf(stderr, "   run failed\n");
+            continue;
+         }
+         printf("%s%s", isFirst ? "" : ",\n", json.c_str());
+         isFirst = false;
+      }
+      if (n > sizeMax / 10)
+         break;
+   }
+}
+
+/**********************************************
+ * MEMORY REPORT
+ * Fill a set with n keys at each load factor and return the JSON
+ * objects comparing memory_usage() with the heap. The heap also
+ * counts what a key allocates itself, like the text of a str64,
+ * which memory_usage() leaves out, but not malloc's headers, since
+ * malloc_usable_size() does not; so for int the two differ by the
+ * 8 bytes of a header per node.
+ **********************************************/
+template <class K>
+std::string memoryReport(const char* keyName, K (*makeKey)(uint64_t), size_t n)
+{
+   const float loadFactors[] = { 0.5f, 1.0f, 2.0f, 4.0f };
+   std::string json;
+   char buffer[512];
+   for (float loadFactor : loadFactors)
+   {
+      std::vector<K> keys;
+      keys.reserve(n);
+      for (size_t i = 0; i < n; i++)
+         keys.push_back(makeKey(i));
+
+      size_t before = liveBytes;
+      custom::unordered_set<K>* pSet = new custom::unordered_set<K>;
+      pSet->max_load_factor(loadFactor);
+      for (size_t i = 0; i < n; i++)
+         pSet->insert(keys[i]);
+      size_t heap = liveBytes - before - malloc_usable_size(pSet);
+      custom::unordered_set_memory memory = pSet->memory_usage();
+      size_t numBuckets = pSet->bucket_count();
+      delete pSet;
+
+      before = liveBytes;
+      std::unordered_set<K>* pStd = new std::unordered_set<K>;
+      pStd->max_load_factor(loadFactor);
+      for (size_t i = 0; i < n; i++)
+         pStd->insert(keys[i]);
+      size_t heapStd = liveBytes - before - malloc_usable_size(pStd);
+      delete pStd;
+
+      snprintf(buffer, sizeof(buffer),
+               "%s    {\"key\": \"%s\", \"size\": %zu, \"max_load_factor\": %.1f, \"buckets\": %zu,\n"
+               "     \"bytes_per_element\": {\"bucket_array\": %.1f, \"nodes\": %.1f, \"trees\": %.1f, "
+               "\"allocator_overhead\": %.1f, \"total\": %.1f, \"heap\": %.1f, \"std_heap\": %.1f}}",
+               json.empty() ? "" : ",\n", keyName, n, loadFactor, numBuckets,
+               (double)memory.bucketArray / n, (double)memory.nodes / n, (double)memory.trees / n,
+               (double)memory.allocatorOverhead / n, (double)memory.total() / n,
+               (double)heap / n, (double)heapStd / n);
+      json += buffer;
+   }
+   return json;
+}
+
+/**********************************************
+ * MAIN
+ **********************************************/
+int main(int argc, char** argv)
+{
+   size_t sizeMin = 10;
+   size_t sizeMax = 1000000;
+   std::string keys = "int,uint64,str16,str64,spy";
+   for (int i = 1; i + 1 < argc; i += 2)
+   {
+      if (strcmp(argv[i], "--min") == 0)
+         sizeMin = strtoull(argv[i + 1], nullptr, 10);
+      else if (strcmp(argv[i], "--max") == 0)
+         sizeMax = strtoull(argv[i + 1], nullptr, 10);
+      else if (strcmp(argv[i], "--keys") == 0)
+         keys = argv[i + 1];
+   }
+   if (sizeMin == 0)
+      sizeMin = 1;
+   keys = "," + keys + ",";
+
+   printf("{\n  \"benchmark\": \"unordered_set\",\n  \"results\": [\n");
+   if (keys.find(",int,") != std::string::npos)
+      runKey<int>("int", intKey, sizeMin, sizeMax);
+   if (keys.find(",uint64,") != std::string::npos)
+      runKey<uint64_t>("uint64", uint64Key, sizeMin, sizeMax);
+   if (keys.find(",str16,") != std::string::npos)
+      runKey<std::string>("str16", str16Key, sizeMin, sizeMax);
+   if (keys.find(",str64,") != std::string::npos)
+      runKey<std::string>("str64", str64Key, sizeMin, sizeMax);
+   if (keys.find(",spy,") != std::string::npos)
+      runKey<Spy>("spy", spyKey, sizeMin, sizeMax);
+   printf("\n  ],\n  \"memory\": [\n");
+
+   size_t n = sizeMax < 100000 ? sizeMax : 100000;
+   std::string memory;
+   if (keys.find(",int,") != std::string::npos)
+      memory += memoryReport<int>("int", intKey, n);
+   if (keys.find(",uint64,") != std::string::npos)
+      memory += (memory.empty() ? "" : ",\n") + memoryReport<uint64_t>("uint64", uint64Key, n);
+   if (keys.find(",str16,") != std::string::npos)
+      memory += (memory.empty() ? "" : ",\n") + memoryReport<std::string>("str16", str16Key, n);
+   if (keys.find(",str64,") != std::string::npos)
+      memory += (memory.empty() ? "" : ",\n") + memoryReport<std::string>("str64", str64Key, n);
+   if (keys.find(",spy,") != std::string::npos)
+      memory += (memory.empty() ? "" : ",\n") + memoryReport<Spy>("spy", spyKey, n);
+   printf("%s\n  ]\n}\n", memory.c_str());
+   return 0;
+}
@@ -0,0 +1,168 @@
+/***********************************************************************
+ * Program:
+ *    BENCH HASH FUNC
+ * Summary:
+ *    Compare custom::hash and custom::crc_hash with std::hash, both on
+ *    speed and on how evenly they fill the buckets of an unordered_set.
+ *    Build it with optimizations, and with the instructions the target
+ *    machine has:
+ *       g++ -std=c++17 -O2 -march=native -o benchHashFunc benchHashFunc.cpp
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#include "hash.h"        // for unordered_set
+#include "hashfunc.h"    // the functions being measured
+#include "spy.h"         // for the digit-sum std::hash<Spy>
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int Spy::counters[] = {};
+
+using std::cout;
+using std::endl;
+
+/**********************************************
+ * SPY HASH
+ * custom::hash of the value inside a Spy
+ **********************************************/
+struct SpyHash
+{
+   size_t operator () (const Spy& s) const noexcept
+   {
+      return custom::hash<int>()(s.get());
+   }
+};
+
+/**********************************************
+ * SECONDS SINCE
+ **********************************************/
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**********************************************
+ * BYTES PER SECOND
+ * Hash a buffer of len bytes over and over, as Hash would for a
+ * string_view of that length
+ **********************************************/
+template <typename Hash>
+double bytesPerSecond(const std::string& buffer, size_t len)
+{
+   Hash hash;
+   size_t numHashes = (size_t)200000000 / (len + 16);
+   size_t sink = 0;
+   auto start = std::chrono::steady_clock::now();
+   for (size_t i = 0; i < numHashes; i++)
+      sink += hash(std::string_view(buffer.data() + (i & 7), len));
+   double seconds = secondsSince(start);
+   if (sink == 42)
+      cout << "";   // keep the loop from being optimized away
+   return (double)numHashes * len / seconds;
+}
+
+/**********************************************
+ * NANOSECONDS PER INTEGER
+ **********************************************/
+template <typename Hash>
+double nsPerInteger()
+{
+   Hash hash;
+   const size_t numHashes = 100000000;
+   size_t sink = 0;
+   auto start = std::chrono::steady_clock::now();
+   for (uint64_t i = 0; i < numHashes; i++)
+      sink += hash(i * 0x10001);
+   double seconds = secondsSince(start);
+   if (sink == 42)
+      cout << "";
+   return seconds * 1e9 / numHashes;
+}
+
+/**********************************************
+ * DISTRIBUTION
+ * Fill a set and report how its buckets came out: the longest
+ * chain, the share of empty buckets, and chi-squared over the
+ * number of buckets, which is near 1 for a uniform hash.
+ **********************************************/
+template <typename T, typename Hash>
+void distribution(const char* name, const std::vector<T>& keys)
+{
+   custom::unordered_set<T, Hash> us;
+   for (size_t i = 0; i < keys.size(); i++)
+      us.insert(keys[i]);
+
+   custom::unordered_set_stats stats = us.stats();
+
+   cout << "   " << std::left << std::setw(28) << name << std::right
+        << std::setw(10) << stats.maxProbeHit
+        << std::setw(11) << std::fixed << std::setprecision(1) << 100.0 * stats.numEmpty / stats.numBuckets << "%"
+        << std::setw(12) << std::setprecision(2) << stats.uniformity() << endl;
+}
+
+/**********************************************
+ * MAIN
+ **********************************************/
+int main()
+{
+   std::string buffer(4096 + 8, 'x');
+   for (size_t i = 0; i < buffer.size(); i++)
+      buffer[i] = (char)(i * 131 + 17);
+
+   cout << "String throughput, GB/s\n";
+   cout << "   " << std::setw(8) << "bytes" << std::setw(12) << "std::hash"
+        << std::setw(14) << "custom::hash" << std::setw(12) << "crc_hash" << endl;
+   const size_t lengths[] = { 8, 16, 32, 64, 256, 1024, 4096 };
+   for (size_t len : lengths)
+      cout << "   " << std::setw(8) << len << std::fixed << std::setprecision(2)
+           << std::setw(12) << bytesPerSecond<std::hash<std::string_view>>(buffer, len) / 1e9
+           << std::setw(14) << bytesPerSecond<custom::hash<std::string_view>>(buffer, len) / 1e9
+           << std::setw(12) << bytesPerSecond<custom::crc_hash<std::string_view>>(buffer, len) / 1e9
+           << endl;
+
+   cout << "\nInteger hashing, ns per key\n" << std::setprecision(2)
+        << "   std::hash      " << nsPerInteger<std::hash<uint64_t>>() << "\n"
+        << "   custom::hash   " << nsPerInteger<custom::hash<uint64_t>>() << "\n"
+        << "   crc_hash       " << nsPerInteger<custom::crc_hash<uint64_t>>() << "\n";
+
+   const size_t N = 100000;
+   std::vector<uint64_t> sequential, strided, shifted;
+   std::vector<std::string> words;
+   for (size_t i = 0; i < N; i++)
+   {
+      sequential.push_back(i);
+      strided.push_back(i * 1024);
+      shifted.push_back(i << 32);
+      words.push_back("user-" + std::to_string(i));
+   }
+
+   cout << "\nBucket distribution, " << N << " keys\n";
+   cout << "   " << std::left << std::setw(28) << "keys / hash" << std::right
+        << std::setw(10) << "longest" << std::setw(12) << "empty" << std::setw(12) << "chi2/n" << endl;
+   distribution<uint64_t, std::hash<uint64_t>>        ("sequential / std",     sequential);
+   distribution<uint64_t, custom::hash<uint64_t>>     ("sequential / custom",  sequential);
+   distribution<uint64_t, custom::crc_hash<uint64_t>> ("sequential / crc",     sequential);
+   distribution<uint64_t, std::hash<uint64_t>>        ("stride 1024 / std",    strided);
+   distribution<uint64_t, custom::hash<uint64_t>>     ("stride 1024 / custom", strided);
+   distribution<uint64_t, custom::crc_hash<uint64_t>> ("stride 1024 / crc",    strided);
+   distribution<uint64_t, std::hash<uint64_t>>        ("i << 32 / std",        shifted);
+   distribution<uint64_t, custom::hash<uint64_t>>     ("i << 32 / custom",     shifted);
+   distribution<uint64_t, custom::crc_hash<uint64_t>> ("i << 32 / crc",        shifted);
+   distribution<std::string, std::hash<std::string>>        ("\"user-N\" / std",    words);
+   distribution<std::string, custom::hash<std::string>>     ("\"user-N\" / custom", words);
+   distribution<std::string, custom::crc_hash<std::string>> ("\"user-N\" / crc",    words);
+
+   // Spy keys 0 to 99: the digit sum has only 19 values
+   std::vector<Spy> spies;
+   for (int i = 0; i < 100; i++)
+      spies.push_back(Spy(i));
+   distribution<Spy, std::hash<Spy>>("Spy 0-99 / digit sum", spies);
+   distribution<Spy, SpyHash>       ("Spy 0-99 / custom",    spies);
+   return 0;
+}
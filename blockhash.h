@@ -0,0 +1,456 @@
+/***********************************************************************
+ * Header:
+ *    BLOCK HASH
+ * Summary:
+ *    An unordered set of 32 or 64 bit integers stored in cache-line
+ *    sized blocks that are searched with one SIMD compare
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        block_unordered_set           : A set of integers in 64 byte blocks
+ *        block_unordered_set::iterator : An iterator through the set
+ *
+ *    Chaining spends two pointers and an allocation on every 4 or 8
+ *    byte key. Here a bucket is one 64 byte block holding 16 uint32_t
+ *    or 8 uint64_t keys, and a lookup compares the probe against the
+ *    whole block at once. A full block spills into the next one and
+ *    counts the keys that passed it, so a lookup only moves on when
+ *    one of them is still there.
+ *
+ *    Unlike unordered_set, inserting may move other keys, so every
+ *    insert and erase invalidates iterators.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>      // for uint32_t and uint64_t
+#include <memory>       // for std::allocator
+#include <type_traits>  // for std::is_same
+#include "vector.h"     // because this->blocks is a vector
+#include "pair.h"       // because insert() returns a pair
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>  // for the SSE2 and AVX2 intrinsics
+#define CUSTOM_BLOCK_SSE2
+#endif
+
+class TestBlockHash;    // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * BLOCK UNORDERED SET
+ * A set of uint32_t or uint64_t keys, open addressed by block
+ ************************************************/
+template <typename K, typename A = std::allocator<K>>
+class block_unordered_set
+{
+   static_assert(std::is_same<K, uint32_t>::value || std::is_same<K, uint64_t>::value,
+                 "block_unordered_set holds uint32_t or uint64_t keys");
+   friend class ::TestBlockHash;   // give unit tests access to the privates
+public:
+   static const size_t BLOCK_KEYS = 64 / sizeof(K);   // keys in one block
+
+   //
+   // Construct
+   //
+   block_unordered_set(const A& a = A())
+      : blocks(1, BlockAlloc(a)), counts(1, (uint8_t)0, CountAlloc(a)), overflows(1, (uint8_t)0, CountAlloc(a)),
+        numElements(0), shift(64)
+   {}
+   block_unordered_set(size_t numBlocks, const A& a = A())
+      : blocks(BlockAlloc(a)), counts(CountAlloc(a)), overflows(CountAlloc(a)), numElements(0), shift(64)
+   {
+      allocate(numBlocks);
+   }
+   block_unordered_set(const std::initializer_list<K>& il, const A& a = A())
+      : block_unordered_set(a)
+   {
+      reserve(il.size());
+      for (auto it = il.begin(); it != il.end(); ++it)
+         insert(*it);
+   }
+
+   //
+   // Assign
+   //
+   void swap(block_unordered_set& rhs)
+   {
+      blocks.swap(rhs.blocks);
+      counts.swap(rhs.counts);
+      overflows.swap(rhs.overflows);
+      std::swap(numElements, rhs.numElements);
+      std::swap(shift, rhs.shift);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const
+   {
+      return iterator(this, 0, 0).settle();
+   }
+   iterator end() const
+   {
+      return iterator(this, blocks.size(), 0);
+   }
+
+   //
+   // Access
+   //
+   iterator find(K k) const;
+
+   //
+   // Insert
+   //
+   custom::pair<iterator, bool> insert(K k);
+   void reserve(size_t num)
+   {
+      size_t numBlocks = 1;
+      while (numBlocks * BLOCK_KEYS * 7 / 8 < num)
+         numBlocks *= 2;
+      if (numBlocks > blocks.size())
+         rehash(numBlocks);
+   }
+
+   //
+   // Remove
+   //
+   void clear()
+   {
+      for (size_t i = 0; i < counts.size(); i++)
+         counts[i] = overflows[i] = 0;
+      numElements = 0;
+   }
+   size_t erase(K k);
+
+   //
+   // Status
+   //
+   size_t size()         const { return numElements;      }
+   bool   empty()        const { return numElements == 0; }
+   size_t bucket_count() const { return blocks.size();    }
+   float  load_factor()  const { return (float)numElements / (blocks.size() * BLOCK_KEYS); }
+
+private:
+   // one cache line of keys
+   struct alignas(64) Block
+   {
+      K keys[BLOCK_KEYS];
+   };
+
+   typedef typename std::allocator_traits<A>::template rebind_alloc<Block> BlockAlloc;
+   typedef typename std::allocator_traits<A>::template rebind_alloc<uint8_t> CountAlloc;
+
+   // the high bit of a count: some key meant for this block lives further on
+   static const uint8_t OVERFLOW_BIT = 0x80;
+   static const uint8_t COUNT_MASK = 0x7F;
+   // an overflow count this high is no longer exact, so it stays until a rehash
+   static const uint8_t OVERFLOW_STUCK = 0xFF;
+
+   // Fibonacci hashing: the top bits of the product pick the block
+   size_t home(K k) const
+   {
+      return shift == 64 ? 0 : (size_t)(((uint64_t)k * 0x9E3779B97F4A7C15ull) >> shift);
+   }
+   size_t next(size_t iBlock) const
+   {
+      return (iBlock + 1) & (blocks.size() - 1);
+   }
+
+   static uint32_t match(const Block& block, K k);
+   void allocate(size_t numBlocks);
+   void rehash(size_t numBlocks);
+   void insert_unique(K k);
+   size_t place(K k);
+
+   custom::vector<Block, BlockAlloc> blocks;    // the keys, BLOCK_KEYS to a block
+   custom::vector<uint8_t, CountAlloc> counts;  // keys in each block, and its overflow bit
+   custom::vector<uint8_t, CountAlloc> overflows; // keys that passed each block on the way to theirs
+   size_t numElements;                          // number of keys in the set
+   int shift;                                   // 64 - log2(number of blocks)
+};
+
+/************************************************
+ * BLOCK UNORDERED SET ITERATOR
+ * Walk the blocks in order, and the keys within each block
+ ************************************************/
+template <typename K, typename A>
+class block_unordered_set <K, A> ::iterator
+{
+   friend class ::TestBlockHash;   // give unit tests access to the privates
+   template <typename KK, typename AA>
+   friend class custom::block_unordered_set;
+public:
+   //
+   // Construct
+   //
+   iterator() : pSet(nullptr), iBlock(0), iKey(0) {}
+   iterator(const block_unordered_set* pSet, size_t iBlock, size_t iKey)
+      : pSet(pSet), iBlock(iBlock), iKey(iKey)
+   {}
+
+   //
+   // Compare
+   //
+   bool operator == (const iterator& rhs) const
+   {
+      return iBlock == rhs.iBlock && iKey == rhs.iKey;
+   }
+   bool operator != (const iterator& rhs) const
+   {
+      return !(*this == rhs);
+   }
+
+   //
+   // Access
+   //
+   const K& operator * () const
+   {
+      return pSet->blocks[iBlock].keys[iKey];
+   }
+
+   //
+   // Arithmetic
+   //
+   iterator& operator ++ ()
+   {
+      ++iKey;
+      return settle();
+   }
+   iterator operator ++ (int postfix)
+   {
+      iterator temp(*this);
+      ++(*this);
+      return temp;
+   }
+
+private:
+   // move forward to the first key at or after this spot
+   iterator& settle()
+   {
+      while (iBlock < pSet->blocks.size() && iKey >= (size_t)(pSet->counts[iBlock] & COUNT_MASK))
+      {
+         ++iBlock;
+         iKey = 0;
+      }
+      if (iBlock == pSet->blocks.size())
+         iKey = 0;
+      return *this;
+   }
+
+   const block_unordered_set* pSet;
+   size_t iBlock;
+   size_t iKey;
+};
+
+/*****************************************
+ * BLOCK UNORDERED SET :: MATCH
+ * One bit per slot in the block that holds k. AVX2 takes the block
+ * in two compares, SSE2 in four, and anything else a key at a time.
+ ****************************************/
+template <typename K, typename A>
+uint32_t block_unordered_set<K, A>::match(const Block& block, K k)
+{
+#if defined(__AVX2__)
+   const __m256i* p = (const __m256i*)block.keys;
+   if (sizeof(K) == 4)
+   {
+      __m256i probe = _mm256_set1_epi32((int)k);
+      uint32_t lo = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_load_si256(p),     probe)));
+      uint32_t hi = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_load_si256(p + 1), probe)));
+      return lo | (hi << 8);
+   }
+   else
+   {
+      __m256i probe = _mm256_set1_epi64x((long long)k);
+      uint32_t lo = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_load_si256(p),     probe)));
+      uint32_t hi = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_load_si256(p + 1), probe)));
+      return lo | (hi << 4);
+   }
+#elif defined(CUSTOM_BLOCK_SSE2)
+   const __m128i* p = (const __m128i*)block.keys;
+   uint32_t mask = 0;
+   if (sizeof(K) == 4)
+   {
+      __m128i probe = _mm_set1_epi32((int)k);
+      for (int i = 0; i < 4; i++)
+         mask |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_load_si128(p + i), probe))) << (4 * i);
+   }
+   else
+   {
+      // SSE2 has no 64 bit compare: both 32 bit halves must match
+      __m128i probe = _mm_set1_epi64x((long long)k);
+      for (int i = 0; i < 4; i++)
+      {
+         __m128i eq = _mm_cmpeq_epi32(_mm_load_si128(p + i), probe);
+         eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+         mask |= (uint32_t)_mm_movemask_pd(_mm_castsi128_pd(eq)) << (2 * i);
+      }
+   }
+   return mask;
+#else
+   uint32_t mask = 0;
+   for (size_t i = 0; i < BLOCK_KEYS; i++)
+      if (block.keys[i] == k)
+         mask |= 1u << i;
+   return mask;
+#endif
+}
+
+/*****************************************
+ * BLOCK UNORDERED SET :: FIND
+ * Search the home block, then the blocks it overflowed into
+ ****************************************/
+template <typename K, typename A>
+typename block_unordered_set<K, A>::iterator block_unordered_set<K, A>::find(K k) const
+{
+   size_t iBlock = home(k);
+   for (size_t numProbed = 0; numProbed < blocks.size(); numProbed++)
+   {
+      uint8_t count = counts[iBlock];
+      uint32_t mask = match(blocks[iBlock], k) & ((1u << (count & COUNT_MASK)) - 1);
+      if (mask)
+      {
+         size_t iKey = 0;
+         while (!(mask & 1))
+         {
+            mask >>= 1;
+            iKey++;
+         }
+         return iterator(this, iBlock, iKey);
+      }
+      if (!(count & OVERFLOW_BIT))
+         break;
+      iBlock = next(iBlock);
+   }
+   return end();
+}
+
+/*****************************************
+ * BLOCK UNORDERED SET :: INSERT
+ * Grow if need be, then place k
+ ****************************************/
+template <typename K, typename A>
+custom::pair<typename block_unordered_set<K, A>::iterator, bool> block_unordered_set<K, A>::insert(K k)
+{
+   iterator it = find(k);
+   if (it != end())
+      return custom::pair<iterator, bool>(it, false);
+
+   if ((numElements + 1) * 8 > blocks.size() * BLOCK_KEYS * 7)
+      rehash(blocks.size() * 2);
+
+   size_t iBlock = place(k);
+   size_t iKey = (counts[iBlock] & COUNT_MASK) - 1;
+   numElements++;
+   return custom::pair<iterator, bool>(iterator(this, iBlock, iKey), true);
+}
+
+/*****************************************
+ * BLOCK UNORDERED SET :: ERASE
+ * Fill the hole with the last key of the block. If k had spilled,
+ * the blocks it passed count one key fewer, and a block no key has
+ * passed any more drops its overflow bit, so misses stop there again.
+ * Without that, churn at a steady size would flag block after block
+ * until every miss scanned the whole table.
+ ****************************************/
+template <typename K, typename A>
+size_t block_unordered_set<K, A>::erase(K k)
+{
+   iterator it = find(k);
+   if (it == end())
+      return 0;
+
+   for (size_t iBlock = home(k); iBlock != it.iBlock; iBlock = next(iBlock))
+      if (overflows[iBlock] != OVERFLOW_STUCK && --overflows[iBlock] == 0)
+         counts[iBlock] &= COUNT_MASK;
+
+   size_t iLast = (counts[it.iBlock] & COUNT_MASK) - 1;
+   blocks[it.iBlock].keys[it.iKey] = blocks[it.iBlock].keys[iLast];
+   counts[it.iBlock]--;
+   numElements--;
+   return 1;
+}
+
+/*****************************************
+ * BLOCK UNORDERED SET :: ALLOCATE
+ * Set up numBlocks empty blocks, a power of two
+ ****************************************/
+template <typename K, typename A>
+void block_unordered_set<K, A>::allocate(size_t numBlocks)
+{
+   size_t num = 1;
+   shift = 64;
+   while (num < numBlocks)
+   {
+      num *= 2;
+      shift--;
+   }
+   custom::vector<Block, BlockAlloc> blocksNew(num, blocks.get_allocator());
+   custom::vector<uint8_t, CountAlloc> countsNew(num, (uint8_t)0, counts.get_allocator());
+   custom::vector<uint8_t, CountAlloc> overflowsNew(num, (uint8_t)0, overflows.get_allocator());
+   blocks.swap(blocksNew);
+   counts.swap(countsNew);
+   overflows.swap(overflowsNew);
+}
+
+/*****************************************
+ * BLOCK UNORDERED SET :: REHASH
+ * Move every key into a table of numBlocks blocks
+ ****************************************/
+template <typename K, typename A>
+void block_unordered_set<K, A>::rehash(size_t numBlocks)
+{
+   custom::vector<Block, BlockAlloc> blocksOld(blocks.get_allocator());
+   custom::vector<uint8_t, CountAlloc> countsOld(counts.get_allocator());
+   blocksOld.swap(blocks);
+   countsOld.swap(counts);
+
+   allocate(numBlocks);
+   for (size_t iBlock = 0; iBlock < blocksOld.size(); iBlock++)
+      for (size_t iKey = 0; iKey < (size_t)(countsOld[iBlock] & COUNT_MASK); iKey++)
+         insert_unique(blocksOld[iBlock].keys[iKey]);
+}
+
+/*****************************************
+ * BLOCK UNORDERED SET :: INSERT UNIQUE
+ * Place a key known not to be here, without growing
+ ****************************************/
+template <typename K, typename A>
+void block_unordered_set<K, A>::insert_unique(K k)
+{
+   place(k);
+}
+
+/*****************************************
+ * BLOCK UNORDERED SET :: PLACE
+ * Put k in the first block along its probe sequence with room,
+ * counting it against each full block passed on the way. Return
+ * the block it went in.
+ ****************************************/
+template <typename K, typename A>
+size_t block_unordered_set<K, A>::place(K k)
+{
+   size_t iBlock = home(k);
+   while ((counts[iBlock] & COUNT_MASK) == BLOCK_KEYS)
+   {
+      counts[iBlock] |= OVERFLOW_BIT;
+      if (overflows[iBlock] != OVERFLOW_STUCK)
+         overflows[iBlock]++;
+      iBlock = next(iBlock);
+   }
+   blocks[iBlock].keys[counts[iBlock] & COUNT_MASK] = k;
+   counts[iBlock]++;
+   return iBlock;
+}
+
+} // namespace custom
@@ -0,0 +1,344 @@
+/***********************************************************************
+ * Header:
+ *    CHAIN TREE
+ * Summary:
+ *    A balanced tree over the nodes of one long bucket chain
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        is_ordered   : Does T have an operator < ?
+ *        chain_tree   : An AVL tree of list iterators ordered by (hash, key)
+ *
+ *    The tree does not own the elements. They stay in the bucket's
+ *    list, so iterators, local iterators, and the order of the chain
+ *    are not changed by building or dropping a tree; the tree only
+ *    turns a scan of the chain into a walk down log n nodes.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>      // for size_t
+#include <memory>       // for std::allocator_traits
+#include <type_traits>  // for std::void_t
+#include <utility>      // for std::declval
+
+class TestHash;         // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * IS ORDERED
+ * True when two const T can be compared with <
+ ************************************************/
+template <typename T, typename = void>
+struct is_ordered : std::false_type {};
+
+template <typename T>
+struct is_ordered<T, std::void_t<decltype(std::declval<const T&>() < std::declval<const T&>())>>
+   : std::true_type {};
+
+/************************************************
+ * CHAIN TREE
+ * An AVL tree whose nodes point at the elements of a list. Nodes
+ * are ordered by the full hash first, so most steps compare two
+ * integers, and by operator < on the key only among equal hashes.
+ * The ordering must agree with operator == on T.
+ ************************************************/
+template <typename T, typename Iterator, typename A = std::allocator<T>>
+class chain_tree
+{
+   friend class ::TestHash;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   chain_tree(const A& a = A()) : alloc(a), pRoot(nullptr), numNodes(0) {}
+   chain_tree(chain_tree&& rhs) : alloc(rhs.alloc), pRoot(rhs.pRoot), numNodes(rhs.numNodes)
+   {
+      rhs.pRoot = nullptr;
+      rhs.numNodes = 0;
+   }
+   chain_tree(const chain_tree& rhs) = delete;
+   ~chain_tree()
+   {
+      clear();
+   }
+
+   //
+   // Assign
+   //
+   chain_tree& operator = (chain_tree&& rhs)
+   {
+      clear();
+      std::swap(pRoot, rhs.pRoot);
+      std::swap(numNodes, rhs.numNodes);
+      return *this;
+   }
+   chain_tree& operator = (const chain_tree& rhs) = delete;
+
+   //
+   // Access
+   //
+   Iterator find(size_t hash, const T& t, const Iterator& itEnd) const
+   {
+      for (Node* p = pRoot; p; )
+      {
+         if (less(hash, t, p))
+            p = p->pLeft;
+         else if (greater(hash, t, p))
+            p = p->pRight;
+         else
+            return p->it;
+      }
+      return itEnd;
+   }
+   // the same, adding the nodes compared to numVisited
+   Iterator find(size_t hash, const T& t, const Iterator& itEnd, size_t& numVisited) const
+   {
+      for (Node* p = pRoot; p; )
+      {
+         numVisited++;
+         if (less(hash, t, p))
+            p = p->pLeft;
+         else if (greater(hash, t, p))
+            p = p->pRight;
+         else
+            return p->it;
+      }
+      return itEnd;
+   }
+
+   //
+   // Insert
+   //
+   void insert(size_t hash, const Iterator& it)
+   {
+      Node* pNew = NodeTraits::allocate(alloc, 1);
+      NodeTraits::construct(alloc, pNew, hash, it);
+      pRoot = insert(pRoot, pNew);
+      numNodes++;
+   }
+
+   //
+   // Remove
+   //
+   void erase(size_t hash, const T& t)
+   {
+      pRoot = erase(pRoot, hash, t);
+   }
+   void clear()
+   {
+      clear(pRoot);
+      pRoot = nullptr;
+      numNodes = 0;
+   }
+
+   //
+   // Status
+   //
+   size_t size()   const { return numNodes;       }
+   bool   empty()  const { return numNodes == 0;  }
+   int    height() const { return height(pRoot);  }
+   static size_t node_size() { return sizeof(Node); }   // bytes per element
+
+private:
+   struct Node
+   {
+      Node(size_t hash, const Iterator& it)
+         : hash(hash), it(it), pLeft(nullptr), pRight(nullptr), height(1) {}
+      size_t hash;     // the full hash, before the modulus
+      Iterator it;     // the element, in the bucket's list
+      Node* pLeft;
+      Node* pRight;
+      int height;      // levels in this subtree, 1 for a leaf
+   };
+   typedef typename std::allocator_traits<A>::template rebind_alloc<Node> NodeAlloc;
+   typedef std::allocator_traits<NodeAlloc> NodeTraits;
+
+   // the key a node points at
+   static const T& key(const Node* p)
+   {
+      Iterator it = p->it;
+      return *it;
+   }
+   // does (hash, t) sort before or after the node?
+   static bool less(size_t hash, const T& t, const Node* p)
+   {
+      return hash < p->hash || (hash == p->hash && t < key(p));
+   }
+   static bool greater(size_t hash, const T& t, const Node* p)
+   {
+      return hash > p->hash || (hash == p->hash && key(p) < t);
+   }
+
+   static int height(const Node* p)
+   {
+      return p ? p->height : 0;
+   }
+   static void update(Node* p)
+   {
+      int hLeft = height(p->pLeft);
+      int hRight = height(p->pRight);
+      p->height = (hLeft > hRight ? hLeft : hRight) + 1;
+   }
+   static Node* rotateRight(Node* p);
+   static Node* rotateLeft(Node* p);
+   static Node* balance(Node* p);
+   static Node* insert(Node* p, Node* pNew);
+   static Node* eraseMin(Node* p, Node*& pMin);
+   Node* erase(Node* p, size_t hash, const T& t);
+   void clear(Node* p);
+
+   NodeAlloc alloc;    // every node comes from and goes back to alloc
+   Node* pRoot;        // the top of the tree, nullptr when empty
+   size_t numNodes;    // elements indexed
+};
+
+/*****************************************
+ * CHAIN TREE :: ROTATE RIGHT
+ *       p            l
+ *      / \          / \
+ *     l   c  -->   a   p
+ *    / \              / \
+ *   a   b            b   c
+ ****************************************/
+template <typename T, typename I, typename A>
+typename chain_tree<T, I, A>::Node* chain_tree<T, I, A>::rotateRight(Node* p)
+{
+   Node* pLeft = p->pLeft;
+   p->pLeft = pLeft->pRight;
+   pLeft->pRight = p;
+   update(p);
+   update(pLeft);
+   return pLeft;
+}
+
+/*****************************************
+ * CHAIN TREE :: ROTATE LEFT
+ * The mirror image of rotateRight()
+ ****************************************/
+template <typename T, typename I, typename A>
+typename chain_tree<T, I, A>::Node* chain_tree<T, I, A>::rotateLeft(Node* p)
+{
+   Node* pRight = p->pRight;
+   p->pRight = pRight->pLeft;
+   pRight->pLeft = p;
+   update(p);
+   update(pRight);
+   return pRight;
+}
+
+/*****************************************
+ * CHAIN TREE :: BALANCE
+ * Restore the AVL property at p, whose subtrees differ in height
+ * by at most two, and return the new top of the subtree
+ ****************************************/
+template <typename T, typename I, typename A>
+typename chain_tree<T, I, A>::Node* chain_tree<T, I, A>::balance(Node* p)
+{
+   update(p);
+   int skew = height(p->pLeft) - height(p->pRight);
+   if (skew > 1)
+   {
+      if (height(p->pLeft->pLeft) < height(p->pLeft->pRight))
+         p->pLeft = rotateLeft(p->pLeft);
+      return rotateRight(p);
+   }
+   if (skew < -1)
+   {
+      if (height(p->pRight->pRight) < height(p->pRight->pLeft))
+         p->pRight = rotateRight(p->pRight);
+      return rotateLeft(p);
+   }
+   return p;
+}
+
+/*****************************************
+ * CHAIN TREE :: INSERT
+ * Hang pNew below p and rebalance on the way back up. The set never
+ * inserts a key it already has, so there are no ties to break.
+ ****************************************/
+template <typename T, typename I, typename A>
+typename chain_tree<T, I, A>::Node* chain_tree<T, I, A>::insert(Node* p, Node* pNew)
+{
+   if (!p)
+      return pNew;
+   if (less(pNew->hash, key(pNew), p))
+      p->pLeft = insert(p->pLeft, pNew);
+   else
+      p->pRight = insert(p->pRight, pNew);
+   return balance(p);
+}
+
+/*****************************************
+ * CHAIN TREE :: ERASE MIN
+ * Unhook the leftmost node of the subtree into pMin
+ ****************************************/
+template <typename T, typename I, typename A>
+typename chain_tree<T, I, A>::Node* chain_tree<T, I, A>::eraseMin(Node* p, Node*& pMin)
+{
+   if (!p->pLeft)
+   {
+      pMin = p;
+      return p->pRight;
+   }
+   p->pLeft = eraseMin(p->pLeft, pMin);
+   return balance(p);
+}
+
+/*****************************************
+ * CHAIN TREE :: ERASE
+ * Remove the node for (hash, t), if there is one, replacing it with
+ * the smallest node to its right
+ ****************************************/
+template <typename T, typename I, typename A>
+typename chain_tree<T, I, A>::Node* chain_tree<T, I, A>::erase(Node* p, size_t hash, const T& t)
+{
+   if (!p)
+      return nullptr;
+   if (less(hash, t, p))
+      p->pLeft = erase(p->pLeft, hash, t);
+   else if (greater(hash, t, p))
+      p->pRight = erase(p->pRight, hash, t);
+   else
+   {
+      Node* pLeft = p->pLeft;
+      Node* pRight = p->pRight;
+      NodeTraits::destroy(alloc, p);
+      NodeTraits::deallocate(alloc, p, 1);
+      numNodes--;
+      if (!pRight)
+         return pLeft;
+      Node* pMin = nullptr;
+      pRight = eraseMin(pRight, pMin);
+      pMin->pLeft = pLeft;
+      pMin->pRight = pRight;
+      return balance(pMin);
+   }
+   return balance(p);
+}
+
+/*****************************************
+ * CHAIN TREE :: CLEAR
+ * Free every node below p. The elements are the list's.
+ ****************************************/
+template <typename T, typename I, typename A>
+void chain_tree<T, I, A>::clear(Node* p)
+{
+   if (!p)
+      return;
+   clear(p->pLeft);
+   clear(p->pRight);
+   NodeTraits::destroy(alloc, p);
+   NodeTraits::deallocate(alloc, p, 1);
+}
+
+} // namespace custom
@@ -0,0 +1,190 @@
+/***********************************************************************
+ * Header:
+ *    COUNTERS
+ * Summary:
+ *    Policies that count what an unordered_set does, or do not
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        unordered_set_counters : A plain copy of the counts, to export
+ *        no_counters            : The default, which counts nothing
+ *        relaxed_counters       : Per-set counts of the hot paths
+ *
+ *    Spy counts what the tests do to elements; these count what a
+ *    production set does to itself. Pick one as the fifth template
+ *    argument:
+ *        custom::unordered_set<int, std::hash<int>, std::equal_to<int>,
+ *                              std::allocator<int>, custom::relaxed_counters> us;
+ *        ...
+ *        custom::unordered_set_counters c = us.counters();
+ *    The set derives privately from the policy, so no_counters takes
+ *    no room, and its empty hooks leave no instructions behind.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>    // for std::atomic
+#include <cstddef>   // for size_t
+#include <cstdint>   // for uint64_t
+
+namespace custom
+{
+
+/************************************************
+ * UNORDERED SET COUNTERS
+ * The counts at one moment, as plain integers
+ ************************************************/
+struct unordered_set_counters
+{
+   uint64_t finds = 0;              // calls to find()
+   uint64_t hits = 0;               // finds that found the element
+   uint64_t misses = 0;             // finds that did not
+   uint64_t nodesVisited = 0;       // chain nodes compared by any lookup
+   uint64_t inserts = 0;            // elements added
+   uint64_t duplicateInserts = 0;   // inserts of an element already there
+   uint64_t erases = 0;             // elements removed
+   uint64_t rehashes = 0;           // times the buckets were redrawn
+   uint64_t rehashElements = 0;     // elements moved by all those rehashes
+   uint64_t rehashNanoseconds = 0;  // time spent in them
+};
+
+/************************************************
+ * NO COUNTERS
+ * Every hook does nothing
+ ************************************************/
+struct no_counters
+{
+   static const bool enabled = false;
+
+   void on_find(bool hit)                          const {}
+   void on_visit(size_t numNodes)                  const {}
+   void on_insert(bool inserted)                   const {}
+   void on_erase()                                 const {}
+   void on_rehash(size_t numElements, uint64_t ns) const {}
+
+   unordered_set_counters snapshot() const { return unordered_set_counters(); }
+   void reset() {}
+};
+
+/************************************************
+ * RELAXED COUNTERS
+ * Lookups may run on many threads at once, so their counts are split
+ * into stripes, one cache line each. A thread keeps to one stripe,
+ * picked in turn when it first counts, and bumps it with a relaxed
+ * load and store: no locked add, no fence, and no line bouncing
+ * between readers. snapshot() sums the stripes. With more threads
+ * counting at once than there are stripes, two may share one and a
+ * count can be lost. Inserts, erases, and rehashes already have the
+ * set to themselves, so their counts are bumped the same way in one
+ * place. Counts belong to the set they were made in: copying,
+ * moving, or swapping sets leaves them where they were. The hooks
+ * are const, and the counts mutable, so that a lookup on a const set
+ * counts too.
+ ************************************************/
+class relaxed_counters
+{
+public:
+   static const bool enabled = true;
+   static const size_t NUM_STRIPES = 16;
+
+   relaxed_counters()                                      { reset(); }
+   relaxed_counters(const relaxed_counters& rhs)           { reset(); }
+   relaxed_counters& operator = (const relaxed_counters& rhs) { return *this; }
+
+   void on_find(bool hit) const
+   {
+      Stripe& s = stripes[stripe()];
+      bump(hit ? s.hits : s.misses);
+   }
+   void on_visit(size_t numNodes) const
+   {
+      bump(stripes[stripe()].nodesVisited, numNodes);
+   }
+   void on_insert(bool inserted) const
+   {
+      bump(inserted ? inserts : duplicateInserts);
+   }
+   void on_erase() const
+   {
+      bump(erases);
+   }
+   void on_rehash(size_t numElements, uint64_t ns) const
+   {
+      bump(rehashes);
+      bump(rehashElements, numElements);
+      bump(rehashNanoseconds, ns);
+   }
+
+   unordered_set_counters snapshot() const
+   {
+      unordered_set_counters c;
+      for (const Stripe& s : stripes)
+      {
+         c.hits         += s.hits.load(std::memory_order_relaxed);
+         c.misses       += s.misses.load(std::memory_order_relaxed);
+         c.nodesVisited += s.nodesVisited.load(std::memory_order_relaxed);
+      }
+      c.finds             = c.hits + c.misses;
+      c.inserts           = inserts.load(std::memory_order_relaxed);
+      c.duplicateInserts  = duplicateInserts.load(std::memory_order_relaxed);
+      c.erases            = erases.load(std::memory_order_relaxed);
+      c.rehashes          = rehashes.load(std::memory_order_relaxed);
+      c.rehashElements    = rehashElements.load(std::memory_order_relaxed);
+      c.rehashNanoseconds = rehashNanoseconds.load(std::memory_order_relaxed);
+      return c;
+   }
+   void reset()
+   {
+      for (Stripe& s : stripes)
+      {
+         s.hits.store(0, std::memory_order_relaxed);
+         s.misses.store(0, std::memory_order_relaxed);
+         s.nodesVisited.store(0, std::memory_order_relaxed);
+      }
+      std::atomic<uint64_t>* all[] = { &inserts, &duplicateInserts, &erases,
+         &rehashes, &rehashElements, &rehashNanoseconds };
+      for (std::atomic<uint64_t>* p : all)
+         p->store(0, std::memory_order_relaxed);
+   }
+
+private:
+   // the lookup counts of the threads that share one cache line
+   struct alignas(64) Stripe
+   {
+      std::atomic<uint64_t> hits;
+      std::atomic<uint64_t> misses;
+      std::atomic<uint64_t> nodesVisited;
+   };
+
+   // this thread's stripe, the same in every set
+   static size_t stripe()
+   {
+      static std::atomic<size_t> numThreads(0);
+      thread_local const size_t iStripe =
+         numThreads.fetch_add(1, std::memory_order_relaxed) % NUM_STRIPES;
+      return iStripe;
+   }
+
+   // only one thread bumps a given count at a time, so no locked add
+   static void bump(std::atomic<uint64_t>& count, uint64_t n = 1)
+   {
+      count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+   }
+
+   mutable Stripe stripes[NUM_STRIPES];
+   mutable std::atomic<uint64_t> inserts;
+   mutable std::atomic<uint64_t> duplicateInserts;
+   mutable std::atomic<uint64_t> erases;
+   mutable std::atomic<uint64_t> rehashes;
+   mutable std::atomic<uint64_t> rehashElements;
+   mutable std::atomic<uint64_t> rehashNanoseconds;
+};
+
+} // namespace custom
@@ -13,25 +13,211 @@
  *    This will contain the class definition of:
  *        unordered_set           : A class that represents a hash
  *        unordered_set::iterator : An interator through hash
+ *        unordered_set::const_iterator : The same, through a const hash
+ *        unordered_set_stats     : How the elements are spread over the buckets
+ *        unordered_set_memory    : The heap bytes a set holds
+ *        prehashed               : An element and its hash, worked out already
+ *        ebo_holder              : A Hash or EqPred, taking no room when empty
+ *
+ *    A chain that grows past TREEIFY_THRESHOLD elements, when T has
+ *    an operator <, is indexed by a chain_tree so that finding in it
+ *    takes log n compares rather than n.
+ *
+ *    Every const member only reads the set, so any number of threads
+ *    may call them on one set at once, with no lock, so long as no
+ *    thread calls a non-const member meanwhile. The one thing a const
+ *    lookup writes is the Counters policy, and relaxed_counters keeps
+ *    its counts in atomics.
  * Author
  *    Nathan Bird, Brock Hoskins
  ************************************************************************/
 
 #pragma once
+#ifdef _MSC_VER
 #pragma warning(disable : 4244) // disable warning for conversion from 'size_t' to 'float', possible loss of data
+#endif
 
 #include "list.h"     // because this->buckets[0] is a list
 #include "vector.h"   // because this->buckets is a vector
+#include "pair.h"     // because insert() returns a pair
+#include "snapshot.h" // for save() and load()
+#include "hashfunc.h" // for keyed_hash, when the set is flooded
+#include "chaintree.h" // for chain_tree, over a long chain
+#include "counters.h" // for no_counters and relaxed_counters
+#include "occupancy.h" // for occupancy_bitmap, to skip empty buckets
 #include <memory>     // for std::allocator
 #include <functional> // for std::hash
 #include <cmath>      // for std::ceil
+#include <algorithm>  // for std::min
+#include <memory_resource> // for std::pmr::polymorphic_allocator
+#include <random>     // for std::random_device
+#include <atomic>     // for the seed sequence
+#include <chrono>     // for timing rehashes
+#include <type_traits> // for std::is_empty
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h> // for _mm_prefetch
+#endif
 
 
 class TestHash;             // forward declaration for Hash unit tests
+class TestParallel;         // forward declaration for parallel unit tests
 
 namespace custom
 {
 
+/************************************************
+ * UNORDERED SET STATS
+ * What unordered_set::stats() found on one pass over the buckets.
+ * Probe lengths count the list nodes a scan compares: a find that
+ * hits the k-th element of a chain probes k, and a miss probes the
+ * whole chain. Chains that have a tree are counted the same way,
+ * so the numbers show how the Hash spreads the keys, not what a
+ * tree makes of a bad spread.
+ ************************************************/
+struct unordered_set_stats
+{
+   size_t numElements = 0;
+   size_t numBuckets = 0;
+   size_t numEmpty = 0;                // buckets with no elements
+   custom::vector<size_t> histogram;   // histogram[k] is the number of chains of length k
+   size_t maxProbeHit = 0;             // the longest chain
+   double meanProbeHit = 0.0;          // over every element in the set
+   size_t maxProbeMiss = 0;            // the longest chain, again
+   double meanProbeMiss = 0.0;         // over every bucket, which is the load factor
+   size_t bytesBuckets = 0;            // the bucket array, including spare capacity
+   size_t bytesNodes = 0;              // the list nodes holding the elements
+   size_t bytesTrees = 0;              // the trees over long chains
+   double chiSquared = 0.0;            // near numBuckets when the Hash is uniform
+
+   // chi-squared per bucket: near 1 for a uniform Hash, higher when it clusters
+   double uniformity() const
+   {
+      return numBuckets ? chiSquared / numBuckets : 0.0;
+   }
+};
+
+
+/************************************************
+ * UNORDERED SET MEMORY
+ * The heap bytes behind an unordered_set, as memory_usage() counts
+ * them. Bytes an element owns itself, such as the characters of a
+ * long std::string, are not included.
+ ************************************************/
+struct unordered_set_memory
+{
+   size_t bucketArray = 0;         // the vector of lists, its whole capacity
+   size_t nodes = 0;               // one list node per element
+   size_t trees = 0;               // the chain trees and the vector holding them
+   size_t occupancy = 0;           // the bitmap of buckets that are not empty
+   size_t numAllocations = 0;      // blocks those came in
+   size_t allocatorOverhead = 0;   // an estimate of what the allocator adds to them
+
+   size_t total() const
+   {
+      return bucketArray + nodes + trees + occupancy + allocatorOverhead;
+   }
+};
+
+/************************************************
+ * MALLOC BLOCK SIZE
+ * What a general-purpose malloc, such as glibc's, takes to hand
+ * out n bytes: an 8-byte header, rounded up to 16, at least 32
+ ************************************************/
+inline size_t malloc_block_size(size_t num)
+{
+   size_t size = (num + 8 + 15) & ~(size_t)15;
+   return size < 32 ? 32 : size;
+}
+
+/************************************************
+ * PREFETCH
+ * Start bringing the cache line at p in, without waiting for it
+ ************************************************/
+inline void prefetch(const void* p)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+   _mm_prefetch((const char*)p, _MM_HINT_T0);
+#elif defined(__GNUC__)
+   __builtin_prefetch(p);
+#endif
+}
+
+/************************************************
+ * SET SEED
+ * A seed for one more unordered_set: a random start drawn once per
+ * process, then the next step of a Weyl sequence, mixed. Never 0.
+ ************************************************/
+inline uint64_t set_seed()
+{
+   static std::atomic<uint64_t> next(((uint64_t)std::random_device()() << 32) | std::random_device()());
+   uint64_t seed = mix64(next.fetch_add(0x9e3779b97f4a7c15ull, std::memory_order_relaxed));
+   return seed ? seed : 1;
+}
+
+/************************************************
+ * PREHASHED
+ * An element together with the Hash of it, for a caller that has
+ * already worked the hash out, such as to pick a partition:
+ *    size_t h = std::hash<std::string>()(key);
+ *    partitions[h % numPartitions].insert(custom::prehashed<std::string>(key, h));
+ * hash must be exactly what the set's Hash gives for value, or the
+ * set will look in the wrong bucket. Only the reference is kept.
+ ************************************************/
+template <typename T>
+struct prehashed
+{
+   prehashed(const T& value, size_t hash) : value(value), hash(hash) {}
+   const T& value;
+   size_t hash;
+};
+
+/************************************************
+ * EBO HOLDER
+ * Holds one function object for unordered_set. An empty one, such
+ * as std::hash or std::equal_to, is a base class instead of a member,
+ * so it takes no room at all. Tag tells the Hash holder from the
+ * EqPred holder in case both are the same type.
+ ************************************************/
+#if defined(_MSC_VER)
+#define EMPTY_BASES __declspec(empty_bases)   // MSVC packs only the first empty base without it
+#else
+#define EMPTY_BASES
+#endif
+
+template <typename F, int Tag, bool = std::is_empty<F>::value && !std::is_final<F>::value>
+class ebo_holder
+{
+public:
+   ebo_holder(const F& f = F()) : f(f) {}
+   const F& get() const { return f; }
+   F& get()             { return f; }
+private:
+   F f;
+};
+
+template <typename F, int Tag>
+class ebo_holder<F, Tag, true> : private F
+{
+public:
+   ebo_holder(const F& f = F()) : F(f) {}
+   const F& get() const { return *this; }
+   F& get()             { return *this; }
+};
+
+/************************************************
+ * HASHES KEY
+ * True when Hash and EqPred look only at a key inside the element,
+ * as an unordered_map's do, and compare that key with operator ==.
+ * Such a Hash offers key(), the key of an element or of a bare key,
+ * and get(), the Hash of the key alone.
+ ************************************************/
+template <typename Hash, typename EqPred, typename = void>
+struct hashes_key : std::false_type {};
+
+template <typename Hash, typename EqPred>
+struct hashes_key<Hash, EqPred, std::void_t<typename Hash::key_type, typename EqPred::key_equality>>
+   : std::bool_constant<std::is_same<typename EqPred::key_equality, std::equal_to<typename Hash::key_type>>::value ||
+                        std::is_same<typename EqPred::key_equality, std::equal_to<>>::value> {};
 
 /************************************************
  * UNORDERED SET
@@ -40,30 +226,60 @@ namespace custom
 template <typename T,
    typename Hash = std::hash<T>,
    typename EqPred = std::equal_to<T>,
-   typename A = std::allocator<T> >
-class unordered_set
+   typename A = std::allocator<T>,
+   typename Counters = no_counters >
+class EMPTY_BASES unordered_set : private Counters,
+                                  private ebo_holder<Hash, 0>,
+                                  private ebo_holder<EqPred, 1>
 {
    friend class ::TestHash;   // give unit tests access to the privates
-   template <typename TT, typename HH, typename EE, typename AA>
-   friend void swap(unordered_set<TT,HH,EE,AA>& lhs, unordered_set<TT,HH,EE,AA>& rhs);
+   friend class ::TestParallel;
+   friend struct parallel_access;   // the parallel algorithms, in parallel.h
+   template <typename KK, typename VV, typename HH, typename EE, typename AA, typename CC>
+   friend class unordered_map;      // the map on these buckets, in hashmap.h
+   template <typename TT, typename HH, typename EE, typename AA, typename CC>
+   friend void swap(unordered_set<TT,HH,EE,AA,CC>& lhs, unordered_set<TT,HH,EE,AA,CC>& rhs);
 public:
    //
    // Construct
    //
-   unordered_set() : numElements(0), maxLoadFactor(1.0), buckets(8)
+   unordered_set() : buckets(8), occupied(8), numElements(0), maxLoadFactor(1.0), minLoadFactor(0.0), keyed(false)
+   {}
+   unordered_set(size_t numBuckets) : buckets(numBuckets), occupied(numBuckets), numElements(0), maxLoadFactor(1.0), minLoadFactor(0.0), keyed(false)
+   {}
+   explicit unordered_set(const A& a) : buckets(8, BucketAlloc(a)), occupied(8, WordAlloc(a)), trees(TreeAlloc(a)), numElements(0), maxLoadFactor(1.0), minLoadFactor(0.0), keyed(false)
    {}
-   unordered_set(size_t numBuckets) : numElements(0), maxLoadFactor(1.0), buckets(numBuckets)
+   unordered_set(size_t numBuckets, const A& a) : buckets(numBuckets, BucketAlloc(a)), occupied(numBuckets, WordAlloc(a)), trees(TreeAlloc(a)), numElements(0), maxLoadFactor(1.0), minLoadFactor(0.0), keyed(false)
+   {}
+   unordered_set(size_t numBuckets, const Hash& hash, const EqPred& eq = EqPred(), const A& a = A())
+      : HashHolder(hash), EqualHolder(eq), buckets(numBuckets, BucketAlloc(a)), occupied(numBuckets, WordAlloc(a)),
+        trees(TreeAlloc(a)), numElements(0), maxLoadFactor(1.0), minLoadFactor(0.0), keyed(false)
    {}
    unordered_set(const unordered_set& rhs)
+      : HashHolder(rhs.hasher()), EqualHolder(rhs.equal()),
+        buckets(rhs.bucket_count(), std::allocator_traits<BucketAlloc>::select_on_container_copy_construction(rhs.buckets.get_allocator())),
+        occupied(0, WordAlloc(buckets.get_allocator())), trees(TreeAlloc(buckets.get_allocator()))
    {
-      (*this) = rhs;
+      clone_buckets(rhs, 0, rhs.bucket_count());
+      cloned(rhs);
    }
    unordered_set(unordered_set&& rhs)
+      : HashHolder(std::move(rhs.hasher())), EqualHolder(std::move(rhs.equal())), buckets(std::move(rhs.buckets)),
+        occupied(std::move(rhs.occupied)), trees(std::move(rhs.trees)), numElements(rhs.numElements),
+        maxLoadFactor(rhs.maxLoadFactor), minLoadFactor(rhs.minLoadFactor), keyed(rhs.keyed)
    {
-      (*this) = std::move(rhs);
+      key[0] = rhs.key[0];
+      key[1] = rhs.key[1];
+      seed = rhs.seed;
+      // Return rhs to default state, using the allocator it was given
+      rhs.numElements = 0;
+      rhs.maxLoadFactor = 1.0;
+      rhs.minLoadFactor = 0.0;
+      rhs.keyed = false;
+      rhs.rehash(8);
    }
    template <class Iterator>
-   unordered_set(Iterator first, Iterator last) : numElements(0), maxLoadFactor(1.0), buckets(0)
+   unordered_set(Iterator first, Iterator last) : buckets(0), occupied(0), numElements(0), maxLoadFactor(1.0), minLoadFactor(0.0), keyed(false)
    {
       reserve(last - first);
       for (Iterator it = first; it != last; ++it)
@@ -75,20 +291,44 @@ public:
    //
    unordered_set& operator=(const unordered_set& rhs)
    {
-      numElements = rhs.numElements;
-      maxLoadFactor = rhs.maxLoadFactor;
-      buckets = rhs.buckets;
+      // Clone chain by chain as the copy constructor does, into our own
+      // allocator unless A says to take rhs's, then take the clone.
+      // Elements are built, never assigned, so a T such as
+      // pair<const K, V> works, and the trees come over as they are.
+      if (this != &rhs)
+      {
+         unordered_set copy(rhs.bucket_count(), rhs.hasher(), rhs.equal(),
+            std::allocator_traits<A>::propagate_on_container_copy_assignment::value ? rhs.get_allocator() : get_allocator());
+         copy.clone_buckets(rhs, 0, rhs.bucket_count());
+         copy.cloned(rhs);
+         swap(copy);
+      }
       return *this;
    }
    unordered_set& operator=(unordered_set&& rhs)
    {
+      hasher() =      std::move(rhs.hasher());
+      equal() =       std::move(rhs.equal());
       numElements =   std::move(rhs.numElements);
       maxLoadFactor = std::move(rhs.maxLoadFactor);
+      minLoadFactor = std::move(rhs.minLoadFactor);
+      keyed =         rhs.keyed;
+      key[0] =        rhs.key[0];
+      key[1] =        rhs.key[1];
+      seed =          rhs.seed;
       buckets =       std::move(rhs.buckets);
+      occupied =      std::move(rhs.occupied);
+
+      // The nodes may have been moved one by one, so index them afresh
+      trees.clear();
+      if (!rhs.trees.empty())
+         treeify_all();
       
       // Return rhs to default state
       rhs.numElements = 0;
       rhs.maxLoadFactor = 1.0;
+      rhs.minLoadFactor = 0.0;
+      rhs.keyed = false;
       rhs.rehash(8);
 
       return *this;
@@ -100,28 +340,36 @@ public:
    }
    void swap(unordered_set& rhs)
    {
+      std::swap(hasher(),        rhs.hasher());
+      std::swap(equal(),         rhs.equal());
       std::swap(numElements,     rhs.numElements);
       std::swap(maxLoadFactor,   rhs.maxLoadFactor);
+      std::swap(minLoadFactor,   rhs.minLoadFactor);
+      std::swap(keyed,           rhs.keyed);
+      std::swap(key,             rhs.key);
+      std::swap(seed,            rhs.seed);
       std::swap(buckets,         rhs.buckets);
+      occupied.swap(rhs.occupied);
+      trees.swap(rhs.trees);
    }
 
    // 
    // Iterator
    //
    class iterator;
+   class const_iterator;
    class local_iterator;
+   class const_local_iterator;
    iterator begin()
    {
-      for (auto itBucket = buckets.begin(); itBucket != buckets.end(); ++itBucket)
-      {
-         if (!(*itBucket).empty())
-            return iterator(buckets.end(), itBucket, (*itBucket).begin());
-      }
-      return end();
+      size_t iBucket = occupied.next(0);
+      if (iBucket == bucket_count())
+         return end();
+      return make_iterator(iBucket, buckets[iBucket].begin());
    }
    iterator end()
    {
-      return iterator(buckets.end(), buckets.end(), buckets[0].end());
+      return iterator(buckets.end(), buckets.end(), buckets[0].end(), occupied.data(), occupied.size());
    }
    local_iterator begin(size_t iBucket)
    {
@@ -131,27 +379,72 @@ public:
    {
       return local_iterator(buckets[iBucket].end());
    }
+   const_iterator begin() const
+   {
+      size_t iBucket = occupied.next(0);
+      if (iBucket == bucket_count())
+         return end();
+      return make_const_iterator(iBucket, buckets[iBucket].begin());
+   }
+   const_iterator end() const
+   {
+      const Bucket* pEnd = bucket_array() + bucket_count();
+      return const_iterator(pEnd, pEnd, buckets[0].end(), occupied.data(), occupied.size());
+   }
+   const_iterator cbegin() const { return begin(); }
+   const_iterator cend()   const { return end();   }
+   const_local_iterator begin(size_t iBucket) const
+   {
+      return const_local_iterator(buckets[iBucket].begin());
+   }
+   const_local_iterator end(size_t iBucket) const
+   {
+      return const_local_iterator(buckets[iBucket].end());
+   }
+   const_local_iterator cbegin(size_t iBucket) const { return begin(iBucket); }
+   const_local_iterator cend(size_t iBucket)   const { return end(iBucket);   }
 
    //
    // Access
    //
-   size_t bucket(const T& t)
+   size_t bucket(const T& t) const
    {
-      if (bucket_count() == 0) return 0;
-      return Hash()(t) % bucket_count();
+      return bucket_of(hash(t));
    }
    iterator find(const T& t);
+   const_iterator find(const T& t) const;
+   iterator find(const T& t, size_t h)             { return find_hashed(t, bucket_hash(t, h)); }
+   const_iterator find(const T& t, size_t h) const { return find_hashed(t, bucket_hash(t, h)); }
+   iterator find(const prehashed<T>& p)             { return find(p.value, p.hash); }
+   const_iterator find(const prehashed<T>& p) const { return find(p.value, p.hash); }
 
    //   
    // Insert
    //
-   custom::pair<iterator, bool> insert(const T& t);
+   custom::pair<iterator, bool> insert(const T& t)
+   {
+      return emplace_hashed(t, hash(t), t);
+   }
+   custom::pair<iterator, bool> insert(const T& t, size_t h)
+   {
+      return emplace_hashed(t, bucket_hash(t, h), t);
+   }
+   custom::pair<iterator, bool> insert(const prehashed<T>& p)
+   {
+      return insert(p.value, p.hash);
+   }
    void insert(const std::initializer_list<T>& il);
    void rehash(size_t numBuckets);
    void reserve(size_t num)
    {
       rehash(num / maxLoadFactor);
    }
+   void shrink_to_fit()
+   {
+      size_t numBuckets = min_buckets_fit(numElements);
+      if (numBuckets < bucket_count())
+         rehash_to(numBuckets);
+   }
 
    // 
    // Remove
@@ -162,9 +455,22 @@ public:
       {
          buckets[i].clear();
       }
+      occupied.clear();
+      trees.clear();
+      numElements = 0;
+   }
+   void clear_and_release()
+   {
+      // Dropping the old vector frees every node and the bucket array itself.
+      Buckets newBuckets(8, buckets.get_allocator());
+      std::swap(buckets, newBuckets);
+      occupied.assign(8);
+      trees.clear();
       numElements = 0;
    }
-   iterator erase(const T& t);
+   iterator erase(const T& t)                   { return erase_hashed(t, hash(t)); }
+   iterator erase(const T& t, size_t h)         { return erase_hashed(t, bucket_hash(t, h)); }
+   iterator erase(const prehashed<T>& p)        { return erase(p.value, p.hash); }
 
    //
    // Status
@@ -197,9 +503,80 @@ public:
    {
       maxLoadFactor = m;
    }
+   float min_load_factor() const noexcept
+   {
+      return minLoadFactor;
+   }
+   bool is_keyed() const noexcept
+   {
+      return keyed;
+   }
+   unordered_set_stats stats() const;
+   unordered_set_memory memory_usage() const;
+   unordered_set_counters counters() const
+   {
+      return Counters::snapshot();
+   }
+   void reset_counters()
+   {
+      Counters::reset();
+   }
+   void  min_load_factor(float m)
+   {
+      minLoadFactor = m;
+   }
+   A get_allocator() const
+   {
+      return A(buckets.get_allocator());
+   }
+   Hash hash_function() const
+   {
+      return hasher();
+   }
+   EqPred key_eq() const
+   {
+      return equal();
+   }
+
+   //
+   // Snapshot
+   //
+   void save(std::ostream& out) const
+   {
+      snapshot_ostream_sink sink(out);
+      if (!save(sink))
+         throw "ERROR: unable to write unordered_set snapshot";
+   }
+   void save(int fd) const
+   {
+      snapshot_fd_sink sink(fd);
+      if (!save(sink))
+         throw "ERROR: unable to write unordered_set snapshot";
+   }
+   void load(std::istream& in, bool checkDuplicates = false)
+   {
+      snapshot_istream_source source(in);
+      load(source, checkDuplicates);
+   }
+   void load(int fd, bool checkDuplicates = false)
+   {
+      snapshot_fd_source source(fd);
+      load(source, checkDuplicates);
+   }
 
 private:
 
+   typedef custom::list<T, A> Bucket;
+   typedef typename std::allocator_traits<A>::template rebind_alloc<Bucket> BucketAlloc;
+   typedef custom::vector<Bucket, BucketAlloc> Buckets;
+   typedef typename std::allocator_traits<A>::template rebind_alloc<uint64_t> WordAlloc;
+   typedef occupancy_bitmap<WordAlloc> Occupancy;
+
+   template <class Sink>
+   bool save(Sink& sink) const;
+   template <class Source>
+   void load(Source& source, bool checkDuplicates);
+
    /**
     * Return the minimum number of buckets required to hold num elements.
     * 
@@ -210,9 +587,251 @@ private:
       return num / maxLoadFactor;
    }
 
-   custom::vector<custom::list<T, A>> buckets;  // each bucket in the hash
+   /**
+    * The chain length that means a flood. Chains average the load, so
+    * a set let run at a high max load factor has long ones by chance:
+    * scale FLOOD_THRESHOLD to it.
+    */
+   size_t flood_threshold() const
+   {
+      return maxLoadFactor > 1.0f ? (size_t)(FLOOD_THRESHOLD * std::ceil(maxLoadFactor)) : FLOOD_THRESHOLD;
+   }
+
+   /**
+    * Return the smallest bucket count that holds num elements without
+    * exceeding the max load factor. Never fewer than the default 8.
+    */
+   size_t min_buckets_fit(size_t num) const
+   {
+      size_t numBuckets = (size_t)std::ceil(num / maxLoadFactor);
+      return numBuckets < 8 ? 8 : numBuckets;
+   }
+
+   /**
+    * The hash that picks a bucket: Hash, or SipHash under this set's
+    * own random key once a chain has been flooded. Key is T, or for
+    * an unordered_map, the key its Hash also takes.
+    * Either way, bucket_of() twists it by the set's own seed.
+    */
+   template <class Key>
+   size_t hash(const Key& t) const
+   {
+      if (keyed)
+      {
+         if constexpr (STD_EQUALITY)
+            return (size_t)keyed_hash<Key>()(t, hasher(), key[0], key[1]);
+         else if constexpr (KEY_EQUALITY)
+         {
+            // An element and its bare key share the key's bytes
+            typedef typename Hash::key_type KeyType;
+            return (size_t)keyed_hash<KeyType>()(hasher().key(t), hasher().get(), key[0], key[1]);
+         }
+         else
+         {
+            // Elements EqPred calls equal may differ byte for byte, so
+            // key the Hash of them, which equal elements share.
+            uint64_t h = (uint64_t)hasher()(t);
+            return (size_t)siphash(&h, sizeof(h), key[0], key[1]);
+         }
+      }
+      return hasher()(t);
+   }
+
+   /**
+    * The same, given h, which the caller says is Hash()(t): h itself,
+    * unless the set has switched to SipHash, which no caller can know.
+    */
+   template <class Key>
+   size_t bucket_hash(const Key& t, size_t h) const
+   {
+      return keyed ? hash(t) : h;
+   }
+   /**
+    * h twisted by this set's seed, which is what picks its bucket, so
+    * that keys sharing a bucket in one set are scattered in another,
+    * and no one set's layout tells how another's will fall. A seed
+    * of 0, which set_seed() never draws, leaves h as it is.
+    */
+   size_t seeded(size_t h) const
+   {
+      if (seed == 0)
+         return h;
+      uint64_t x = ((uint64_t)h ^ seed) * 0x9e3779b97f4a7c15ull;
+      return (size_t)(x ^ (x >> 32));
+   }
+   size_t bucket_of(size_t h) const
+   {
+      if (bucket_count() == 0) return 0;
+      return seeded(h) % bucket_count();
+   }
+
+   void rehash_to(size_t numBuckets);
+   void defend();
+
+   /**
+    * An iterator to itList, in bucket iBucket, that skips empty
+    * buckets by the bitmap.
+    */
+   iterator make_iterator(size_t iBucket, const typename Bucket::iterator& itList)
+   {
+      return iterator(buckets.end(), typename Buckets::iterator(iBucket, buckets), itList,
+                      occupied.data(), occupied.size());
+   }
+   const_iterator make_const_iterator(size_t iBucket, const typename Bucket::const_iterator& itList) const
+   {
+      return const_iterator(bucket_array() + bucket_count(), bucket_array() + iBucket, itList,
+                            occupied.data(), occupied.size());
+   }
+   const Bucket* bucket_array() const
+   {
+      return bucket_count() ? &buckets[0] : nullptr;
+   }
+
+   /**
+    * Mark each bucket afresh, for when the buckets were filled without
+    * going through insert().
+    */
+   void remark_occupied()
+   {
+      occupied.assign(buckets.size());
+      for (size_t i = 0; i < buckets.size(); i++)
+         if (!buckets[i].empty())
+            occupied.mark(i);
+   }
+
+   //
+   // Chain trees
+   //
+   typedef chain_tree<T, typename Bucket::iterator, A> ChainTree;
+   struct Tree
+   {
+      Tree(size_t iBucket, const A& a) : iBucket(iBucket), index(a) {}
+      size_t iBucket;                          // the bucket whose chain this indexes
+      ChainTree index;
+   };
+   typedef typename std::allocator_traits<A>::template rebind_alloc<Tree> TreeAlloc;
+
+   /**
+    * Where the tree for iBucket is, or would go, in trees, which is
+    * kept sorted by bucket.
+    */
+   size_t tree_slot(size_t iBucket) const
+   {
+      size_t iLow = 0;
+      size_t iHigh = trees.size();
+      while (iLow < iHigh)
+      {
+         size_t iMiddle = (iLow + iHigh) / 2;
+         if (trees[iMiddle].iBucket < iBucket)
+            iLow = iMiddle + 1;
+         else
+            iHigh = iMiddle;
+      }
+      return iLow;
+   }
+   ChainTree* tree(size_t iBucket)
+   {
+      size_t i = tree_slot(iBucket);
+      return i < trees.size() && trees[i].iBucket == iBucket ? &trees[i].index : nullptr;
+   }
+   const ChainTree* tree(size_t iBucket) const
+   {
+      size_t i = tree_slot(iBucket);
+      return i < trees.size() && trees[i].iBucket == iBucket ? &trees[i].index : nullptr;
+   }
+
+   //
+   // The lookups under find(), insert() and erase(). h is always the
+   // bucket hash, hash(t), worked out once by the caller. Key is T,
+   // or for an unordered_map, its key: the map's Hash and EqPred take
+   // either, so it can look up without building an element.
+   //
+   template <class Key>
+   iterator find_hashed(const Key& t, size_t h);
+   template <class Key>
+   const_iterator find_hashed(const Key& t, size_t h) const;
+   template <class Key, class ... Args>
+   custom::pair<iterator, bool> emplace_hashed(const Key& t, size_t h, Args&& ... args);
+   template <class ... Args>
+   iterator link_hashed(size_t h, Args&& ... args);
+   template <class Key>
+   iterator erase_hashed(const Key& t, size_t h);
+   iterator locate(const T& t)             { return locate(t, hash(t)); }
+   const_iterator locate(const T& t) const { return locate(t, hash(t)); }
+   template <class Key>
+   iterator locate(const Key& t, size_t h);
+   template <class Key>
+   const_iterator locate(const Key& t, size_t h) const;
+   template <class Key>
+   typename Bucket::iterator chain_find(size_t iBucket, const Key& t, size_t h)
+   {
+      return chain_find(*this, iBucket, t, h);
+   }
+   template <class Key>
+   typename Bucket::const_iterator chain_find(size_t iBucket, const Key& t, size_t h) const
+   {
+      return chain_find(*this, iBucket, t, h);
+   }
+   template <class Self, class Key>
+   static auto chain_find(Self& self, size_t iBucket, const Key& t, size_t h) -> decltype(self.buckets[iBucket].begin());
+   void chain_added(size_t iBucket);
+   void chain_erasing(size_t iBucket, const T& t);
+   void treeify(size_t iBucket);
+   void untreeify(size_t iBucket);
+   void treeify_all();
+
+   //
+   // Parallel erase, a range of buckets to a thread
+   //
+   template <class Pred>
+   size_t erase_buckets_if(size_t iBegin, size_t iEnd, Pred& pred);
+   void erased_from_buckets(size_t numErased);
+
+   //
+   // Clone, into a set with as many buckets as rhs, a range at a time
+   //
+   void clone_buckets(const unordered_set& rhs, size_t iBegin, size_t iEnd);
+   void cloned(const unordered_set& rhs);
+
+   //
+   // The function objects, in their ebo_holder bases
+   //
+   typedef ebo_holder<Hash, 0> HashHolder;
+   typedef ebo_holder<EqPred, 1> EqualHolder;
+   const Hash& hasher() const   { return HashHolder::get();  }
+   Hash& hasher()               { return HashHolder::get();  }
+   const EqPred& equal() const  { return EqualHolder::get(); }
+   EqPred& equal()              { return EqualHolder::get(); }
+
+   // A tree orders its chain by operator <, which agrees with operator
+   // == but not necessarily with some other EqPred, so only a set
+   // comparing with operator == may build one.
+   static const bool STD_EQUALITY = std::is_same<EqPred, std::equal_to<T>>::value ||
+                                    std::is_same<EqPred, std::equal_to<>>::value;
+   static const bool TREES = is_ordered<T>::value && STD_EQUALITY;
+
+   // An unordered_map's functors look at the key, which equal elements
+   // share byte for byte when the map's own EqPred is operator ==.
+   static const bool KEY_EQUALITY = hashes_key<Hash, EqPred>::value;
+
+   static const size_t FLOOD_THRESHOLD = 32;   // a chain this long, per unit of max load, is an attack or a broken Hash
+   static const size_t TREEIFY_THRESHOLD = 8;  // a chain this long gets a tree
+   static const size_t UNTREEIFY_THRESHOLD = 6;// a treed chain this short loses it
+   static const size_t CLONE_PREFETCH = 16;    // chains a clone reads ahead
+   static const size_t SNAPSHOT_PRESIZE = 1 << 20; // the most buckets load() makes on a header's word alone
+   static const size_t SNAPSHOT_GROWTH = 8;        // how far load() grows toward the header's table at once
+   static constexpr float MIN_LOAD_FACTOR = 1.0f / 64; // the range load() accepts from a snapshot
+   static constexpr float MAX_LOAD_FACTOR = 16.0f;
+
+   Buckets buckets;                            // each bucket in the hash
+   Occupancy occupied;                         // which buckets are not empty
+   custom::vector<Tree, TreeAlloc> trees;      // the trees over long chains, by bucket
    int numElements;                            // number of elements in the Hash
    float maxLoadFactor;                        // the ratio of elements to buckets signifying a rehash
+   float minLoadFactor;                        // the ratio below which erase() shrinks, 0 for never
+   bool keyed;                                 // has a flood switched us to keyed_hash?
+   uint64_t key[2] = { 0, 0 };                 // the SipHash key, drawn when keyed is set
+   uint64_t seed = set_seed();                 // this set's own twist on bucket_of()
 };
 
 
@@ -220,21 +839,24 @@ private:
  * UNORDERED SET ITERATOR
  * Iterator for an unordered set
  ************************************************/
-template <typename T, typename H, typename E, typename A>
-class unordered_set <T, H, E, A> ::iterator
+template <typename T, typename H, typename E, typename A, typename C>
+class unordered_set <T, H, E, A, C> ::iterator
 {
    friend class ::TestHash;   // give unit tests access to the privates
-   template <typename TT, typename HH, typename EE, typename AA>
+   template <typename TT, typename HH, typename EE, typename AA, typename CC>
    friend class custom::unordered_set;
 public:
    // 
    // Construct
    iterator()
    {}
-   iterator(const typename custom::vector<custom::list<T> >::iterator& itVectorEnd,
-            const typename custom::vector<custom::list<T> >::iterator& itVector,
-            const typename custom::list<T>::iterator& itList)
-      : itVectorEnd(itVectorEnd), itVector(itVector), itList(itList)
+   iterator(const typename Buckets::iterator& itVectorEnd,
+            const typename Buckets::iterator& itVector,
+            const typename Bucket::iterator& itList,
+            const uint64_t* pOccupied = nullptr,
+            size_t numBuckets = 0)
+      : itVectorEnd(itVectorEnd), itList(itList), itVector(itVector),
+        pOccupied(pOccupied), numBuckets(numBuckets)
    {}
    iterator(const iterator& rhs)
    {
@@ -249,6 +871,8 @@ public:
       itVectorEnd = rhs.itVectorEnd;
       itVector = rhs.itVector;
       itList = rhs.itList;
+      pOccupied = rhs.pOccupied;
+      numBuckets = rhs.numBuckets;
       return *this;
    }
 
@@ -286,9 +910,11 @@ public:
    }
 
 private:
-   typename vector<list<T>>::iterator itVectorEnd;
-   typename list<T>::iterator itList;
-   typename vector<list<T>>::iterator itVector;
+   typename Buckets::iterator itVectorEnd;
+   typename Bucket::iterator itList;
+   typename Buckets::iterator itVector;
+   const uint64_t* pOccupied = nullptr;  // the set's occupancy bits, or nullptr to walk
+   size_t numBuckets = 0;                // bits in pOccupied
 };
 
 
@@ -296,12 +922,12 @@ private:
  * UNORDERED SET LOCAL ITERATOR
  * Iterator for a single bucket in an unordered set
  ************************************************/
-template <typename T, typename H, typename E, typename A>
-class unordered_set <T, H, E, A> ::local_iterator
+template <typename T, typename H, typename E, typename A, typename C>
+class unordered_set <T, H, E, A, C> ::local_iterator
 {
    friend class ::TestHash;   // give unit tests access to the privates
 
-   template <typename TT, typename HH, typename EE, typename AA>
+   template <typename TT, typename HH, typename EE, typename AA, typename CC>
    friend class custom::unordered_set;
 public:
    // 
@@ -309,7 +935,7 @@ public:
    //
    local_iterator()
    {}
-   local_iterator(const typename custom::list<T>::iterator& itList)
+   local_iterator(const typename Bucket::iterator& itList)
       : itList(itList)
    {}
    local_iterator(const local_iterator& rhs)
@@ -362,67 +988,251 @@ public:
    }
 
 private:
-   typename list<T>::iterator itList;
+   typename Bucket::iterator itList;
+};
+
+
+/************************************************
+ * UNORDERED SET CONST ITERATOR
+ * Iterator for a const unordered set. An iterator converts to one.
+ ************************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+class unordered_set <T, H, E, A, C> ::const_iterator
+{
+   friend class ::TestHash;   // give unit tests access to the privates
+   template <typename TT, typename HH, typename EE, typename AA, typename CC>
+   friend class custom::unordered_set;
+public:
+   //
+   // Construct
+   //
+   const_iterator()
+   {}
+   const_iterator(const Bucket* pBucketEnd,
+                  const Bucket* pBucket,
+                  const typename Bucket::const_iterator& itList,
+                  const uint64_t* pOccupied = nullptr,
+                  size_t numBuckets = 0)
+      : pBucketEnd(pBucketEnd), pBucket(pBucket), itList(itList),
+        pOccupied(pOccupied), numBuckets(numBuckets)
+   {}
+   const_iterator(const iterator& rhs)
+      : pBucketEnd(&*rhs.itVectorEnd), pBucket(&*rhs.itVector), itList(rhs.itList),
+        pOccupied(rhs.pOccupied), numBuckets(rhs.numBuckets)
+   {}
+
+   //
+   // Compare, either side may be a plain iterator
+   //
+   friend bool operator != (const const_iterator& lhs, const const_iterator& rhs)
+   {
+      return !(lhs == rhs);
+   }
+   friend bool operator == (const const_iterator& lhs, const const_iterator& rhs)
+   {
+      return lhs.pBucket == rhs.pBucket
+         && lhs.pBucketEnd == rhs.pBucketEnd
+         && lhs.itList == rhs.itList;
+   }
+
+   //
+   // Access
+   //
+   const T& operator * () const
+   {
+      return *itList;
+   }
+
+   //
+   // Arithmetic
+   //
+   const_iterator& operator ++ ();
+   const_iterator operator ++ (int postfix)
+   {
+      const_iterator temp(*this);
+      ++(*this);
+      return temp;
+   }
+
+private:
+   const Bucket* pBucketEnd = nullptr;
+   const Bucket* pBucket = nullptr;
+   typename Bucket::const_iterator itList;
+   const uint64_t* pOccupied = nullptr;  // the set's occupancy bits, or nullptr to walk
+   size_t numBuckets = 0;                // bits in pOccupied
+};
+
+
+/************************************************
+ * UNORDERED SET CONST LOCAL ITERATOR
+ * Iterator for a single bucket in a const unordered set
+ ************************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+class unordered_set <T, H, E, A, C> ::const_local_iterator
+{
+   friend class ::TestHash;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   const_local_iterator()
+   {}
+   const_local_iterator(const typename Bucket::const_iterator& itList)
+      : itList(itList)
+   {}
+   const_local_iterator(const local_iterator& rhs)
+      : itList(rhs.itList)
+   {}
+
+   //
+   // Compare
+   //
+   bool operator != (const const_local_iterator& rhs) const
+   {
+      return !(*this == rhs);
+   }
+   bool operator == (const const_local_iterator& rhs) const
+   {
+      return itList == rhs.itList;
+   }
+
+   //
+   // Access
+   //
+   const T& operator * () const
+   {
+      return *itList;
+   }
+
+   //
+   // Arithmetic
+   //
+   const_local_iterator& operator ++ ()
+   {
+      ++itList;
+      return *this;
+   }
+   const_local_iterator operator ++ (int postfix)
+   {
+      const_local_iterator temp(*this);
+      ++(*this);
+      return temp;
+   }
+
+private:
+   typename Bucket::const_iterator itList;
 };
 
 
 /*****************************************
- * UNORDERED SET :: ERASE
+ * UNORDERED SET :: ERASE HASHED
  * Remove one element from the unordered set
  ****************************************/
-template <typename T, typename Hash, typename E, typename A>
-typename unordered_set <T, Hash, E, A> ::iterator unordered_set<T, Hash, E, A>::erase(const T& t)
+template <typename T, typename Hash, typename E, typename A, typename C>
+template <class Key>
+typename unordered_set <T, Hash, E, A, C> ::iterator unordered_set<T, Hash, E, A, C>::erase_hashed(const Key& t, size_t h)
 {
-   iterator itErase = find(t);
+   iterator itErase = locate(t, h);
    if (itErase == end())
       return itErase;
 
+   // Shrink before unlinking so the returned iterator stays valid. Aim
+   // for half the max load factor so that a few inserts do not grow the
+   // table right back. The min load factor counts for no more than a
+   // quarter of the max, so the shrunk table sits well above it, and
+   // it takes half the elements going before the next shrink.
+   float shrinkLoadFactor = std::min(minLoadFactor, maxLoadFactor / 4);
+   if (shrinkLoadFactor > 0.0 && bucket_count() > 8 &&
+       (float)(numElements - 1) < shrinkLoadFactor * bucket_count())
+   {
+      size_t numBuckets = min_buckets_fit(2 * (numElements - 1));
+      if (numBuckets < bucket_count())
+      {
+         rehash_to(numBuckets);
+         itErase = locate(t, h);
+      }
+   }
+
    iterator itReturn = itErase;
    itReturn++;
 
+   size_t iBucket = &*itErase.itVector - &buckets[0];
+   chain_erasing(iBucket, *itErase);
    (*itErase.itVector).erase(itErase.itList);
    numElements--;
+   if (buckets[iBucket].empty())
+      occupied.unmark(iBucket);
+   if (buckets[iBucket].size() < UNTREEIFY_THRESHOLD)
+      untreeify(iBucket);
+   this->on_erase();
    return itReturn;
 }
 
 /*****************************************
- * UNORDERED SET :: INSERT
- * Insert one element into the hash
+ * UNORDERED SET :: EMPLACE HASHED
+ * Insert one element into the hash. This is the one find-or-insert:
+ * it walks the chain once, and the hash is never worked out again,
+ * not even after growing the table. The new element is built from
+ * args in its node, and only when t is not already there.
  ****************************************/
-template <typename T, typename H, typename E, typename A>
-custom::pair<typename custom::unordered_set<T, H, E, A>::iterator, bool> unordered_set<T, H, E, A>::insert(const T& t)
+template <typename T, typename H, typename E, typename A, typename C>
+template <class Key, class ... Args>
+custom::pair<typename custom::unordered_set<T, H, E, A, C>::iterator, bool> unordered_set<T, H, E, A, C>::emplace_hashed(const Key& t, size_t h, Args&& ... args)
 {
    // 1. Find the bucket where the new element is to reside.
-   size_t iBucket = bucket(t);
+   size_t iBucket = bucket_of(h);
 
    // 2. If the bucket is empty, add the new element.
-   for (typename list<T>::iterator it = buckets[iBucket].begin(); it != buckets[iBucket].end(); ++it)
+   typename Bucket::iterator it = chain_find(iBucket, t, h);
+   if (it != buckets[iBucket].end())
    {
-      if (*it == t)
-         return custom::pair<custom::unordered_set<T, H, E, A>::iterator, bool>(iterator(buckets.end(), vector<list<T>>::iterator(iBucket, buckets), it), false);
+      this->on_insert(false);
+      return custom::pair<custom::unordered_set<T, H, E, A, C>::iterator, bool>(make_iterator(iBucket, it), false);
    }
 
-   // 3. Reserve more space if we are already at the limit.
+   // 3. It is not there, so link it in.
+   return custom::pair<custom::unordered_set<T, H, E, A, C>::iterator, bool>(link_hashed(h, std::forward<Args>(args)...), true);
+}
+
+/*****************************************
+ * UNORDERED SET :: LINK HASHED
+ * Add an element the caller knows is not there, built from args in
+ * its node, whose bucket hash is h. No chain is walked.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+template <class ... Args>
+typename unordered_set<T, H, E, A, C>::iterator unordered_set<T, H, E, A, C>::link_hashed(size_t h, Args&& ... args)
+{
+   // 1. Reserve more space if we are already at the limit.
    if (min_buckets_required(numElements + 1) > bucket_count())
-   {
       reserve(numElements * 2);
-      iBucket = bucket(t);
-   }
-
-   // 4. Insert the new element on the back of the bucket if it's not there already.
-   if (list_find(buckets[iBucket], t) != buckets[iBucket].end())
-      return custom::pair<custom::unordered_set<T, H, E, A>::iterator, bool>(end(), false);
+   size_t iBucket = bucket_of(h);
 
-   buckets[iBucket].push_back(t);
+   // 2. Insert the new element on the back of the bucket. A rehash
+   //    never makes a duplicate, so there is no need to look again.
+   buckets[iBucket].emplace_back(std::forward<Args>(args)...);
+   typename Bucket::iterator itNew = buckets[iBucket].rbegin();
+   occupied.mark(iBucket);
    numElements++;
+   chain_added(iBucket);
+   this->on_insert(true);
+
+   // 3. A chain this long does not happen by chance: switch hashes.
+   //    The rehash relinks the nodes, so itNew is still good. The key
+   //    may have been moved into the node, so hash the node instead.
+   if (buckets[iBucket].size() > FLOOD_THRESHOLD && !keyed &&
+       buckets[iBucket].size() > flood_threshold())
+   {
+      defend();
+      iBucket = bucket_of(hash(*itNew));
+   }
 
-   // 5. Return the iterator to the new element.
-   iterator itReturn(buckets.end(), typename vector<list<T>>::iterator(iBucket, buckets), list_find(buckets[iBucket], t));
-   return custom::pair<custom::unordered_set<T, H, E, A>::iterator, bool>(itReturn, true);
+   // 4. Return the iterator to the new element.
+   return make_iterator(iBucket, itNew);
 }
 
-template <typename T, typename H, typename E, typename A>
-void unordered_set<T, H, E, A>::insert(const std::initializer_list<T>& il)
+template <typename T, typename H, typename E, typename A, typename C>
+void unordered_set<T, H, E, A, C>::insert(const std::initializer_list<T>& il)
 {
    for (auto it = il.begin(); it != il.end(); ++it)
       insert(*it);
@@ -432,39 +1242,89 @@ void unordered_set<T, H, E, A>::insert(const std::initializer_list<T>& il)
  * UNORDERED SET :: REHASH
  * Re-Hash the unordered set by numBuckets
  ****************************************/
-template <typename T, typename Hash, typename E, typename A>
-void unordered_set<T, Hash, E, A>::rehash(size_t numBuckets)
+template <typename T, typename Hash, typename E, typename A, typename C>
+void unordered_set<T, Hash, E, A, C>::rehash(size_t numBuckets)
 {
    // If the current bucket count is sufficient, nothing to do.
    if (numBuckets <= bucket_count())
       return;
 
+   rehash_to(numBuckets);
+}
+
+/*****************************************
+ * UNORDERED SET :: REHASH TO
+ * Re-Hash into exactly numBuckets, growing or shrinking
+ ****************************************/
+template <typename T, typename Hash, typename E, typename A, typename C>
+void unordered_set<T, Hash, E, A, C>::rehash_to(size_t numBuckets)
+{
+   std::chrono::steady_clock::time_point start;
+   if constexpr (C::enabled)
+      start = std::chrono::steady_clock::now();
+
    // Create a new vector with the new number of buckets
-   vector<list<T, A>> newBuckets(numBuckets);
+   Buckets newBuckets(numBuckets, buckets.get_allocator());
+   Occupancy newOccupied(numBuckets, WordAlloc(buckets.get_allocator()));
 
-   // Move all elements from the old buckets to the new buckets.
+   // Relink every node into its new bucket. The elements themselves
+   // are never copied, moved, or reallocated, so pointers to them
+   // stay good.
    for (auto itBucket = buckets.begin(); itBucket != buckets.end(); ++itBucket)
    {
-      for (auto itList = (*itBucket).begin(); itList != (*itBucket).end(); ++itList)
+      while (!(*itBucket).empty())
       {
-         size_t iBucket = Hash()(*itList) % numBuckets;
-         newBuckets[iBucket].push_back(std::move(*itList));
+         typename Bucket::iterator itList = (*itBucket).begin();
+         size_t iBucket = seeded(hash(*itList)) % numBuckets;
+         newBuckets[iBucket].splice_back(*itBucket, itList);
+         newOccupied.mark(iBucket);
       }
    }
 
    // Swap the new buckets with the old buckets.
    std::swap(buckets, newBuckets);
+   occupied.swap(newOccupied);
+   treeify_all();
+
+   if constexpr (C::enabled)
+      this->on_rehash(numElements, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now() - start).count());
+}
+
+/*****************************************
+ * UNORDERED SET :: DEFEND
+ * A chain passed flood_threshold(). With a decent Hash and the load
+ * kept under the max, that is astronomically unlikely by chance, so
+ * someone chose keys that collide. Draw a key they cannot know and
+ * rehash everything with SipHash under it. This happens at most once
+ * in the life of a set.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+void unordered_set<T, H, E, A, C>::defend()
+{
+   std::random_device random;
+   key[0] = ((uint64_t)random() << 32) | random();
+   key[1] = ((uint64_t)random() << 32) | random();
+   keyed = true;
+   rehash_to(bucket_count());
 }
 
 /*****************************************
  * ITERATOR :: LIST FIND
- * Find an element in a list
+ * Find an element in a list, comparing with eq
  ****************************************/
-template <typename T>
-typename list<T>::iterator list_find(list<T>& list, const T& t)
+template <typename T, typename A, typename Key, typename EqPred>
+typename list<T, A>::iterator list_find(list<T, A>& list, const Key& t, const EqPred& eq)
+{
+   for (auto it = list.begin(); it != list.end(); ++it)
+      if (eq(*it, t)) return it;
+   return list.end();
+}
+template <typename T, typename A, typename Key, typename EqPred>
+typename list<T, A>::const_iterator list_find(const list<T, A>& list, const Key& t, const EqPred& eq)
 {
    for (auto it = list.begin(); it != list.end(); ++it)
-      if (*it == t) return it;
+      if (eq(*it, t)) return it;
    return list.end();
 }
 
@@ -472,26 +1332,310 @@ typename list<T>::iterator list_find(list<T>& list, const T& t)
  * UNORDERED SET :: FIND
  * Find an element in an unordered set
  ****************************************/
-template <typename T, typename H, typename E, typename A>
-typename unordered_set <T, H, E, A> ::iterator unordered_set<T, H, E, A>::find(const T& t)
+template <typename T, typename H, typename E, typename A, typename C>
+typename unordered_set <T, H, E, A, C> ::iterator unordered_set<T, H, E, A, C>::find(const T& t)
+{
+   return find_hashed(t, hash(t));
+}
+
+template <typename T, typename H, typename E, typename A, typename C>
+typename unordered_set <T, H, E, A, C> ::const_iterator unordered_set<T, H, E, A, C>::find(const T& t) const
 {
-   size_t iBucket = bucket(t);
+   return find_hashed(t, hash(t));
+}
 
-   typename list<T>::iterator itList = list_find(buckets[iBucket], t);
+template <typename T, typename H, typename E, typename A, typename C>
+template <class Key>
+typename unordered_set <T, H, E, A, C> ::iterator unordered_set<T, H, E, A, C>::find_hashed(const Key& t, size_t h)
+{
+   iterator it = locate(t, h);
+   this->on_find(it != end());
+   return it;
+}
+
+template <typename T, typename H, typename E, typename A, typename C>
+template <class Key>
+typename unordered_set <T, H, E, A, C> ::const_iterator unordered_set<T, H, E, A, C>::find_hashed(const Key& t, size_t h) const
+{
+   const_iterator it = locate(t, h);
+   this->on_find(it != end());
+   return it;
+}
+
+/*****************************************
+ * UNORDERED SET :: LOCATE
+ * Find, without counting it as one
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+template <class Key>
+typename unordered_set <T, H, E, A, C> ::iterator unordered_set<T, H, E, A, C>::locate(const Key& t, size_t h)
+{
+   size_t iBucket = bucket_of(h);
+
+   typename Bucket::iterator itList = chain_find(iBucket, t, h);
    
    if (itList != buckets[iBucket].end())
-     return iterator(buckets.end(), vector<list<T>>::iterator(iBucket, buckets), itList);
+     return make_iterator(iBucket, itList);
    else
      return end();
    return end();
 }
 
+template <typename T, typename H, typename E, typename A, typename C>
+template <class Key>
+typename unordered_set <T, H, E, A, C> ::const_iterator unordered_set<T, H, E, A, C>::locate(const Key& t, size_t h) const
+{
+   size_t iBucket = bucket_of(h);
+   typename Bucket::const_iterator itList = chain_find(iBucket, t, h);
+   if (itList != buckets[iBucket].end())
+      return make_const_iterator(iBucket, itList);
+   return end();
+}
+
+/*****************************************
+ * UNORDERED SET :: CHAIN FIND
+ * Find an element in one bucket, down its tree if it has one. Self
+ * is the set, const or not, so that one body serves both: the list
+ * iterator it returns is const exactly when the set is. The tree
+ * holds plain iterators, and the end of every list is a null one.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+template <class Self, class Key>
+auto unordered_set<T, H, E, A, C>::chain_find(Self& self, size_t iBucket, const Key& t, size_t h) -> decltype(self.buckets[iBucket].begin())
+{
+   auto& bucket = self.buckets[iBucket];
+   if constexpr (TREES && std::is_same<Key, T>::value)
+   {
+      if (bucket.size() >= TREEIFY_THRESHOLD)
+         if (auto* pTree = self.tree(iBucket))
+         {
+            if constexpr (C::enabled)
+            {
+               size_t numVisited = 0;
+               typename Bucket::iterator it = pTree->find(h, t, typename Bucket::iterator(), numVisited);
+               self.on_visit(numVisited);
+               return it;
+            }
+            else
+               return pTree->find(h, t, typename Bucket::iterator());
+         }
+   }
+   if constexpr (C::enabled)
+   {
+      // the same scan as list_find(), counting as it goes
+      size_t numVisited = 0;
+      for (auto it = bucket.begin(); it != bucket.end(); ++it)
+      {
+         numVisited++;
+         if (self.equal()(*it, t))
+         {
+            self.on_visit(numVisited);
+            return it;
+         }
+      }
+      self.on_visit(numVisited);
+      return bucket.end();
+   }
+   else
+      return list_find(bucket, t, self.equal());
+}
+
+/*****************************************
+ * UNORDERED SET :: CHAIN ADDED
+ * An element was just pushed on the back of a bucket: index it, or
+ * build the tree if the chain has just become long enough. A tree
+ * lives on until its chain is shorter than UNTREEIFY_THRESHOLD, so
+ * one may be there below TREEIFY_THRESHOLD too, and it must still
+ * be told, or it will be missing the node once the chain is long
+ * enough to be searched through the tree again.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+void unordered_set<T, H, E, A, C>::chain_added(size_t iBucket)
+{
+   if constexpr (TREES)
+   {
+      if (ChainTree* pTree = tree(iBucket))
+         pTree->insert(hash(buckets[iBucket].back()), buckets[iBucket].rbegin());
+      else if (buckets[iBucket].size() >= TREEIFY_THRESHOLD)
+         treeify(iBucket);
+   }
+}
+
+/*****************************************
+ * UNORDERED SET :: CHAIN ERASING
+ * t is about to be unlinked from its bucket, so drop it from the
+ * tree while its node can still be read
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+void unordered_set<T, H, E, A, C>::chain_erasing(size_t iBucket, const T& t)
+{
+   if constexpr (TREES)
+   {
+      if (ChainTree* pTree = tree(iBucket))
+         pTree->erase(hash(t), t);
+   }
+}
+
+/*****************************************
+ * UNORDERED SET :: TREEIFY
+ * Build a tree over every element of one bucket
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+void unordered_set<T, H, E, A, C>::treeify(size_t iBucket)
+{
+   if constexpr (TREES)
+   {
+      // slide the new tree down into place, keeping trees sorted
+      size_t iTree = tree_slot(iBucket);
+      trees.push_back(Tree(iBucket, A(buckets.get_allocator())));
+      for (size_t i = trees.size() - 1; i > iTree; i--)
+         std::swap(trees[i], trees[i - 1]);
+
+      for (auto it = buckets[iBucket].begin(); it != buckets[iBucket].end(); ++it)
+         trees[iTree].index.insert(hash(*it), it);
+   }
+}
+
+/*****************************************
+ * UNORDERED SET :: UNTREEIFY
+ * The chain is short again: a scan beats the tree
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+void unordered_set<T, H, E, A, C>::untreeify(size_t iBucket)
+{
+   size_t iTree = tree_slot(iBucket);
+   if (iTree == trees.size() || trees[iTree].iBucket != iBucket)
+      return;
+   for (size_t i = iTree; i + 1 < trees.size(); i++)
+      trees[i] = std::move(trees[i + 1]);
+   trees.pop_back();
+}
+
+/*****************************************
+ * UNORDERED SET :: ERASE BUCKETS IF
+ * Erase every element of buckets [iBegin, iEnd) that pred accepts,
+ * and return how many. Only those buckets, their trees, and their
+ * words of the bitmap are touched, so threads given ranges that
+ * start and end on multiples of 64 never touch the same memory. The
+ * count and the trees vector are left to erased_from_buckets().
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+template <class Pred>
+size_t unordered_set<T, H, E, A, C>::erase_buckets_if(size_t iBegin, size_t iEnd, Pred& pred)
+{
+   size_t numErased = 0;
+   for (size_t i = occupied.next(iBegin, iEnd); i < iEnd; i = occupied.next(i + 1, iEnd))
+   {
+      Bucket& bucket = buckets[i];
+      for (typename Bucket::iterator it = bucket.begin(); it != bucket.end(); )
+      {
+         const T& t = *it;
+         if (pred(t))
+         {
+            chain_erasing(i, t);
+            it = bucket.erase(it);
+            numErased++;
+            this->on_erase();
+         }
+         else
+            ++it;
+      }
+      if (bucket.empty())
+         occupied.unmark(i);
+   }
+   return numErased;
+}
+
+/*****************************************
+ * UNORDERED SET :: ERASED FROM BUCKETS
+ * Back on one thread: take the erased elements off the count and
+ * drop the trees whose chains have grown short
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+void unordered_set<T, H, E, A, C>::erased_from_buckets(size_t numErased)
+{
+   numElements -= (int)numErased;
+   for (size_t i = trees.size(); i-- > 0; )
+      if (buckets[trees[i].iBucket].size() < UNTREEIFY_THRESHOLD)
+         untreeify(trees[i].iBucket);
+}
+
+/*****************************************
+ * UNORDERED SET :: CLONE BUCKETS
+ * Copy the chains of buckets [iBegin, iEnd) of rhs into the same
+ * buckets here, which must be empty. Going bucket by bucket, and
+ * skipping the empty ones by the bitmap, the nodes are allocated in
+ * the order a scan will visit them, so a fresh heap lays them out
+ * side by side. rhs's nodes are wherever its inserts left them, so
+ * reading them is what costs: keep CLONE_PREFETCH chains' first
+ * nodes on their way in. Like erase_buckets_if(), touches only
+ * those buckets.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+void unordered_set<T, H, E, A, C>::clone_buckets(const unordered_set& rhs, size_t iBegin, size_t iEnd)
+{
+   size_t iAhead = rhs.occupied.next(iBegin, iEnd);
+   for (size_t k = 0; k < CLONE_PREFETCH && iAhead < iEnd; k++)
+      iAhead = rhs.occupied.next(iAhead + 1, iEnd);
+
+   for (size_t i = rhs.occupied.next(iBegin, iEnd); i < iEnd; i = rhs.occupied.next(i + 1, iEnd))
+   {
+      if (iAhead < iEnd)
+      {
+         prefetch(&*rhs.buckets[iAhead].begin());
+         iAhead = rhs.occupied.next(iAhead + 1, iEnd);
+      }
+      const Bucket& bucketFrom = rhs.buckets[i];
+      Bucket& bucketTo = buckets[i];
+      for (typename Bucket::const_iterator it = bucketFrom.begin(); it != bucketFrom.end(); ++it)
+         bucketTo.push_back(*it);
+   }
+}
+
+/*****************************************
+ * UNORDERED SET :: CLONED
+ * Back on one thread: every chain of rhs has been copied, so take
+ * its settings and bitmap, and build the trees that rhs has
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+void unordered_set<T, H, E, A, C>::cloned(const unordered_set& rhs)
+{
+   numElements = rhs.numElements;
+   maxLoadFactor = rhs.maxLoadFactor;
+   minLoadFactor = rhs.minLoadFactor;
+   keyed = rhs.keyed;
+   key[0] = rhs.key[0];
+   key[1] = rhs.key[1];
+   seed = rhs.seed;
+   occupied = rhs.occupied;
+   trees.clear();
+   for (size_t i = 0; i < rhs.trees.size(); i++)
+      treeify(rhs.trees[i].iBucket);
+}
+
+/*****************************************
+ * UNORDERED SET :: TREEIFY ALL
+ * Throw the trees away and build one for every long chain. Called
+ * whenever the nodes have moved or the buckets were redrawn.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+void unordered_set<T, H, E, A, C>::treeify_all()
+{
+   trees.clear();
+   if constexpr (TREES)
+   {
+      for (size_t i = 0; i < buckets.size(); i++)
+         if (buckets[i].size() >= TREEIFY_THRESHOLD)
+            treeify(i);
+   }
+}
+
 /*****************************************
  * UNORDERED SET :: ITERATOR :: INCREMENT
  * Advance by one element in an unordered set
  ****************************************/
-template <typename T, typename H, typename E, typename A>
-typename unordered_set <T, H, E, A> ::iterator& unordered_set<T, H, E, A>::iterator::operator ++ ()
+template <typename T, typename H, typename E, typename A, typename C>
+typename unordered_set <T, H, E, A, C> ::iterator& unordered_set<T, H, E, A, C>::iterator::operator ++ ()
 {
    // 1. Only advance if not already at end
    if (itVector == itVectorEnd)
@@ -503,10 +1647,21 @@ typename unordered_set <T, H, E, A> ::iterator& unordered_set<T, H, E, A>::itera
    if (itList != (*itVector).end())
       return *this;
 
-   // 3. We are at the end of the list. Find next non-empty bucket
-   ++itVector;
-   while (itVector != itVectorEnd && (*itVector).empty())
+   // 3. We are at the end of the list. Find next non-empty bucket,
+   //    by the bitmap when we have one, or else one bucket at a time.
+   if (pOccupied)
+   {
+      Bucket* pEnd = &*itVectorEnd;
+      size_t iBucket = numBuckets - (pEnd - &*itVector);
+      size_t iNext = Occupancy::next(pOccupied, numBuckets, iBucket + 1);
+      itVector = typename Buckets::iterator(pEnd - (numBuckets - iNext));
+   }
+   else
+   {
       ++itVector;
+      while (itVector != itVectorEnd && (*itVector).empty())
+         ++itVector;
+   }
 
    if (itVector != itVectorEnd)
       itList = (*itVector).begin();
@@ -514,17 +1669,232 @@ typename unordered_set <T, H, E, A> ::iterator& unordered_set<T, H, E, A>::itera
    return *this;
 }
 
+/*****************************************
+ * UNORDERED SET :: CONST ITERATOR :: INCREMENT
+ * The same walk as the iterator's, over const buckets
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+typename unordered_set <T, H, E, A, C> ::const_iterator& unordered_set<T, H, E, A, C>::const_iterator::operator ++ ()
+{
+   if (pBucket == pBucketEnd)
+      return *this;
+
+   ++itList;
+   if (itList != pBucket->end())
+      return *this;
+
+   if (pOccupied)
+   {
+      size_t iBucket = numBuckets - (pBucketEnd - pBucket);
+      pBucket = pBucketEnd - (numBuckets - Occupancy::next(pOccupied, numBuckets, iBucket + 1));
+   }
+   else
+   {
+      ++pBucket;
+      while (pBucket != pBucketEnd && pBucket->empty())
+         ++pBucket;
+   }
+
+   if (pBucket != pBucketEnd)
+      itList = pBucket->begin();
+
+   return *this;
+}
+
+/*****************************************
+ * UNORDERED SET :: STATS
+ * Measure the chains in one pass, reading only the size of each
+ * bucket, never the nodes. A lookup that hits is equally likely to
+ * want any element, so a chain of length n adds 1 + 2 + ... + n to
+ * the total probes; one that misses is equally likely to land in
+ * any bucket and probes its whole chain.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+unordered_set_stats unordered_set<T, H, E, A, C>::stats() const
+{
+   unordered_set_stats s;
+   s.numElements = numElements;
+   s.numBuckets = bucket_count();
+
+   double expected = s.numBuckets ? (double)numElements / s.numBuckets : 0.0;
+   size_t totalProbeHit = 0;
+   for (size_t i = 0; i < s.numBuckets; i++)
+   {
+      size_t n = buckets[i].size();
+      if (n >= s.histogram.size())
+         s.histogram.resize(n + 1);
+      s.histogram[n]++;
+      s.numEmpty += n == 0;
+      if (n > s.maxProbeHit)
+         s.maxProbeHit = n;
+      totalProbeHit += n * (n + 1) / 2;
+      if (expected > 0.0)
+         s.chiSquared += (n - expected) * (n - expected) / expected;
+   }
+   s.maxProbeMiss = s.maxProbeHit;
+   s.meanProbeHit = numElements ? (double)totalProbeHit / numElements : 0.0;
+   s.meanProbeMiss = expected;
+
+   unordered_set_memory memory = memory_usage();
+   s.bytesBuckets = memory.bucketArray;
+   s.bytesNodes = memory.nodes;
+   s.bytesTrees = memory.trees;
+   return s;
+}
+
+/*****************************************
+ * UNORDERED SET :: MEMORY USAGE
+ * Count the bytes exactly from the sizes of what we allocate. The
+ * allocator's own overhead can only be estimated: for std::allocator
+ * we assume a malloc like glibc's, and for the arenas, pools, and
+ * memory resources, which carve blocks without headers, we take
+ * none.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+unordered_set_memory unordered_set<T, H, E, A, C>::memory_usage() const
+{
+   unordered_set_memory memory;
+   size_t numTreeNodes = 0;
+   for (size_t i = 0; i < trees.size(); i++)
+      numTreeNodes += trees[i].index.size();
+
+   memory.bucketArray = buckets.capacity() * sizeof(Bucket);
+   memory.nodes = numElements * Bucket::node_size();
+   memory.trees = trees.capacity() * sizeof(Tree) + numTreeNodes * ChainTree::node_size();
+   memory.occupancy = occupied.bytes();
+   memory.numAllocations = (buckets.capacity() != 0) + numElements +
+                           (trees.capacity() != 0) + numTreeNodes + (memory.occupancy != 0);
+
+   if (std::is_same<A, std::allocator<T>>::value)
+   {
+      if (buckets.capacity())
+         memory.allocatorOverhead += malloc_block_size(memory.bucketArray) - memory.bucketArray;
+      memory.allocatorOverhead += numElements *
+         (malloc_block_size(Bucket::node_size()) - Bucket::node_size());
+      if (memory.occupancy)
+         memory.allocatorOverhead += malloc_block_size(memory.occupancy) - memory.occupancy;
+      if (trees.capacity())
+         memory.allocatorOverhead += malloc_block_size(trees.capacity() * sizeof(Tree)) -
+                                     trees.capacity() * sizeof(Tree);
+      memory.allocatorOverhead += numTreeNodes *
+         (malloc_block_size(ChainTree::node_size()) - ChainTree::node_size());
+   }
+   return memory;
+}
+
+/*****************************************
+ * UNORDERED SET :: SAVE
+ * Write every element, in bucket order, as a snapshot
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+template <class Sink>
+bool unordered_set<T, H, E, A, C>::save(Sink& sink) const
+{
+   snapshot_writer<T, Sink> writer(sink);
+
+   snapshot_header header;
+   header.numElements = numElements;
+   header.numBuckets = bucket_count();
+   header.maxLoadFactor = maxLoadFactor;
+   if (!writer.header(header))
+      return false;
+
+   for (const_iterator it = begin(); it != end(); ++it)
+      writer.push(*it);
+
+   return writer.finish();
+}
+
+/*****************************************
+ * UNORDERED SET :: LOAD
+ * Replace the contents with a snapshot. The header says how big the
+ * table will be, but it is not believed past SNAPSHOT_PRESIZE buckets
+ * until the elements arrive: every time the table fills, it grows
+ * SNAPSHOT_GROWTH times toward the header's size, so a large snapshot
+ * is rehashed only two or three times, and a lying header costs at
+ * most SNAPSHOT_GROWTH times the buckets the file's elements need.
+ * A snapshot is a set's elements, each once, and the block checksums
+ * catch a damaged one, so each element is linked straight onto its
+ * chain. With checkDuplicates, each goes through the same
+ * find-or-insert as insert() instead, and a duplicate is an error.
+ * The set keeps its own Hash, EqPred and seed. If the snapshot is
+ * bad, throw and leave *this untouched.
+ ****************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+template <class Source>
+void unordered_set<T, H, E, A, C>::load(Source& source, bool checkDuplicates)
+{
+   snapshot_reader<T, Source> reader(source);
+   snapshot_header header = reader.header();
+
+   // A load factor of 0 or NaN would divide by zero when sizing
+   float maxLoad = header.maxLoadFactor;
+   unordered_set loaded(0, hasher(), equal(), get_allocator());
+   loaded.seed = seed;
+   loaded.maxLoadFactor = maxLoad >= MIN_LOAD_FACTOR ? (maxLoad <= MAX_LOAD_FACTOR ? maxLoad : MAX_LOAD_FACTOR) : MIN_LOAD_FACTOR;
+   loaded.minLoadFactor = minLoadFactor;
+   double numBucketsHeader = header.numElements / (double)loaded.maxLoadFactor;
+   if (numBucketsHeader < (double)header.numBuckets)
+      numBucketsHeader = (double)header.numBuckets;
+   double numBuckets = numBucketsHeader < (double)SNAPSHOT_PRESIZE ? numBucketsHeader : (double)SNAPSHOT_PRESIZE;
+   loaded.rehash(numBuckets >= 8 ? (size_t)numBuckets : 8);
+
+   T t;
+   while (reader.next(t))
+   {
+      size_t numRequired = loaded.min_buckets_required(loaded.numElements + 1);
+      if (numRequired > loaded.bucket_count())
+      {
+         numBuckets = (double)loaded.bucket_count() * SNAPSHOT_GROWTH;
+         if (numBuckets > numBucketsHeader)
+            numBuckets = numBucketsHeader;
+         loaded.rehash_to(numBuckets > (double)numRequired ? (size_t)numBuckets : numRequired);
+      }
+      size_t h = loaded.hash(t);
+      if (!checkDuplicates)
+         loaded.link_hashed(h, std::move(t));
+      else if (!loaded.emplace_hashed(t, h, std::move(t)).second)
+         throw "ERROR: duplicate element in unordered_set snapshot";
+   }
+   if ((uint64_t)loaded.numElements != header.numElements)
+      throw "ERROR: element count mismatch in unordered_set snapshot";
+
+   swap(loaded);
+}
+
 /*****************************************
  * SWAP
  * Stand-alone unordered set swap
  ****************************************/
-template <typename T, typename H, typename E, typename A>
-void swap(unordered_set<T, H, E, A>& lhs, unordered_set<T, H, E, A>& rhs)
+template <typename T, typename H, typename E, typename A, typename C>
+void swap(unordered_set<T, H, E, A, C>& lhs, unordered_set<T, H, E, A, C>& rhs)
 {
+   std::swap(lhs.hasher(), rhs.hasher());
+   std::swap(lhs.equal(), rhs.equal());
    std::swap(lhs.numElements, rhs.numElements);
    std::swap(lhs.maxLoadFactor, rhs.maxLoadFactor);
+   std::swap(lhs.minLoadFactor, rhs.minLoadFactor);
+   std::swap(lhs.keyed, rhs.keyed);
+   std::swap(lhs.key, rhs.key);
+   std::swap(lhs.seed, rhs.seed);
    std::swap(lhs.buckets, rhs.buckets);
+   lhs.occupied.swap(rhs.occupied);
+   lhs.trees.swap(rhs.trees);
 }
 
 
+namespace pmr
+{
+   /************************************************
+    * PMR UNORDERED SET
+    * An unordered set whose nodes and bucket array come from a
+    * std::pmr::memory_resource, such as a monotonic or pool resource:
+    *    custom::pmr::unordered_set<int> us(&resource);
+    ************************************************/
+   template <typename T,
+      typename Hash = std::hash<T>,
+      typename EqPred = std::equal_to<T>>
+   using unordered_set = custom::unordered_set<T, Hash, EqPred, std::pmr::polymorphic_allocator<T>>;
+}
+
 } // namespace custom
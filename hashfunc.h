@@ -0,0 +1,492 @@
+/***********************************************************************
+ * Header:
+ *    HASH FUNC
+ * Summary:
+ *    Hash functions that spread keys well over any bucket count
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the definition of:
+ *        mix64       : A strong, invertible 64 bit integer mixer
+ *        hash_bytes  : Seeded wyhash for short input, SIMD stripes for long
+ *        crc_bytes   : A hash built on the SSE4.2 CRC32C instruction
+ *        hash        : Drop-in Hash for integers, pointers and strings
+ *        crc_hash    : Drop-in Hash using crc_bytes
+ *        siphash     : Keyed SipHash-2-4, for keys an attacker chooses
+ *        keyed_hash  : SipHash of a key, used when a set is flooded
+ *
+ *    libstdc++ hashes an integer to itself, so keys that are multiples
+ *    of the bucket count, or close to it, pile into a few buckets.
+ *    These give every bit of the result a fair chance to flip with
+ *    every bit of the key:
+ *        custom::unordered_set<uint64_t, custom::hash<uint64_t>> ids;
+ *        custom::unordered_set<std::string, custom::hash<std::string>> words;
+ *    benchHashFunc.cpp compares them with std::hash on speed and on
+ *    how evenly they fill the buckets.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>      // for uint64_t
+#include <cstring>      // for memcpy
+#include <string>       // for std::string
+#include <string_view>  // for std::string_view
+#include <type_traits>  // for std::is_integral
+#include "snapshot.h"   // for crc32c, when the instruction is missing
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>  // for the SSE2, SSE4.2 and AVX2 intrinsics
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>     // for _umul128
+#endif
+
+class TestHashFunc;     // forward declaration for unit tests
+
+namespace custom
+{
+
+const uint64_t DEFAULT_SEED = 0x9E3779B97F4A7C15ull;   // used when none is given
+
+/************************************************
+ * MIX 64
+ * The murmur3 finalizer. Invertible, so distinct keys always get
+ * distinct hashes, and each input bit flips each output bit about
+ * half the time.
+ ************************************************/
+inline uint64_t mix64(uint64_t x)
+{
+   x ^= x >> 33;
+   x *= 0xff51afd7ed558ccdull;
+   x ^= x >> 33;
+   x *= 0xc4ceb9fe1a85ec53ull;
+   x ^= x >> 33;
+   return x;
+}
+
+/************************************************
+ * HASH DETAIL
+ * The pieces hash_bytes is built from
+ ************************************************/
+namespace hash_detail
+{
+   const uint64_t SECRET[4] =
+   {
+      0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+      0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+   };
+
+   // the key each stripe lane is mixed with
+   const uint64_t STRIPE_KEY[8] =
+   {
+      0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+      0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull
+   };
+
+   const size_t STRIPE = 64;            // bytes taken at once by the long path
+   const size_t STRIPES_PER_BLOCK = 16; // stripes between scrambles
+   const size_t LONG = 512;             // input at least this long takes the long path
+   const uint64_t PRIME32 = 0x9E3779B1u;
+
+   inline uint64_t read8(const unsigned char* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+   inline uint64_t read4(const unsigned char* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+   inline uint64_t read3(const unsigned char* p, size_t k)
+   {
+      return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+   }
+
+   // the full 128 bit product, folded to 64 bits
+   inline uint64_t mum(uint64_t a, uint64_t b)
+   {
+#if defined(__SIZEOF_INT128__)
+      __uint128_t r = (__uint128_t)a * b;
+      return (uint64_t)r ^ (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+      uint64_t hi;
+      uint64_t lo = _umul128(a, b, &hi);
+      return lo ^ hi;
+#else
+      uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t)a, lb = (uint32_t)b;
+      uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+      uint64_t t = rl + (rm0 << 32);
+      uint64_t c = t < rl;
+      uint64_t lo = t + (rm1 << 32);
+      c += lo < t;
+      uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+      return lo ^ hi;
+#endif
+   }
+
+   // wyhash: a 128 bit multiply for every 16 bytes
+   inline uint64_t wyhash(const unsigned char* p, size_t len, uint64_t seed)
+   {
+      seed ^= mum(seed ^ SECRET[0], SECRET[1]);
+      uint64_t a;
+      uint64_t b;
+      if (len <= 16)
+      {
+         if (len >= 4)
+         {
+            a = (read4(p) << 32) | read4(p + ((len >> 3) << 2));
+            b = (read4(p + len - 4) << 32) | read4(p + len - 4 - ((len >> 3) << 2));
+         }
+         else if (len > 0)
+         {
+            a = read3(p, len);
+            b = 0;
+         }
+         else
+            a = b = 0;
+      }
+      else
+      {
+         size_t i = len;
+         if (i > 48)
+         {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do
+            {
+               seed = mum(read8(p)      ^ SECRET[1], read8(p + 8)  ^ seed);
+               see1 = mum(read8(p + 16) ^ SECRET[2], read8(p + 24) ^ see1);
+               see2 = mum(read8(p + 32) ^ SECRET[3], read8(p + 40) ^ see2);
+               p += 48;
+               i -= 48;
+            }
+            while (i > 48);
+            seed ^= see1 ^ see2;
+         }
+         while (i > 16)
+         {
+            seed = mum(read8(p) ^ SECRET[1], read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+         }
+         a = read8(p + i - 16);
+         b = read8(p + i - 8);
+      }
+      return mum(SECRET[1] ^ len, mum(a ^ SECRET[1], b ^ seed));
+   }
+
+   // xxh3 style: eight lanes, each adding the product of the halves of
+   // its data mixed with a key, and its neighbor's raw data
+   inline void accumulate_scalar(uint64_t acc[8], const unsigned char* p, size_t numStripes)
+   {
+      for (size_t s = 0; s < numStripes; s++, p += STRIPE)
+         for (size_t i = 0; i < 8; i++)
+         {
+            uint64_t data = read8(p + 8 * i);
+            uint64_t key = data ^ STRIPE_KEY[i];
+            acc[i ^ 1] += data;
+            acc[i] += (key & 0xFFFFFFFFu) * (key >> 32);
+         }
+   }
+
+   inline void scramble_scalar(uint64_t acc[8])
+   {
+      for (size_t i = 0; i < 8; i++)
+         acc[i] = ((acc[i] ^ (acc[i] >> 47)) ^ STRIPE_KEY[7 - i]) * PRIME32;
+   }
+
+#if defined(__AVX2__)
+   inline void accumulate_simd(uint64_t acc[8], const unsigned char* p, size_t numStripes)
+   {
+      __m256i a0 = _mm256_loadu_si256((const __m256i*)acc);
+      __m256i a1 = _mm256_loadu_si256((const __m256i*)acc + 1);
+      const __m256i k0 = _mm256_loadu_si256((const __m256i*)STRIPE_KEY);
+      const __m256i k1 = _mm256_loadu_si256((const __m256i*)STRIPE_KEY + 1);
+      for (size_t s = 0; s < numStripes; s++, p += STRIPE)
+      {
+         __m256i d0 = _mm256_loadu_si256((const __m256i*)p);
+         __m256i d1 = _mm256_loadu_si256((const __m256i*)p + 1);
+         __m256i x0 = _mm256_xor_si256(d0, k0);
+         __m256i x1 = _mm256_xor_si256(d1, k1);
+         a0 = _mm256_add_epi64(a0, _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2)));
+         a1 = _mm256_add_epi64(a1, _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2)));
+         a0 = _mm256_add_epi64(a0, _mm256_mul_epu32(x0, _mm256_srli_epi64(x0, 32)));
+         a1 = _mm256_add_epi64(a1, _mm256_mul_epu32(x1, _mm256_srli_epi64(x1, 32)));
+      }
+      _mm256_storeu_si256((__m256i*)acc, a0);
+      _mm256_storeu_si256((__m256i*)acc + 1, a1);
+   }
+#elif defined(__SSE2__) || defined(_M_X64)
+   inline void accumulate_simd(uint64_t acc[8], const unsigned char* p, size_t numStripes)
+   {
+      __m128i a[4];
+      __m128i k[4];
+      for (int i = 0; i < 4; i++)
+      {
+         a[i] = _mm_loadu_si128((const __m128i*)acc + i);
+         k[i] = _mm_loadu_si128((const __m128i*)STRIPE_KEY + i);
+      }
+      for (size_t s = 0; s < numStripes; s++, p += STRIPE)
+         for (int i = 0; i < 4; i++)
+         {
+            __m128i d = _mm_loadu_si128((const __m128i*)p + i);
+            __m128i x = _mm_xor_si128(d, k[i]);
+            a[i] = _mm_add_epi64(a[i], _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2)));
+            a[i] = _mm_add_epi64(a[i], _mm_mul_epu32(x, _mm_srli_epi64(x, 32)));
+         }
+      for (int i = 0; i < 4; i++)
+         _mm_storeu_si128((__m128i*)acc + i, a[i]);
+   }
+#else
+   inline void accumulate_simd(uint64_t acc[8], const unsigned char* p, size_t numStripes)
+   {
+      accumulate_scalar(acc, p, numStripes);
+   }
+#endif
+
+   // long input: stripes through the accumulators, the tail through wyhash
+   inline uint64_t hash_long(const unsigned char* p, size_t len, uint64_t seed)
+   {
+      uint64_t acc[8];
+      for (size_t i = 0; i < 8; i++)
+         acc[i] = seed ^ STRIPE_KEY[i];
+
+      size_t numStripes = len / STRIPE;
+      size_t s = 0;
+      for (; s + STRIPES_PER_BLOCK <= numStripes; s += STRIPES_PER_BLOCK)
+      {
+         accumulate_simd(acc, p + s * STRIPE, STRIPES_PER_BLOCK);
+         scramble_scalar(acc);
+      }
+      accumulate_simd(acc, p + s * STRIPE, numStripes - s);
+
+      uint64_t h = len * PRIME32;
+      for (size_t i = 0; i < 8; i += 2)
+         h += mum(acc[i] ^ SECRET[i / 2], acc[i + 1] ^ STRIPE_KEY[i]);
+      size_t tail = len - numStripes * STRIPE;
+      return wyhash(p + len - tail, tail, mix64(h));
+   }
+}
+
+/************************************************
+ * HASH BYTES
+ * Seeded, and fast at every length: wyhash up to LONG bytes, SIMD
+ * stripes beyond
+ ************************************************/
+inline uint64_t hash_bytes(const void* data, size_t len, uint64_t seed = DEFAULT_SEED)
+{
+   const unsigned char* p = (const unsigned char*)data;
+   if (len < hash_detail::LONG)
+      return hash_detail::wyhash(p, len, seed);
+   return hash_detail::hash_long(p, len, seed);
+}
+
+/************************************************
+ * CRC BYTES
+ * Two CRC32C lanes eight bytes at a time, put through mix64 since a
+ * CRC alone is linear. Without SSE4.2 it falls back to the table
+ * driven crc32c, which gives the same answer far more slowly.
+ ************************************************/
+inline uint64_t crc_bytes(const void* data, size_t len, uint64_t seed = DEFAULT_SEED)
+{
+   const unsigned char* p = (const unsigned char*)data;
+   uint64_t lo = (uint32_t)seed;
+   uint64_t hi = seed >> 32;
+#if defined(__SSE4_2__)
+   size_t i = 0;
+   for (; i + 16 <= len; i += 16)
+   {
+      lo = _mm_crc32_u64(lo, hash_detail::read8(p + i));
+      hi = _mm_crc32_u64(hi, hash_detail::read8(p + i + 8));
+   }
+   if (i + 8 <= len)
+   {
+      lo = _mm_crc32_u64(lo, hash_detail::read8(p + i));
+      i += 8;
+   }
+   for (; i < len; i++)
+      lo = _mm_crc32_u8((uint32_t)lo, p[i]);
+#else
+   size_t i = 0;
+   for (; i + 16 <= len; i += 16)
+   {
+      lo = ~crc32c((const char*)p + i,     8, ~(uint32_t)lo);
+      hi = ~crc32c((const char*)p + i + 8, 8, ~(uint32_t)hi);
+   }
+   if (i < len)
+      lo = ~crc32c((const char*)p + i, len - i, ~(uint32_t)lo);
+#endif
+   return mix64((hi << 32 | lo) ^ len);
+}
+
+/************************************************
+ * HASH
+ * A drop-in Hash: mix64 for integers, enums and pointers, hash_bytes
+ * for strings. Keep this form for your own types:
+ *    template <> struct hash<Point> { size_t operator () (const Point& p) const ... };
+ ************************************************/
+template <typename T>
+struct hash
+{
+   static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                 "custom::hash needs an integer, an enum, a pointer, or a string");
+   size_t operator () (T t) const noexcept
+   {
+      uint64_t key;
+      if constexpr (std::is_pointer<T>::value)
+         key = (uint64_t)(uintptr_t)t;
+      else
+         key = (uint64_t)t;
+      return (size_t)mix64(key + DEFAULT_SEED);
+   }
+};
+
+template <>
+struct hash<std::string_view>
+{
+   size_t operator () (std::string_view s) const noexcept
+   {
+      return (size_t)hash_bytes(s.data(), s.size());
+   }
+};
+
+template <>
+struct hash<std::string>
+{
+   size_t operator () (const std::string& s) const noexcept
+   {
+      return (size_t)hash_bytes(s.data(), s.size());
+   }
+};
+
+/************************************************
+ * CRC HASH
+ * Like hash, with crc_bytes doing the work
+ ************************************************/
+template <typename T>
+struct crc_hash
+{
+   static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                 "custom::crc_hash needs an integer, an enum, or a string");
+   size_t operator () (T t) const noexcept
+   {
+      uint64_t key = (uint64_t)t;
+      return (size_t)crc_bytes(&key, sizeof(key));
+   }
+};
+
+template <>
+struct crc_hash<std::string_view>
+{
+   size_t operator () (std::string_view s) const noexcept
+   {
+      return (size_t)crc_bytes(s.data(), s.size());
+   }
+};
+
+template <>
+struct crc_hash<std::string>
+{
+   size_t operator () (const std::string& s) const noexcept
+   {
+      return (size_t)crc_bytes(s.data(), s.size());
+   }
+};
+
+/************************************************
+ * SIPHASH
+ * SipHash-2-4 under a 128 bit key. Slower than hash_bytes, but
+ * without the key nobody can find inputs that collide, which is
+ * what a set of client-supplied keys needs once it is under attack.
+ ************************************************/
+inline uint64_t siphash(const void* data, size_t len, uint64_t k0, uint64_t k1)
+{
+   const unsigned char* p = (const unsigned char*)data;
+   uint64_t v0 = k0 ^ 0x736f6d6570736575ull;
+   uint64_t v1 = k1 ^ 0x646f72616e646f6dull;
+   uint64_t v2 = k0 ^ 0x6c7967656e657261ull;
+   uint64_t v3 = k1 ^ 0x7465646279746573ull;
+
+   auto rotl = [](uint64_t x, int b) { return (x << b) | (x >> (64 - b)); };
+   auto round = [&]()
+   {
+      v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+      v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+      v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+      v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+   };
+
+   size_t end = len - len % 8;
+   for (size_t i = 0; i < end; i += 8)
+   {
+      uint64_t m = hash_detail::read8(p + i);
+      v3 ^= m;
+      round();
+      round();
+      v0 ^= m;
+   }
+
+   uint64_t b = (uint64_t)len << 56;
+   for (size_t i = 0; i < len % 8; i++)
+      b |= (uint64_t)p[end + i] << (8 * i);
+   v3 ^= b;
+   round();
+   round();
+   v0 ^= b;
+
+   v2 ^= 0xff;
+   round();
+   round();
+   round();
+   round();
+   return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/************************************************
+ * KEYED HASH
+ * SipHash of a key under k0 and k1. Strings and integers are hashed
+ * from their own bytes. Other types offer no bytes, so their Hash
+ * value is keyed instead: that scatters keys that only collided
+ * modulo the bucket count, though not keys whose hashes are equal.
+ * Specialize it for such a type to hash its fields.
+ ************************************************/
+template <typename T, typename = void>
+struct keyed_hash
+{
+   template <typename Hash>
+   uint64_t operator () (const T& t, const Hash& hash, uint64_t k0, uint64_t k1) const
+   {
+      uint64_t h = (uint64_t)hash(t);
+      return siphash(&h, sizeof(h), k0, k1);
+   }
+};
+
+template <typename T>
+struct keyed_hash<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+   template <typename Hash>
+   uint64_t operator () (T t, const Hash& hash, uint64_t k0, uint64_t k1) const
+   {
+      return siphash(&t, sizeof(t), k0, k1);
+   }
+};
+
+template <>
+struct keyed_hash<std::string>
+{
+   template <typename Hash>
+   uint64_t operator () (const std::string& s, const Hash& hash, uint64_t k0, uint64_t k1) const
+   {
+      return siphash(s.data(), s.size(), k0, k1);
+   }
+};
+
+template <>
+struct keyed_hash<std::string_view>
+{
+   template <typename Hash>
+   uint64_t operator () (std::string_view s, const Hash& hash, uint64_t k0, uint64_t k1) const
+   {
+      return siphash(s.data(), s.size(), k0, k1);
+   }
+};
+
+} // namespace custom
@@ -0,0 +1,295 @@
+/***********************************************************************
+ * Header:
+ *    HASH MAP
+ * Summary:
+ *    An unordered map on the same buckets as unordered_set
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        unordered_map           : A map from K to V implemented as a hash
+ *        unordered_map::iterator : An iterator through the map
+ *
+ *    A map is an unordered_set of pair<const K, V> whose Hash and
+ *    EqPred look only at the key. They take a bare K as well, so
+ *    find(), operator[] and the rest look a key up without building
+ *    an element, and the mapped value is built in its node only once
+ *    the key is known to be missing. The counter idiom
+ *        counts[word]++;
+ *    is then one hash and one walk of the chain, hit or miss.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>      // for size_t
+#include <functional>   // for std::hash and std::equal_to
+#include <memory>       // for std::allocator
+#include <tuple>        // for std::tuple and std::make_from_tuple
+#include <utility>      // for std::forward
+#include "hash.h"       // for unordered_set, whose buckets these are
+#include "pair.h"       // because an element is a pair
+
+class TestHashMap;      // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * UNORDERED MAP
+ * A map implemented as a hash. Chains are never treed, since the set
+ * underneath compares through key_equal rather than operator ==.
+ ************************************************/
+template <typename K,
+   typename V,
+   typename Hash = std::hash<K>,
+   typename EqPred = std::equal_to<K>,
+   typename A = std::allocator<custom::pair<const K, V>>,
+   typename Counters = no_counters >
+class unordered_map
+{
+   friend class ::TestHashMap;   // give unit tests access to the privates
+public:
+   typedef K key_type;
+   typedef V mapped_type;
+   typedef custom::pair<const K, V> value_type;
+
+   /**
+    * Hash applied to the key of an element, or to a bare key. key()
+    * lets a flooded set key the bytes of the key, not just its Hash.
+    */
+   class key_hash : private ebo_holder<Hash, 0>
+   {
+   public:
+      typedef K key_type;
+      key_hash(const Hash& hash = Hash()) : ebo_holder<Hash, 0>(hash) {}
+      size_t operator () (const value_type& e) const { return get()(e.first); }
+      size_t operator () (const K& k) const          { return get()(k);       }
+      static const K& key(const value_type& e)       { return e.first;        }
+      static const K& key(const K& k)                { return k;              }
+      const Hash& get() const { return ebo_holder<Hash, 0>::get(); }
+   };
+
+   /**
+    * EqPred applied to the keys, either of which may be bare
+    */
+   class key_equal : private ebo_holder<EqPred, 1>
+   {
+   public:
+      typedef EqPred key_equality;
+      key_equal(const EqPred& eq = EqPred()) : ebo_holder<EqPred, 1>(eq) {}
+      bool operator () (const value_type& lhs, const value_type& rhs) const { return get()(lhs.first, rhs.first); }
+      bool operator () (const value_type& lhs, const K& rhs) const          { return get()(lhs.first, rhs);       }
+      const EqPred& get() const { return ebo_holder<EqPred, 1>::get(); }
+   };
+
+private:
+   typedef unordered_set<value_type, key_hash, key_equal, A, Counters> Entries;
+
+public:
+   typedef typename Entries::iterator iterator;
+   typedef typename Entries::const_iterator const_iterator;
+   typedef typename Entries::local_iterator local_iterator;
+   typedef typename Entries::const_local_iterator const_local_iterator;
+
+   //
+   // Construct
+   //
+   unordered_map() : entries() {}
+   unordered_map(size_t numBuckets) : entries(numBuckets) {}
+   explicit unordered_map(const A& a) : entries(a) {}
+   unordered_map(size_t numBuckets, const Hash& hash, const EqPred& eq = EqPred(), const A& a = A())
+      : entries(numBuckets, key_hash(hash), key_equal(eq), a) {}
+   unordered_map(const unordered_map& rhs) : entries(rhs.entries) {}
+   unordered_map(unordered_map&& rhs) : entries(std::move(rhs.entries)) {}
+   unordered_map(const std::initializer_list<value_type>& il) : entries()
+   {
+      reserve(il.size());
+      insert(il);
+   }
+
+   //
+   // Assign
+   //
+   unordered_map& operator=(const unordered_map& rhs)
+   {
+      entries = rhs.entries;
+      return *this;
+   }
+   unordered_map& operator=(unordered_map&& rhs)
+   {
+      entries = std::move(rhs.entries);
+      return *this;
+   }
+   void swap(unordered_map& rhs)
+   {
+      entries.swap(rhs.entries);
+   }
+
+   //
+   // Iterator
+   //
+   iterator begin()                                  { return entries.begin();        }
+   iterator end()                                    { return entries.end();          }
+   const_iterator begin() const                      { return entries.begin();        }
+   const_iterator end()   const                      { return entries.end();          }
+   const_iterator cbegin() const                     { return entries.cbegin();       }
+   const_iterator cend()   const                     { return entries.cend();         }
+   local_iterator begin(size_t iBucket)              { return entries.begin(iBucket); }
+   local_iterator end(size_t iBucket)                { return entries.end(iBucket);   }
+   const_local_iterator begin(size_t iBucket) const  { return entries.begin(iBucket); }
+   const_local_iterator end(size_t iBucket)   const  { return entries.end(iBucket);   }
+
+   //
+   // Access
+   //
+   size_t bucket(const K& k) const
+   {
+      return entries.bucket_of(entries.hash(k));
+   }
+   iterator find(const K& k)
+   {
+      return entries.find_hashed(k, entries.hash(k));
+   }
+   const_iterator find(const K& k) const
+   {
+      return entries.find_hashed(k, entries.hash(k));
+   }
+   size_t count(const K& k) const
+   {
+      return find(k) == end() ? 0 : 1;
+   }
+   V& at(const K& k);
+   const V& at(const K& k) const;
+   V& operator [] (const K& k)
+   {
+      return (*try_emplace(k).first).second;
+   }
+
+   //
+   // Insert
+   //
+   custom::pair<iterator, bool> insert(const value_type& e)
+   {
+      return entries.insert(e);
+   }
+   void insert(const std::initializer_list<value_type>& il)
+   {
+      entries.insert(il);
+   }
+   template <class ... Args>
+   custom::pair<iterator, bool> try_emplace(const K& k, Args&& ... args);
+   template <class M>
+   custom::pair<iterator, bool> insert_or_assign(const K& k, M&& m);
+   void rehash(size_t numBuckets) { entries.rehash(numBuckets); }
+   void reserve(size_t num)       { entries.reserve(num);       }
+
+   //
+   // Remove
+   //
+   void clear() noexcept          { entries.clear(); }
+   iterator erase(const K& k)
+   {
+      return entries.erase_hashed(k, entries.hash(k));
+   }
+
+   //
+   // Status
+   //
+   size_t size()  const                       { return entries.size();            }
+   bool empty() const                         { return entries.empty();           }
+   size_t bucket_count() const                { return entries.bucket_count();    }
+   size_t bucket_size(size_t i) const         { return entries.bucket_size(i);    }
+   float load_factor() const noexcept         { return entries.load_factor();     }
+   float max_load_factor() const noexcept     { return entries.max_load_factor(); }
+   void  max_load_factor(float m)             { entries.max_load_factor(m);       }
+   bool is_keyed() const noexcept             { return entries.is_keyed();        }
+   unordered_set_stats stats() const          { return entries.stats();           }
+   unordered_set_counters counters() const    { return entries.counters();        }
+   void reset_counters()                      { entries.reset_counters();         }
+   A get_allocator() const                    { return entries.get_allocator();   }
+   Hash hash_function() const                 { return entries.hash_function().get(); }
+   EqPred key_eq() const                      { return entries.key_eq().get();    }
+
+private:
+   /**
+    * The mapped value for try_emplace, built from its arguments only
+    * when the pair it goes into is built, which is only on a miss
+    */
+   template <class ... Args>
+   struct deferred_value
+   {
+      std::tuple<Args&& ...> args;
+      operator V () { return std::make_from_tuple<V>(std::move(args)); }
+   };
+
+   Entries entries;   // the elements, each a key and its value
+};
+
+/*****************************************
+ * UNORDERED MAP :: AT
+ * The value mapped to k, which must be there
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A, typename C>
+V& unordered_map<K, V, H, E, A, C>::at(const K& k)
+{
+   iterator it = find(k);
+   if (it == end())
+      throw "ERROR: the key is not in the unordered_map";
+   return (*it).second;
+}
+
+template <typename K, typename V, typename H, typename E, typename A, typename C>
+const V& unordered_map<K, V, H, E, A, C>::at(const K& k) const
+{
+   const_iterator it = find(k);
+   if (it == end())
+      throw "ERROR: the key is not in the unordered_map";
+   return (*it).second;
+}
+
+/*****************************************
+ * UNORDERED MAP :: TRY EMPLACE
+ * If k is missing, add it mapped to V(args...). One hash and one walk
+ * of the chain either way, and neither the key nor the value is
+ * copied or built when k is already there.
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A, typename C>
+template <class ... Args>
+custom::pair<typename unordered_map<K, V, H, E, A, C>::iterator, bool> unordered_map<K, V, H, E, A, C>::try_emplace(const K& k, Args&& ... args)
+{
+   deferred_value<Args ...> value { std::tuple<Args&& ...>(std::forward<Args>(args)...) };
+   return entries.emplace_hashed(k, entries.hash(k), k, std::move(value));
+}
+
+/*****************************************
+ * UNORDERED MAP :: INSERT OR ASSIGN
+ * Map k to m, whether or not k is already there. m is used once:
+ * to build the value on a miss, or assigned to it on a hit.
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A, typename C>
+template <class M>
+custom::pair<typename unordered_map<K, V, H, E, A, C>::iterator, bool> unordered_map<K, V, H, E, A, C>::insert_or_assign(const K& k, M&& m)
+{
+   custom::pair<iterator, bool> result = try_emplace(k, std::forward<M>(m));
+   if (!result.second)
+      (*result.first).second = std::forward<M>(m);
+   return result;
+}
+
+/*****************************************
+ * SWAP
+ * Stand-alone unordered map swap
+ ****************************************/
+template <typename K, typename V, typename H, typename E, typename A, typename C>
+void swap(unordered_map<K, V, H, E, A, C>& lhs, unordered_map<K, V, H, E, A, C>& rhs)
+{
+   lhs.swap(rhs);
+}
+
+} // namespace custom
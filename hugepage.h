@@ -0,0 +1,199 @@
+/***********************************************************************
+ * Header:
+ *    HUGE PAGE
+ * Summary:
+ *    Memory backed by 2 MB pages for very large tables
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        huge_page_resource : Hands out memory from 2 MB aligned regions
+ *
+ *    A table with hundreds of millions of elements spans gigabytes,
+ *    and with 4 KB pages nearly every lookup misses the TLB as well
+ *    as the cache. Backing the bucket array and the node slabs with
+ *    2 MB pages cuts the page walks. Put a node_pool on top so that
+ *    nodes are recycled and the slabs come from huge pages:
+ *        custom::huge_page_resource huge;
+ *        custom::node_pool pool(4096, &huge);
+ *        custom::pmr::unordered_set<uint64_t> us(&pool);
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>          // for std::max_align_t
+#include <cstdint>          // for uintptr_t
+#include <new>              // for std::bad_alloc
+#include <memory_resource>  // for std::pmr::memory_resource
+#ifdef __linux__
+#include <sys/mman.h>       // for mmap, madvise and munmap
+#endif // __linux__
+
+class TestHash;             // forward declaration for Hash unit tests
+
+namespace custom
+{
+
+/************************************************
+ * HUGE PAGE RESOURCE
+ * Every region is 2 MB aligned and, on Linux, either mapped from
+ * the hugetlbfs pool (MAP_HUGETLB, when asked for and configured)
+ * or marked MADV_HUGEPAGE so that transparent huge pages back it.
+ * Elsewhere the regions are simply 2 MB aligned.
+ *
+ * A request of LARGE bytes or more, such as a big bucket array,
+ * gets a region of its own. Smaller ones, such as node slabs, are
+ * carved from a shared region whose header counts the live blocks;
+ * the region goes back once the count drops to zero.
+ ************************************************/
+class huge_page_resource : public std::pmr::memory_resource
+{
+   friend class ::TestHash;   // give unit tests access to the privates
+public:
+   static const size_t PAGE  = 2 * 1024 * 1024;   // the huge page size
+   static const size_t LARGE = PAGE / 4;          // requests that get a region of their own
+
+   //
+   // Construct
+   //
+   huge_page_resource(bool useHugeTLB = false)
+      : useHugeTLB(useHugeTLB), usedHugeTLB(false), pCurrent(nullptr), pNext(nullptr), numMapped(0)
+   {}
+   huge_page_resource(const huge_page_resource& rhs) = delete;
+   huge_page_resource& operator = (const huge_page_resource& rhs) = delete;
+   ~huge_page_resource()
+   {
+      // the region we carve from stays until we are done with it
+      if (pCurrent && pCurrent->numLive == 0)
+         unmap(pCurrent, PAGE);
+   }
+
+   //
+   // Status
+   //
+   size_t bytes_mapped()  const { return numMapped;   }
+   bool   used_hugetlb()  const { return usedHugeTLB; }
+
+private:
+   // the header at the front of a shared region
+   struct alignas(std::max_align_t) Region
+   {
+      size_t numLive;   // blocks handed out and not yet returned
+   };
+
+   static size_t round_up(size_t n, size_t to) { return (n + to - 1) / to * to; }
+
+   void* do_allocate(size_t bytes, size_t alignment) override
+   {
+      if (bytes >= LARGE || alignment > alignof(std::max_align_t))
+         return map(round_up(bytes, PAGE));
+
+      char* p = (char*)round_up((uintptr_t)pNext, alignment);
+      if (!pCurrent || p + bytes > (char*)pCurrent + PAGE)
+      {
+         // Let go of the old region. Its last block frees it.
+         if (pCurrent && pCurrent->numLive == 0)
+            unmap(pCurrent, PAGE);
+         pCurrent = (Region*)map(PAGE);
+         pCurrent->numLive = 0;
+         p = (char*)round_up((uintptr_t)(pCurrent + 1), alignment);
+      }
+      pNext = p + bytes;
+      pCurrent->numLive++;
+      return p;
+   }
+
+   void do_deallocate(void* p, size_t bytes, size_t alignment) override
+   {
+      if (bytes >= LARGE || alignment > alignof(std::max_align_t))
+      {
+         unmap(p, round_up(bytes, PAGE));
+         return;
+      }
+
+      // regions are aligned, so the header is at the start of the page
+      Region* pRegion = (Region*)((uintptr_t)p & ~(uintptr_t)(PAGE - 1));
+      if (--pRegion->numLive == 0 && pRegion != pCurrent)
+         unmap(pRegion, PAGE);
+   }
+
+   bool do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override
+   {
+      return this == &rhs;
+   }
+
+   void* map(size_t size);
+   void unmap(void* p, size_t size);
+
+   bool useHugeTLB;     // try the hugetlbfs pool first?
+   bool usedHugeTLB;    // did the hugetlbfs pool ever come through?
+   Region* pCurrent;    // the shared region we are carving from
+   char* pNext;         // the next free byte in pCurrent
+   size_t numMapped;    // bytes in all live regions
+};
+
+/************************************************
+ * HUGE PAGE RESOURCE :: MAP
+ * Get size bytes, a multiple of PAGE, aligned to PAGE
+ ************************************************/
+inline void* huge_page_resource::map(size_t size)
+{
+#ifdef __linux__
+#ifdef MAP_HUGETLB
+   // The hugetlbfs pool is empty unless an administrator set it up,
+   // in which case the kernel hands us aligned huge pages directly.
+   if (useHugeTLB)
+   {
+      void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (p != MAP_FAILED)
+      {
+         usedHugeTLB = true;
+         numMapped += size;
+         return p;
+      }
+   }
+#endif // MAP_HUGETLB
+
+   // Map an extra page so that we can trim to an aligned start.
+   char* pRaw = (char*)mmap(nullptr, size + PAGE, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (pRaw == (char*)MAP_FAILED)
+      throw std::bad_alloc();
+   char* p = (char*)round_up((uintptr_t)pRaw, PAGE);
+   if (p != pRaw)
+      munmap(pRaw, p - pRaw);
+   munmap(p + size, pRaw + PAGE - p);
+#ifdef MADV_HUGEPAGE
+   madvise(p, size, MADV_HUGEPAGE);   // only a hint: THP may be disabled
+#endif // MADV_HUGEPAGE
+   numMapped += size;
+   return p;
+#else
+   void* p = std::pmr::new_delete_resource()->allocate(size, PAGE);
+   numMapped += size;
+   return p;
+#endif // __linux__
+}
+
+/************************************************
+ * HUGE PAGE RESOURCE :: UNMAP
+ * Give back a region from map()
+ ************************************************/
+inline void huge_page_resource::unmap(void* p, size_t size)
+{
+#ifdef __linux__
+   munmap(p, size);
+#else
+   std::pmr::new_delete_resource()->deallocate(p, size, PAGE);
+#endif // __linux__
+   numMapped -= size;
+}
+
+} // namespace custom
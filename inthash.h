@@ -0,0 +1,383 @@
+/***********************************************************************
+ * Header:
+ *    INT HASH
+ * Summary:
+ *    An unordered set of integers stored flat, one key per slot
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        multiply_shift_hash         : Fibonacci hashing into the top bits
+ *        identity_hash               : The low bits of the key itself
+ *        int_unordered_set           : A flat, linear probing set of integers
+ *        int_unordered_set::iterator : An iterator through the set
+ *
+ *    Each element takes exactly sizeof(K) bytes. Two key values are
+ *    given up to mark empty slots and erased ones; by default these
+ *    are the two largest values of K, and either can be chosen as
+ *    template arguments when those values are real IDs:
+ *        custom::int_unordered_set<uint32_t> ids;        // ~0 and ~0 - 1 reserved
+ *        custom::int_unordered_set<int64_t, 0, -1> ids;  // 0 and -1 reserved
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>      // for uint64_t
+#include <limits>       // for std::numeric_limits
+#include <memory>       // for std::allocator
+#include <type_traits>  // for std::is_integral
+#include "vector.h"     // because this->slots is a vector
+#include "pair.h"       // because insert() returns a pair
+
+class TestIntHash;      // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * MULTIPLY SHIFT HASH
+ * Multiply by 2^64 / phi and keep the top bits, which depend on
+ * every bit of the key. The safe default.
+ ************************************************/
+struct multiply_shift_hash
+{
+   template <typename K>
+   size_t operator () (K k, int numBits) const
+   {
+      return numBits == 0 ? 0 : (size_t)(((uint64_t)k * 0x9E3779B97F4A7C15ull) >> (64 - numBits));
+   }
+};
+
+/************************************************
+ * IDENTITY HASH
+ * Keep the low bits of the key. The fastest, and right for keys that
+ * are already well spread, such as random IDs. Sequential keys also
+ * do well since they fill consecutive slots.
+ ************************************************/
+struct identity_hash
+{
+   template <typename K>
+   size_t operator () (K k, int numBits) const
+   {
+      return (size_t)((uint64_t)k & (((uint64_t)1 << numBits) - 1));
+   }
+};
+
+/************************************************
+ * INT UNORDERED SET
+ * Linear probing over a power-of-two array of keys. Erasing leaves
+ * a tombstone unless the next slot is empty, and tombstones count
+ * toward the load so that a rehash clears them out.
+ ************************************************/
+template <typename K,
+   K Empty = std::numeric_limits<K>::max(),
+   K Tombstone = (K)(std::numeric_limits<K>::max() - 1),
+   typename Hash = multiply_shift_hash,
+   typename A = std::allocator<K>>
+class int_unordered_set
+{
+   static_assert(std::is_integral<K>::value, "int_unordered_set holds integer keys");
+   static_assert(Empty != Tombstone, "the empty and tombstone keys must differ");
+   friend class ::TestIntHash;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   int_unordered_set(const A& a = A())
+      : slots(a), numElements(0), numTombstones(0), numBits(0), maxLoadFactor((float)0.75)
+   {
+      allocate(8);
+   }
+   int_unordered_set(size_t numSlots, const A& a = A())
+      : slots(a), numElements(0), numTombstones(0), numBits(0), maxLoadFactor((float)0.75)
+   {
+      allocate(numSlots);
+   }
+   int_unordered_set(const std::initializer_list<K>& il, const A& a = A())
+      : int_unordered_set(a)
+   {
+      reserve(il.size());
+      for (auto it = il.begin(); it != il.end(); ++it)
+         insert(*it);
+   }
+
+   //
+   // Assign
+   //
+   void swap(int_unordered_set& rhs)
+   {
+      slots.swap(rhs.slots);
+      std::swap(numElements, rhs.numElements);
+      std::swap(numTombstones, rhs.numTombstones);
+      std::swap(numBits, rhs.numBits);
+      std::swap(maxLoadFactor, rhs.maxLoadFactor);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const
+   {
+      return iterator(this, 0).settle();
+   }
+   iterator end() const
+   {
+      return iterator(this, slots.size());
+   }
+
+   //
+   // Access
+   //
+   iterator find(K k) const;
+
+   //
+   // Insert
+   //
+   custom::pair<iterator, bool> insert(K k);
+   void rehash(size_t numSlots);
+   void reserve(size_t num)
+   {
+      size_t numSlots = (size_t)((float)num / maxLoadFactor) + 1;
+      if (numSlots > slots.size())
+         rehash(numSlots);
+   }
+
+   //
+   // Remove
+   //
+   void clear()
+   {
+      for (size_t i = 0; i < slots.size(); i++)
+         slots[i] = Empty;
+      numElements = 0;
+      numTombstones = 0;
+   }
+   size_t erase(K k);
+
+   //
+   // Status
+   //
+   size_t size()            const { return numElements;      }
+   bool   empty()           const { return numElements == 0; }
+   size_t bucket_count()    const { return slots.size();     }
+   float  load_factor()     const { return (float)numElements / (float)slots.size(); }
+   float  max_load_factor() const { return maxLoadFactor;    }
+   void   max_load_factor(float m)
+   {
+      if (m <= 0.0 || m >= 1.0)
+         throw "ERROR: the max load factor of int_unordered_set must be between 0 and 1";
+      maxLoadFactor = m;
+   }
+
+private:
+   size_t home(K k) const
+   {
+      return Hash()(k, numBits);
+   }
+   size_t next(size_t iSlot) const
+   {
+      return (iSlot + 1) & (slots.size() - 1);
+   }
+   static void check(K k)
+   {
+      if (k == Empty || k == Tombstone)
+         throw "ERROR: the key is reserved to mark empty slots";
+   }
+
+   void allocate(size_t numSlots);
+
+   custom::vector<K, A> slots;   // the keys, Empty, or Tombstone
+   size_t numElements;           // number of keys in the set
+   size_t numTombstones;         // number of slots holding Tombstone
+   int numBits;                  // log2(number of slots)
+   float maxLoadFactor;          // keys and tombstones over slots before growing
+};
+
+/************************************************
+ * INT UNORDERED SET ITERATOR
+ * Walk the slots, skipping the empty ones and the tombstones
+ ************************************************/
+template <typename K, K Empty, K Tombstone, typename Hash, typename A>
+class int_unordered_set <K, Empty, Tombstone, Hash, A> ::iterator
+{
+   friend class ::TestIntHash;   // give unit tests access to the privates
+   template <typename KK, KK E, KK T, typename H, typename AA>
+   friend class custom::int_unordered_set;
+public:
+   //
+   // Construct
+   //
+   iterator() : pSet(nullptr), iSlot(0) {}
+   iterator(const int_unordered_set* pSet, size_t iSlot) : pSet(pSet), iSlot(iSlot) {}
+
+   //
+   // Compare
+   //
+   bool operator == (const iterator& rhs) const { return iSlot == rhs.iSlot; }
+   bool operator != (const iterator& rhs) const { return iSlot != rhs.iSlot; }
+
+   //
+   // Access
+   //
+   const K& operator * () const
+   {
+      return pSet->slots[iSlot];
+   }
+
+   //
+   // Arithmetic
+   //
+   iterator& operator ++ ()
+   {
+      ++iSlot;
+      return settle();
+   }
+   iterator operator ++ (int postfix)
+   {
+      iterator temp(*this);
+      ++(*this);
+      return temp;
+   }
+
+private:
+   // move forward to the first key at or after this slot
+   iterator& settle()
+   {
+      while (iSlot < pSet->slots.size() &&
+             (pSet->slots[iSlot] == Empty || pSet->slots[iSlot] == Tombstone))
+         ++iSlot;
+      return *this;
+   }
+
+   const int_unordered_set* pSet;
+   size_t iSlot;
+};
+
+/*****************************************
+ * INT UNORDERED SET :: FIND
+ * Probe from home until the key or an empty slot
+ ****************************************/
+template <typename K, K Empty, K Tombstone, typename Hash, typename A>
+typename int_unordered_set<K, Empty, Tombstone, Hash, A>::iterator
+int_unordered_set<K, Empty, Tombstone, Hash, A>::find(K k) const
+{
+   if (k == Empty || k == Tombstone)
+      return end();
+   for (size_t iSlot = home(k); slots[iSlot] != Empty; iSlot = next(iSlot))
+      if (slots[iSlot] == k)
+         return iterator(this, iSlot);
+   return end();
+}
+
+/*****************************************
+ * INT UNORDERED SET :: INSERT
+ * Probe as find() does, remembering the first tombstone passed so
+ * that a new key can reuse it
+ ****************************************/
+template <typename K, K Empty, K Tombstone, typename Hash, typename A>
+custom::pair<typename int_unordered_set<K, Empty, Tombstone, Hash, A>::iterator, bool>
+int_unordered_set<K, Empty, Tombstone, Hash, A>::insert(K k)
+{
+   check(k);
+
+   // grow, or just sweep out the tombstones, before the probes get long
+   if ((float)(numElements + numTombstones + 1) > maxLoadFactor * (float)slots.size())
+      rehash(numElements + 1 > maxLoadFactor * (float)slots.size() / 2 ? slots.size() * 2 : slots.size());
+
+   size_t iSlot = home(k);
+   size_t iTombstone = slots.size();
+   for (; slots[iSlot] != Empty; iSlot = next(iSlot))
+   {
+      if (slots[iSlot] == k)
+         return custom::pair<iterator, bool>(iterator(this, iSlot), false);
+      if (slots[iSlot] == Tombstone && iTombstone == slots.size())
+         iTombstone = iSlot;
+   }
+
+   if (iTombstone != slots.size())
+   {
+      iSlot = iTombstone;
+      numTombstones--;
+   }
+   slots[iSlot] = k;
+   numElements++;
+   return custom::pair<iterator, bool>(iterator(this, iSlot), true);
+}
+
+/*****************************************
+ * INT UNORDERED SET :: ERASE
+ * A key followed by an empty slot ends every probe through it, so
+ * it can simply become empty; otherwise it becomes a tombstone
+ ****************************************/
+template <typename K, K Empty, K Tombstone, typename Hash, typename A>
+size_t int_unordered_set<K, Empty, Tombstone, Hash, A>::erase(K k)
+{
+   iterator it = find(k);
+   if (it == end())
+      return 0;
+
+   if (slots[next(it.iSlot)] == Empty)
+      slots[it.iSlot] = Empty;
+   else
+   {
+      slots[it.iSlot] = Tombstone;
+      numTombstones++;
+   }
+   numElements--;
+   return 1;
+}
+
+/*****************************************
+ * INT UNORDERED SET :: REHASH
+ * Move every key into at least numSlots slots, enough to keep
+ * under the max load factor, leaving the tombstones behind
+ ****************************************/
+template <typename K, K Empty, K Tombstone, typename Hash, typename A>
+void int_unordered_set<K, Empty, Tombstone, Hash, A>::rehash(size_t numSlots)
+{
+   if ((float)numSlots * maxLoadFactor < (float)numElements + 1)
+      numSlots = (size_t)((float)(numElements + 1) / maxLoadFactor) + 1;
+
+   custom::vector<K, A> slotsOld(slots.get_allocator());
+   slotsOld.swap(slots);
+   allocate(numSlots);
+
+   for (size_t i = 0; i < slotsOld.size(); i++)
+   {
+      K k = slotsOld[i];
+      if (k == Empty || k == Tombstone)
+         continue;
+      size_t iSlot = home(k);
+      while (slots[iSlot] != Empty)
+         iSlot = next(iSlot);
+      slots[iSlot] = k;
+   }
+}
+
+/*****************************************
+ * INT UNORDERED SET :: ALLOCATE
+ * Set up at least numSlots empty slots, a power of two
+ ****************************************/
+template <typename K, K Empty, K Tombstone, typename Hash, typename A>
+void int_unordered_set<K, Empty, Tombstone, Hash, A>::allocate(size_t numSlots)
+{
+   size_t num = 1;
+   numBits = 0;
+   while (num < numSlots)
+   {
+      num *= 2;
+      numBits++;
+   }
+   custom::vector<K, A> slotsNew(num, Empty, slots.get_allocator());
+   slots.swap(slotsNew);
+   numTombstones = 0;
+}
+
+} // namespace custom
@@ -22,6 +22,9 @@
 #include <iostream>    // for nullptr
 #include <new>         // std::bad_alloc
 #include <memory>      // for std::allocator
+#include <memory_resource> // for std::pmr::polymorphic_allocator
+#include <type_traits> // for std::void_t
+#include <utility>     // for std::in_place
 
 class TestList; // forward declaration for unit tests
 class TestHash; // forward declaration for hash used later
@@ -29,6 +32,17 @@ class TestHash; // forward declaration for hash used later
 namespace custom
 {
 
+/**************************************************
+ * IS MONOTONIC ALLOCATOR
+ * An allocator whose deallocate() does nothing says so with
+ * a nested is_monotonic typedef. There is no point in walking
+ * such a list just to free it.
+ **************************************************/
+   template <typename A, typename = void>
+   struct is_monotonic_allocator : std::false_type {};
+   template <typename A>
+   struct is_monotonic_allocator<A, std::void_t<typename A::is_monotonic>> : A::is_monotonic {};
+
 /**************************************************
  * LIST
  * Just like std::list
@@ -38,8 +52,10 @@ namespace custom
    {
       friend class ::TestList; // give unit tests access to the privates
       friend class ::TestHash;
-      friend void swap(list& lhs, list& rhs);
+      template <typename TT, typename AA>
+      friend void swap(list<TT, AA>& lhs, list<TT, AA>& rhs);
    public:
+      typedef A allocator_type;
 
       //
       // Construct
@@ -50,9 +66,12 @@ namespace custom
       {}
       list(list<T, A>& rhs, const A& a = A()) : list(a)
       {
-         *this = rhs;  // rely on assignment
+         // Not through assignment, which needs T to be assignable
+         for (Node* p = rhs.pHead; p; p = p->pNext)
+            push_back(p->data);
       }
-      list(list<T, A>&& rhs, const A& a = A());
+      list(list<T, A>&& rhs) : list(std::move(rhs), rhs.alloc) {}
+      list(list<T, A>&& rhs, const A& a);
       list(size_t num, const T& t, const A& a = A());
       list(size_t num, const A& a = A());
       list(const std::initializer_list<T>& il, const A& a = A()) : list(a)
@@ -92,9 +111,15 @@ namespace custom
       //
 
       class iterator;
+      class const_iterator;
       iterator begin() { return iterator(pHead); }
       iterator rbegin() { return iterator(pTail); }
       iterator end() { return iterator(nullptr); }
+      const_iterator begin()  const { return const_iterator(pHead);   }
+      const_iterator rbegin() const { return const_iterator(pTail);   }
+      const_iterator end()    const { return const_iterator(nullptr); }
+      const_iterator cbegin() const { return const_iterator(pHead);   }
+      const_iterator cend()   const { return const_iterator(nullptr); }
 
       //
       // Access
@@ -111,8 +136,11 @@ namespace custom
       void push_front(T&& data);
       void push_back (const T& data);
       void push_back (T&& data);
+      template <typename ... Args>
+      void emplace_back(Args&& ... args);
       iterator insert(iterator it, const T& data);
       iterator insert(iterator it, T&& data);
+      void splice_back(list& rhs, const iterator& it);
 
       //
       // Remove
@@ -129,10 +157,19 @@ namespace custom
 
       bool empty()  const { return numElements == 0; }
       size_t size() const { return numElements; }
+      A get_allocator() const { return alloc; }
+      static size_t node_size() { return sizeof(Node); }   // bytes per element
 
    private:
       // nested linked list class
       class Node;
+      typedef typename std::allocator_traits<A>::template rebind_alloc<Node> NodeAlloc;
+      typedef std::allocator_traits<NodeAlloc> NodeTraits;
+
+      // every node comes from and goes back to alloc
+      template <typename ... Args>
+      Node* newNode(Args&& ... args);
+      void deleteNode(Node* p);
 
       // member variables
       A     alloc;        // use alloacator for memory allocation
@@ -156,8 +193,10 @@ namespace custom
       // Construct
       //
       Node() : pNext(nullptr), pPrev(nullptr) {}
-      Node(const T& data) : pNext(nullptr), pPrev(nullptr), data(data) {}
-      Node(T&& data) : pNext(nullptr), pPrev(nullptr), data(std::move(data)) {}
+      Node(const T& data) : data(data), pNext(nullptr), pPrev(nullptr) {}
+      Node(T&& data) : data(std::move(data)), pNext(nullptr), pPrev(nullptr) {}
+      template <typename ... Args>
+      Node(std::in_place_t, Args&& ... args) : data(std::forward<Args>(args)...), pNext(nullptr), pPrev(nullptr) {}
 
       //
       // Member Variables
@@ -179,6 +218,7 @@ namespace custom
       friend class ::TestHash;
       template <typename TT, typename AA>
       friend class custom::list;
+      friend class list<T, A>::const_iterator;
 
    public:
       // constructors, destructors, and assignment operator
@@ -241,6 +281,74 @@ namespace custom
       typename list<T, A>::Node* p;
    };
 
+   /*************************************************
+    * LIST CONST ITERATOR
+    * Iterate through a List, constant version. An
+    * iterator converts to one, never the reverse.
+    ************************************************/
+   template <typename T, typename A>
+   class list<T, A>::const_iterator
+   {
+      friend class ::TestList; // give unit tests access to the privates
+      friend class ::TestHash;
+
+   public:
+      // constructors, destructors, and assignment operator
+      const_iterator() : p(nullptr) {}
+      const_iterator(const Node* pRHS) : p(pRHS) {}
+      const_iterator(const iterator& rhs) : p(rhs.p) {}
+      const_iterator(const const_iterator& rhs) : p(rhs.p) {}
+      const_iterator& operator = (const const_iterator& rhs)
+      {
+         p = rhs.p;
+         return *this;
+      }
+
+      // equals, not equals operator
+      bool operator == (const const_iterator& rhs) const { return p == rhs.p; }
+      bool operator != (const const_iterator& rhs) const { return p != rhs.p; }
+
+      // dereference operator, fetch a node
+      const T& operator * () const
+      {
+         return p->data;
+      }
+
+      // postfix increment
+      const_iterator operator ++ (int postfix)
+      {
+         const_iterator temp(*this);
+         p = p->pNext;
+         return temp;
+      }
+
+      // prefix increment
+      const_iterator& operator ++ ()
+      {
+         p = p->pNext;
+         return *this;
+      }
+
+      // postfix decrement
+      const_iterator operator -- (int postfix)
+      {
+         const_iterator temp(*this);
+         p = p->pPrev;
+         return temp;
+      }
+
+      // prefix decrement
+      const_iterator& operator -- ()
+      {
+         p = p->pPrev;
+         return *this;
+      }
+
+   private:
+
+      const typename list<T, A>::Node* p;
+   };
+
    /*****************************************
     * LIST :: NON-DEFAULT constructors
     * Create a list initialized to a value
@@ -263,11 +371,11 @@ namespace custom
       {
          // Can't use push_back() because a T is not initialized.
          // Would be less efficient to initialize a T here and then copy it.
-         pHead = new Node();
+         pHead = newNode();
          Node* p = pHead;
          for (size_t i = 1; i < num; i++)
          {
-            p->pNext = new Node();
+            p->pNext = newNode();
             p->pNext->pPrev = p;
             p = p->pNext;
          }
@@ -278,17 +386,22 @@ namespace custom
 
    /*****************************************
     * LIST :: MOVE constructors
-    * Steal the values from the RHS
+    * Steal the values from the RHS. Nodes can only change hands
+    * when both allocators can free each other's memory; otherwise
+    * move the elements one at a time into our own nodes.
     ****************************************/
    template <typename T, typename A>
-   list<T, A>::list(list<T, A>&& rhs, const A& a) : alloc(a)
+   list<T, A>::list(list<T, A>&& rhs, const A& a) : list(a)
    {
-      pHead = rhs.pHead;
-      pTail = rhs.pTail;
-      numElements = rhs.numElements;
+      if (alloc == rhs.alloc)
+      {
+         swap(rhs);
+         return;
+      }
 
-      rhs.pHead = rhs.pTail = nullptr;
-      rhs.numElements = 0;
+      for (Node* p = rhs.pHead; p; p = p->pNext)
+         push_back(std::move(p->data));
+      rhs.clear();
    }
 
    /**********************************************
@@ -302,7 +415,14 @@ namespace custom
    list<T, A>& list<T, A>::operator = (list<T, A>&& rhs)
    {
       clear();
-      swap(rhs);
+      if (alloc == rhs.alloc)
+         swap(rhs);
+      else
+      {
+         for (Node* p = rhs.pHead; p; p = p->pNext)
+            push_back(std::move(p->data));
+         rhs.clear();
+      }
       return *this;
    }
 
@@ -350,7 +470,7 @@ namespace custom
          while (p != nullptr)
          {
             pNext = p->pNext;
-            delete p;
+            deleteNode(p);
             p = pNext;
             numElements--;
          }
@@ -377,7 +497,7 @@ namespace custom
    list<T, A>& list<T, A>::operator = (const std::initializer_list<T>& rhs)
    {
       // `const std::initializer_list<T>::value_type*` is the same as `std::initializer_list<T>::iterator`
-      const std::initializer_list<T>::value_type* itRHS = rhs.begin();
+      const typename std::initializer_list<T>::value_type* itRHS = rhs.begin();
       list<T, A>::iterator itLHS = begin();
 
       // Fill existing nodes.
@@ -413,7 +533,7 @@ namespace custom
          while (p != nullptr)
          {
             pNext = p->pNext;
-            delete p;
+            deleteNode(p);
             p = pNext;
             numElements--;
          }
@@ -434,18 +554,27 @@ namespace custom
     * Remove all the items currently in the linked list
     *     INPUT  :
     *     OUTPUT :
-    *     COST   : O(n) with respect to the number of nodes
+    *     COST   : O(n) with respect to the number of nodes,
+    *              O(1) with a monotonic allocator and trivial T
     *********************************************/
    template <typename T, typename A>
    void list<T, A>::clear()
    {
+      // Nothing to destroy and nothing to free: just forget the nodes.
+      if constexpr (is_monotonic_allocator<A>::value && std::is_trivially_destructible<T>::value)
+      {
+         pHead = pTail = nullptr;
+         numElements = 0;
+         return;
+      }
+
       list<T, A>::Node* p = pHead;
       list<T, A>::Node* pNext;
 
       while (p)
       {
          pNext = p->pNext;
-         delete p;
+         deleteNode(p);
          p = pNext;
       }
 
@@ -463,7 +592,7 @@ namespace custom
    template <typename T, typename A>
    void list<T, A>::push_back(const T& data)
    {
-      list<T, A>::Node* pNew = new Node(data);
+      list<T, A>::Node* pNew = newNode(data);
 
       pNew->pPrev = pTail;
       if (pTail)
@@ -478,7 +607,30 @@ namespace custom
    template <typename T, typename A>
    void list<T, A>::push_back(T&& data)
    {
-      list<T, A>::Node* pNew(new Node(std::move(data)));
+      list<T, A>::Node* pNew(newNode(std::move(data)));
+
+      pNew->pPrev = pTail;
+      if (pTail)
+         pTail->pNext = pNew;
+      else
+         pHead = pNew;
+
+      pTail = pNew;
+      numElements++;
+   }
+
+   /*********************************************
+    * LIST :: EMPLACE BACK
+    * add an item to the end of the list, built in its node
+    *    INPUT  : the arguments to T's constructor
+    *    OUTPUT :
+    *    COST   : O(1)
+    *********************************************/
+   template <typename T, typename A>
+   template <typename ... Args>
+   void list<T, A>::emplace_back(Args&& ... args)
+   {
+      list<T, A>::Node* pNew(newNode(std::in_place, std::forward<Args>(args)...));
 
       pNew->pPrev = pTail;
       if (pTail)
@@ -490,6 +642,48 @@ namespace custom
       numElements++;
    }
 
+   /*********************************************
+    * LIST :: SPLICE BACK
+    * move the node at it from rhs onto the end of this list.
+    * The node is relinked, not copied, when both lists share
+    * an allocator
+    *     INPUT  : the list holding the node, and the node
+    *     OUTPUT :
+    *     COST   : O(1)
+    *********************************************/
+   template <typename T, typename A>
+   void list<T, A>::splice_back(list& rhs, const iterator& it)
+   {
+      if (!(alloc == rhs.alloc))
+      {
+         push_back(std::move(it.p->data));
+         rhs.erase(it);
+         return;
+      }
+
+      // unhook it from rhs
+      Node* p = it.p;
+      if (p->pPrev)
+         p->pPrev->pNext = p->pNext;
+      else
+         rhs.pHead = p->pNext;
+      if (p->pNext)
+         p->pNext->pPrev = p->pPrev;
+      else
+         rhs.pTail = p->pPrev;
+      rhs.numElements--;
+
+      // and hang it on our tail
+      p->pNext = nullptr;
+      p->pPrev = pTail;
+      if (pTail)
+         pTail->pNext = p;
+      else
+         pHead = p;
+      pTail = p;
+      numElements++;
+   }
+
    /*********************************************
     * LIST :: PUSH FRONT
     * add an item to the head of the list
@@ -500,7 +694,7 @@ namespace custom
    template <typename T, typename A>
    void list<T, A>::push_front(const T& data)
    {
-      list<T, A>::Node* pNew(new Node(data));
+      list<T, A>::Node* pNew(newNode(data));
 
       pNew->pNext = pHead;
       if (pHead)
@@ -515,7 +709,7 @@ namespace custom
    template <typename T, typename A>
    void list<T, A>::push_front(T&& data)
    {
-      list<T, A>::Node* pNew(new Node(std::move(data)));
+      list<T, A>::Node* pNew(newNode(std::move(data)));
 
       pNew->pNext = pHead;
       if (pHead)
@@ -628,7 +822,7 @@ namespace custom
          else
             pHead = pHead->pNext;
 
-         delete it.p;
+         deleteNode(it.p);
          numElements--;
          return itNext;
       }
@@ -646,7 +840,7 @@ namespace custom
    typename list<T, A>::iterator list<T, A>::insert(list<T, A>::iterator it,
                                                     const T& data)
    {
-      list<T, A>::Node* pNew(new Node(data));
+      list<T, A>::Node* pNew(newNode(data));
 
       // Insert into empty list.
       if (empty())
@@ -698,7 +892,7 @@ namespace custom
    typename list<T, A>::iterator list<T, A>::insert(list<T, A>::iterator it,
                                                     T&& data)
    {
-      list<T, A>::Node* pNew(new Node(std::move(data)));
+      list<T, A>::Node* pNew(newNode(std::move(data)));
 
       // Insert into empty list.
       if (empty())
@@ -737,6 +931,46 @@ namespace custom
       return iterator(pNew);
    }
 
+   /*********************************************
+    * LIST :: NEW NODE
+    * Allocate and construct a node through the allocator
+    *     INPUT  : the arguments to the Node constructor
+    *     OUTPUT : the new node, not yet linked into the list
+    *     COST   : O(1)
+    *********************************************/
+   template <typename T, typename A>
+   template <typename ... Args>
+   typename list<T, A>::Node* list<T, A>::newNode(Args&& ... args)
+   {
+      NodeAlloc nodeAlloc(alloc);
+      Node* p = NodeTraits::allocate(nodeAlloc, 1);
+      try
+      {
+         NodeTraits::construct(nodeAlloc, p, std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+         NodeTraits::deallocate(nodeAlloc, p, 1);
+         throw;
+      }
+      return p;
+   }
+
+   /*********************************************
+    * LIST :: DELETE NODE
+    * Destroy and free a node through the allocator
+    *     INPUT  : a node already unlinked from the list
+    *     OUTPUT :
+    *     COST   : O(1)
+    *********************************************/
+   template <typename T, typename A>
+   void list<T, A>::deleteNode(Node* p)
+   {
+      NodeAlloc nodeAlloc(alloc);
+      NodeTraits::destroy(nodeAlloc, p);
+      NodeTraits::deallocate(nodeAlloc, p, 1);
+   }
+
    /**********************************************
     * SWAP - list
     * Swap two lists
@@ -755,6 +989,16 @@ namespace custom
       std::swap(lhs.numElements, rhs.numElements);
    }
 
+   namespace pmr
+   {
+      /**********************************************
+       * PMR LIST
+       * A list whose nodes come from a std::pmr::memory_resource
+       *********************************************/
+      template <typename T>
+      using list = custom::list<T, std::pmr::polymorphic_allocator<T>>;
+   }
+
 }; // namespace custom
 
 
@@ -0,0 +1,165 @@
+/***********************************************************************
+ * Header:
+ *    OCCUPANCY
+ * Summary:
+ *    One bit per bucket, set when the bucket holds anything
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        count_trailing_zeros : The index of the lowest set bit
+ *        occupancy_bitmap     : Which buckets are not empty
+ *
+ *    Walking a table bucket by bucket costs one step per bucket, full
+ *    or not. With the bitmap, a step skips 64 buckets at a time, and
+ *    one ctz lands on the next full one, so iterating a sparse table
+ *    costs about one step per element.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <memory>       // for std::allocator
+#include "vector.h"     // because the words are a vector
+#if defined(_MSC_VER)
+#include <intrin.h>     // for _BitScanForward64
+#endif
+
+class TestHash;         // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * COUNT TRAILING ZEROS
+ * The index of the lowest set bit of x, which must not be 0: one
+ * tzcnt or bsf on x86, one rbit and clz on ARM
+ ************************************************/
+inline unsigned count_trailing_zeros(uint64_t x)
+{
+#if defined(_MSC_VER)
+   unsigned long i;
+   _BitScanForward64(&i, x);
+   return (unsigned)i;
+#else
+   return (unsigned)__builtin_ctzll(x);
+#endif
+}
+
+/************************************************
+ * OCCUPANCY BITMAP
+ * Bit i is set when bucket i is not empty. Bits past the last bucket
+ * are never set, so next() never has to check for them.
+ ************************************************/
+template <typename A = std::allocator<uint64_t>>
+class occupancy_bitmap
+{
+   friend class ::TestHash;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   occupancy_bitmap(size_t numBits = 0, const A& a = A())
+      : numBits(numBits), words(num_words(numBits), a) {}
+
+   //
+   // Assign
+   //
+   void assign(size_t numBits)   // that many bits, all clear
+   {
+      this->numBits = numBits;
+      words.clear();
+      words.resize(num_words(numBits));
+   }
+   void swap(occupancy_bitmap& rhs)
+   {
+      std::swap(numBits, rhs.numBits);
+      std::swap(words, rhs.words);
+   }
+
+   //
+   // Access
+   //
+   bool test(size_t i) const
+   {
+      return (words[i / 64] >> (i % 64)) & 1;
+   }
+   size_t next(size_t i) const    // the first set bit at or after i, or size()
+   {
+      return next(data(), numBits, i);
+   }
+   size_t next(size_t i, size_t iLimit) const   // the same, reading no word past iLimit
+   {
+      size_t iNext = next(data(), iLimit, i);
+      return iNext < iLimit ? iNext : iLimit;
+   }
+   static size_t next(const uint64_t* pWords, size_t numBits, size_t i);
+   const uint64_t* data() const
+   {
+      return words.size() ? &words[0] : nullptr;
+   }
+
+   //
+   // Modify
+   //
+   void mark(size_t i)
+   {
+      words[i / 64] |= (uint64_t)1 << (i % 64);
+   }
+   void unmark(size_t i)
+   {
+      words[i / 64] &= ~((uint64_t)1 << (i % 64));
+   }
+   void clear()
+   {
+      for (size_t i = 0; i < words.size(); i++)
+         words[i] = 0;
+   }
+
+   //
+   // Status
+   //
+   size_t size()  const { return numBits; }
+   size_t bytes() const { return words.capacity() * sizeof(uint64_t); }
+
+private:
+   static size_t num_words(size_t numBits)
+   {
+      return (numBits + 63) / 64;
+   }
+
+   size_t numBits;                     // one per bucket
+   custom::vector<uint64_t, A> words;  // 64 buckets to a word
+};
+
+/*****************************************
+ * OCCUPANCY BITMAP :: NEXT
+ * Mask off the bits below i in its word, then take words until one
+ * is not zero. Static, so that an iterator can carry just the words
+ * and their count, which follow the buckets through a move or swap.
+ ****************************************/
+template <typename A>
+size_t occupancy_bitmap<A>::next(const uint64_t* pWords, size_t numBits, size_t i)
+{
+   if (i >= numBits)
+      return numBits;
+   size_t iWord = i / 64;
+   size_t numWords = num_words(numBits);
+   uint64_t word = pWords[iWord] & (~(uint64_t)0 << (i % 64));
+   while (word == 0)
+   {
+      if (++iWord == numWords)
+         return numBits;
+      word = pWords[iWord];
+   }
+   return iWord * 64 + count_trailing_zeros(word);
+}
+
+} // namespace custom
@@ -33,23 +33,23 @@ public:
    
    // Default Constructor: call the T1, T2 default constructors
    pair(const C& c = C())
-       : first(     ), second(      ), compare(c) {}
+       : compare(c), first(     ), second(      ) {}
    // Non-Default Constructor: call the T1, T2 copy constructors
    pair(const T1 & first, const T2 & second, const C& c = C())
-       : first(first), second(second), compare(c) {}
+       : compare(c), first(first), second(second) {}
    pair(const T1& first, T2 && second, const C& c = C())
-      : first(first), second(std::move(second)), compare(c) {}
+      : compare(c), first(first), second(std::move(second)) {}
    pair(const T1& first, const C& c = C())
-      : first(first), second(), compare(c) {}
+      : compare(c), first(first), second() {}
    // Copy Constructor: call the T1, T2 copy constructors
    pair(const pair <T1, T2> & rhs, const C& c = C())
-       : first(rhs.first), second(rhs.second), compare(c) {}
+       : compare(c), first(rhs.first), second(rhs.second) {}
    // Non-Default Move Constructor: call the T1, T2 move constructors
    pair(T1 && first, T2 && second, const C& c = C())
-       : first(std::move(first)), second(std::move(second)), compare(c) {}
+       : compare(c), first(std::move(first)), second(std::move(second)) {}
    // Move Constructor: call the T1, T2 move constructors
    pair(pair <T1, T2> && rhs, const C& c = C())
-       : first(std::move(rhs.first)), second(std::move(rhs.second)), compare(c) {}
+       : compare(c), first(std::move(rhs.first)), second(std::move(rhs.second)) {}
 
    //
    // Assignment Operators
@@ -0,0 +1,210 @@
+/***********************************************************************
+ * Header:
+ *    PARALLEL
+ * Summary:
+ *    Whole-set scans split across a thread_pool
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the definitions of:
+ *        parallel_for_each : Call f on every element
+ *        parallel_count_if : How many elements pred accepts
+ *        parallel_any_of   : Does pred accept any element?
+ *        parallel_erase_if : Erase every element pred accepts
+ *        parallel_clone    : A copy of the set, its chains copied at once
+ *
+ *    Each cuts the bucket array into chunks of PARALLEL_CHUNK buckets
+ *    and runs them on the pool, which steals chunks to even out long
+ *    chains. f and pred are called from several threads at once, so
+ *    they must be safe to call that way; each gets a const T&.
+ *        custom::thread_pool pool;
+ *        size_t numExpired = custom::parallel_erase_if(pool, us,
+ *           [now](const Session& s) { return s.expires < now; });
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>        // for std::atomic
+#include <cstddef>       // for size_t
+#include <memory>        // for std::allocator
+#include <type_traits>   // for std::is_same
+#include "hash.h"        // for unordered_set
+#include "threadpool.h"  // for thread_pool
+
+namespace custom
+{
+
+// Buckets to a chunk. A multiple of 64, so that no two chunks share
+// a word of the occupancy bitmap.
+const size_t PARALLEL_CHUNK = 1024;
+
+/************************************************
+ * PARALLEL ACCESS
+ * The one door the algorithms below have into an unordered_set
+ ************************************************/
+struct parallel_access
+{
+   template <class Set, class Pred>
+   static size_t erase_buckets_if(Set& us, size_t iBegin, size_t iEnd, Pred& pred)
+   {
+      return us.erase_buckets_if(iBegin, iEnd, pred);
+   }
+   template <class Set>
+   static void erased_from_buckets(Set& us, size_t numErased)
+   {
+      us.erased_from_buckets(numErased);
+   }
+   template <class Set>
+   static void clone_buckets(Set& us, const Set& rhs, size_t iBegin, size_t iEnd)
+   {
+      us.clone_buckets(rhs, iBegin, iEnd);
+   }
+   template <class Set>
+   static void cloned(Set& us, const Set& rhs)
+   {
+      us.cloned(rhs);
+   }
+};
+
+/************************************************
+ * PARALLEL CHUNKS
+ * Run body(iBegin, iEnd) on every chunk of numBuckets buckets
+ ************************************************/
+template <class Body>
+void parallel_chunks(thread_pool& pool, size_t numBuckets, Body body)
+{
+   size_t numChunks = (numBuckets + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+   pool.run(numChunks, [&](size_t iChunk)
+   {
+      size_t iBegin = iChunk * PARALLEL_CHUNK;
+      size_t iEnd = iBegin + PARALLEL_CHUNK < numBuckets ? iBegin + PARALLEL_CHUNK : numBuckets;
+      body(iBegin, iEnd);
+   });
+}
+
+/************************************************
+ * SERIAL CHUNKS
+ * The same chunks, one after another on this thread, for an
+ * allocator that may not be shared between threads
+ ************************************************/
+template <class Body>
+void serial_chunks(size_t numBuckets, Body body)
+{
+   for (size_t iBegin = 0; iBegin < numBuckets; iBegin += PARALLEL_CHUNK)
+      body(iBegin, iBegin + PARALLEL_CHUNK < numBuckets ? iBegin + PARALLEL_CHUNK : numBuckets);
+}
+
+/************************************************
+ * PARALLEL FOR EACH
+ ************************************************/
+template <class Set, class F>
+void parallel_for_each(thread_pool& pool, const Set& us, F f)
+{
+   parallel_chunks(pool, us.bucket_count(), [&](size_t iBegin, size_t iEnd)
+   {
+      for (size_t i = iBegin; i < iEnd; i++)
+         for (auto it = us.cbegin(i); it != us.cend(i); ++it)
+            f(*it);
+   });
+}
+
+/************************************************
+ * PARALLEL COUNT IF
+ * Each chunk counts on its own and adds to the total once
+ ************************************************/
+template <class Set, class Pred>
+size_t parallel_count_if(thread_pool& pool, const Set& us, Pred pred)
+{
+   std::atomic<size_t> total(0);
+   parallel_chunks(pool, us.bucket_count(), [&](size_t iBegin, size_t iEnd)
+   {
+      size_t count = 0;
+      for (size_t i = iBegin; i < iEnd; i++)
+         for (auto it = us.cbegin(i); it != us.cend(i); ++it)
+            if (pred(*it))
+               count++;
+      total.fetch_add(count, std::memory_order_relaxed);
+   });
+   return total.load();
+}
+
+/************************************************
+ * PARALLEL ANY OF
+ * Once one thread finds a match, the rest skip what is left
+ ************************************************/
+template <class Set, class Pred>
+bool parallel_any_of(thread_pool& pool, const Set& us, Pred pred)
+{
+   std::atomic<bool> found(false);
+   parallel_chunks(pool, us.bucket_count(), [&](size_t iBegin, size_t iEnd)
+   {
+      for (size_t i = iBegin; i < iEnd && !found.load(std::memory_order_relaxed); i++)
+         for (auto it = us.cbegin(i); it != us.cend(i); ++it)
+            if (pred(*it))
+            {
+               found.store(true, std::memory_order_relaxed);
+               break;
+            }
+   });
+   return found.load();
+}
+
+/************************************************
+ * PARALLEL ERASE IF
+ * Each chunk's buckets belong to the one thread that runs it, so no
+ * two threads unlink from the same chain. Freeing the nodes is then
+ * the only thing they share, and std::allocator is safe for that. A
+ * memory resource or arena may not be, so with any other allocator
+ * the chunks run one after another on the calling thread. The set
+ * never shrinks here, whatever its min_load_factor. Return how many
+ * elements were erased.
+ ************************************************/
+template <typename T, typename H, typename E, typename A, typename C, class Pred>
+size_t parallel_erase_if(thread_pool& pool, unordered_set<T, H, E, A, C>& us, Pred pred)
+{
+   std::atomic<size_t> total(0);
+   auto body = [&](size_t iBegin, size_t iEnd)
+   {
+      size_t numErased = parallel_access::erase_buckets_if(us, iBegin, iEnd, pred);
+      total.fetch_add(numErased, std::memory_order_relaxed);
+   };
+   if (std::is_same<A, std::allocator<T>>::value)
+      parallel_chunks(pool, us.bucket_count(), body);
+   else
+      serial_chunks(us.bucket_count(), body);
+   parallel_access::erased_from_buckets(us, total.load());
+   return total.load();
+}
+
+/************************************************
+ * PARALLEL CLONE
+ * The same as the copy constructor, but each chunk of buckets is
+ * copied on its own thread. Reading rhs's scattered nodes is most of
+ * the cost of a copy, and the threads wait on those reads together.
+ * Only with std::allocator, which is safe to allocate from on several
+ * threads, do the chunks run in parallel.
+ ************************************************/
+template <typename T, typename H, typename E, typename A, typename C>
+unordered_set<T, H, E, A, C> parallel_clone(thread_pool& pool, const unordered_set<T, H, E, A, C>& rhs)
+{
+   unordered_set<T, H, E, A, C> us(rhs.bucket_count(), rhs.hash_function(), rhs.key_eq(),
+      std::allocator_traits<A>::select_on_container_copy_construction(rhs.get_allocator()));
+   auto body = [&](size_t iBegin, size_t iEnd)
+   {
+      parallel_access::clone_buckets(us, rhs, iBegin, iEnd);
+   };
+   if (std::is_same<A, std::allocator<T>>::value)
+      parallel_chunks(pool, rhs.bucket_count(), body);
+   else
+      serial_chunks(rhs.bucket_count(), body);
+   parallel_access::cloned(us, rhs);
+   return us;
+}
+
+} // namespace custom
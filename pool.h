@@ -0,0 +1,295 @@
+/***********************************************************************
+ * Header:
+ *    POOL
+ * Summary:
+ *    A recycling pool for the nodes of one container
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        node_pool : Fixed-size slabs with an intrusive free list
+ *
+ *    Give each high-churn set its own pool:
+ *        custom::node_pool pool;
+ *        custom::pmr::unordered_set<int> us(&pool);
+ *    A node freed by erase() or clear() goes on the free list and
+ *    the next insert() takes it straight back off, so a set that
+ *    holds steady in size stops calling malloc altogether.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>          // for std::max_align_t
+#include <cstdint>          // for SIZE_MAX
+#include <algorithm>        // for std::sort
+#include <memory_resource>  // for std::pmr::memory_resource
+#include "vector.h"         // for the scratch space in trim()
+
+class TestHash;             // forward declaration for Hash unit tests
+
+namespace custom
+{
+
+/************************************************
+ * NODE POOL
+ * Small requests are rounded up to a multiple of 8 bytes and served
+ * from the size class for that size. Each class carves slabs of
+ * blocksPerSlab blocks and threads the free ones through their own
+ * first bytes. Anything larger, such as a bucket array, goes
+ * straight to upstream.
+ ************************************************/
+class node_pool : public std::pmr::memory_resource
+{
+   friend class ::TestHash;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   node_pool(size_t blocksPerSlab = 256,
+             std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : upstream(upstream), blocksPerSlab(blocksPerSlab ? blocksPerSlab : 1)
+   {}
+   node_pool(const node_pool& rhs) = delete;
+   node_pool& operator = (const node_pool& rhs) = delete;
+   ~node_pool()
+   {
+      release();
+   }
+
+   //
+   // Remove
+   //
+   void trim();
+   void release() noexcept;
+
+   //
+   // Status
+   //
+   size_t bytes_in_use() const
+   {
+      size_t num = 0;
+      for (size_t c = 0; c < NUM_CLASSES; c++)
+         num += classes[c].numInUse * block_size(c);
+      return num;
+   }
+   size_t bytes_reserved() const
+   {
+      size_t num = 0;
+      for (size_t c = 0; c < NUM_CLASSES; c++)
+         num += classes[c].numBlocks * block_size(c);
+      return num;
+   }
+   size_t high_water_mark() const
+   {
+      size_t num = 0;
+      for (size_t c = 0; c < NUM_CLASSES; c++)
+         num += classes[c].numHighWater * block_size(c);
+      return num;
+   }
+
+private:
+   static const size_t GRANULE = 8;                     // block sizes are a multiple of this
+   static const size_t MAX_BLOCK = 256;                 // larger requests go upstream
+   static const size_t NUM_CLASSES = MAX_BLOCK / GRANULE;
+
+   // the first bytes of a free block point to the next free block
+   struct Block
+   {
+      Block* pNext;
+   };
+
+   // a slab header sits in front of its blocks
+   struct alignas(std::max_align_t) Slab
+   {
+      Slab* pNext;
+   };
+
+   // everything about the blocks of one size
+   struct SizeClass
+   {
+      Block* pFree = nullptr;      // the next block to hand out
+      Slab* pSlabs = nullptr;      // every slab of this size
+      size_t numBlocks = 0;        // blocks in all the slabs
+      size_t numInUse = 0;         // blocks handed out and not yet returned
+      size_t numHighWater = 0;     // most blocks in use since the last trim
+   };
+
+   static size_t block_size(size_t c)  { return (c + 1) * GRANULE; }
+   size_t slab_size(size_t c) const    { return sizeof(Slab) + blocksPerSlab * block_size(c); }
+
+   // which size class serves this request, NUM_CLASSES for none
+   static size_t size_class(size_t bytes, size_t alignment)
+   {
+      if (bytes > MAX_BLOCK || alignment > alignof(std::max_align_t))
+         return NUM_CLASSES;
+      size_t c = bytes ? (bytes - 1) / GRANULE : 0;
+      if (alignment > GRANULE && block_size(c) % alignment != 0)
+         return NUM_CLASSES;
+      return c;
+   }
+
+   void* do_allocate(size_t bytes, size_t alignment) override
+   {
+      size_t c = size_class(bytes, alignment);
+      if (c == NUM_CLASSES)
+         return upstream->allocate(bytes, alignment);
+
+      SizeClass& sc = classes[c];
+      if (!sc.pFree)
+         grow(c);
+      Block* p = sc.pFree;
+      sc.pFree = p->pNext;
+      if (++sc.numInUse > sc.numHighWater)
+         sc.numHighWater = sc.numInUse;
+      return p;
+   }
+
+   void do_deallocate(void* p, size_t bytes, size_t alignment) override
+   {
+      size_t c = size_class(bytes, alignment);
+      if (c == NUM_CLASSES)
+      {
+         upstream->deallocate(p, bytes, alignment);
+         return;
+      }
+
+      SizeClass& sc = classes[c];
+      Block* pBlock = (Block*)p;
+      pBlock->pNext = sc.pFree;
+      sc.pFree = pBlock;
+      sc.numInUse--;
+   }
+
+   bool do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override
+   {
+      return this == &rhs;
+   }
+
+   void grow(size_t c);
+   void trim(size_t c);
+
+   std::pmr::memory_resource* upstream;   // where the slabs come from
+   size_t blocksPerSlab;                  // blocks carved from each slab
+   SizeClass classes[NUM_CLASSES];        // one per block size
+};
+
+/************************************************
+ * NODE POOL :: GROW
+ * Add a slab to a size class. Its blocks go on the free list in
+ * address order so that a run of inserts fills it front to back.
+ ************************************************/
+inline void node_pool::grow(size_t c)
+{
+   SizeClass& sc = classes[c];
+   Slab* pSlab = (Slab*)upstream->allocate(slab_size(c), alignof(Slab));
+   pSlab->pNext = sc.pSlabs;
+   sc.pSlabs = pSlab;
+
+   char* pFirst = (char*)(pSlab + 1);
+   for (size_t i = blocksPerSlab; i > 0; i--)
+   {
+      Block* p = (Block*)(pFirst + (i - 1) * block_size(c));
+      p->pNext = sc.pFree;
+      sc.pFree = p;
+   }
+   sc.numBlocks += blocksPerSlab;
+}
+
+/************************************************
+ * NODE POOL :: TRIM
+ * Give back the slabs that went unused since the last trim. Keep
+ * enough free blocks to reach the high-water mark again, release
+ * wholly free slabs beyond that, and start a new high-water mark.
+ * Call it periodically: a set that peaks every few seconds keeps
+ * its memory, one whose burst has passed gives it back.
+ ************************************************/
+inline void node_pool::trim()
+{
+   for (size_t c = 0; c < NUM_CLASSES; c++)
+   {
+      trim(c);
+      classes[c].numHighWater = classes[c].numInUse;
+   }
+}
+
+inline void node_pool::trim(size_t c)
+{
+   SizeClass& sc = classes[c];
+   size_t numSpare = sc.numBlocks - sc.numHighWater;
+   if (numSpare < blocksPerSlab)
+      return;
+
+   // Sort the slabs by address so a block can find its slab.
+   custom::vector<Slab*> slabs;
+   for (Slab* p = sc.pSlabs; p; p = p->pNext)
+      slabs.push_back(p);
+   Slab** pBegin = &slabs[0];
+   Slab** pEnd = pBegin + slabs.size();
+   std::sort(pBegin, pEnd);
+
+   // Count the free blocks in each slab.
+   custom::vector<size_t> numFree(slabs.size(), (size_t)0);
+   for (Block* p = sc.pFree; p; p = p->pNext)
+      numFree[std::upper_bound(pBegin, pEnd, (Slab*)p) - pBegin - 1]++;
+
+   // Choose wholly free slabs until only the spare blocks remain.
+   for (size_t i = 0; i < slabs.size() && numSpare >= blocksPerSlab; i++)
+      if (numFree[i] == blocksPerSlab)
+      {
+         numFree[i] = SIZE_MAX;
+         numSpare -= blocksPerSlab;
+      }
+
+   // Unthread the doomed blocks from the free list.
+   Block** ppFree = &sc.pFree;
+   while (*ppFree)
+   {
+      if (numFree[std::upper_bound(pBegin, pEnd, (Slab*)*ppFree) - pBegin - 1] == SIZE_MAX)
+         *ppFree = (*ppFree)->pNext;
+      else
+         ppFree = &(*ppFree)->pNext;
+   }
+
+   // Release them and relink the slabs we keep.
+   sc.pSlabs = nullptr;
+   for (size_t i = 0; i < slabs.size(); i++)
+   {
+      if (numFree[i] == SIZE_MAX)
+      {
+         upstream->deallocate(slabs[i], slab_size(c), alignof(Slab));
+         sc.numBlocks -= blocksPerSlab;
+      }
+      else
+      {
+         slabs[i]->pNext = sc.pSlabs;
+         sc.pSlabs = slabs[i];
+      }
+   }
+}
+
+/************************************************
+ * NODE POOL :: RELEASE
+ * Give every slab back, whether or not its blocks are in use
+ ************************************************/
+inline void node_pool::release() noexcept
+{
+   for (size_t c = 0; c < NUM_CLASSES; c++)
+   {
+      SizeClass& sc = classes[c];
+      while (sc.pSlabs)
+      {
+         Slab* p = sc.pSlabs;
+         sc.pSlabs = p->pNext;
+         upstream->deallocate(p, slab_size(c), alignof(Slab));
+      }
+      sc = SizeClass();
+   }
+}
+
+} // namespace custom
@@ -0,0 +1,455 @@
+/***********************************************************************
+ * Header:
+ *    SNAPSHOT
+ * Summary:
+ *    The binary encoding used to save and load an unordered_set
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the definitions of:
+ *        crc32c          : CRC-32C (Castagnoli) checksum of a buffer
+ *        snapshot_codec  : How one element is written to a snapshot
+ *        snapshot_writer : Buffers elements into checksummed blocks
+ *        snapshot_reader : Reads and verifies checksummed blocks
+ *
+ *    A snapshot is a fixed header followed by a sequence of blocks:
+ *        header : "CUS2" numElements(8) numBuckets(8) maxLoadFactor(4) crc32c(4)
+ *        block  : count(4) numBytes(4) payload(numBytes) crc32c(4)
+ *    All fixed-width fields are little endian. The header checksum
+ *    covers the 24 bytes before it; a block checksum covers the
+ *    count, numBytes and the payload of its own block. A block with
+ *    a count of zero marks the end of the snapshot. A block holds at
+ *    most SNAPSHOT_BLOCK_ELEMENTS elements and SNAPSHOT_MAX_BLOCK_BYTES
+ *    bytes of payload, so a reader never allocates more than that
+ *    on the word of the file.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>      // for uint32_t and friends
+#include <cstring>      // for std::memcpy
+#include <string>       // for std::string
+#include <istream>      // for std::istream
+#include <ostream>      // for std::ostream
+#include <type_traits>  // for std::is_integral
+#ifdef _WIN32
+#include <io.h>         // for _read and _write
+#else
+#include <unistd.h>     // for read and write
+#include <cerrno>       // for EINTR
+#endif // _WIN32
+
+namespace custom
+{
+
+/**********************************************
+ * CRC32C
+ * The Castagnoli polynomial (0x82F63B78, reflected), one table
+ * lookup per byte. Pass the previous result as crc to continue
+ * a checksum across several buffers.
+ ***********************************************/
+inline uint32_t crc32c(const char* data, size_t num, uint32_t crc = 0)
+{
+   struct Table
+   {
+      uint32_t entries[256];
+      Table()
+      {
+         for (uint32_t i = 0; i < 256; i++)
+         {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; bit++)
+               c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : (c >> 1);
+            entries[i] = c;
+         }
+      }
+   };
+   static const Table table;
+
+   crc = ~crc;
+   for (size_t i = 0; i < num; i++)
+      crc = table.entries[(crc ^ (unsigned char)data[i]) & 0xFF] ^ (crc >> 8);
+   return ~crc;
+}
+
+/**********************************************
+ * VARINT
+ * Seven bits per byte, the high bit set on every byte but the
+ * last. Small numbers take a single byte.
+ ***********************************************/
+inline void varint_encode(std::string& out, uint64_t value)
+{
+   while (value >= 0x80)
+   {
+      out.push_back((char)((value & 0x7F) | 0x80));
+      value >>= 7;
+   }
+   out.push_back((char)value);
+}
+
+inline bool varint_decode(const char*& p, const char* pEnd, uint64_t& value)
+{
+   value = 0;
+   for (int shift = 0; shift < 64 && p != pEnd; shift += 7)
+   {
+      unsigned char byte = (unsigned char)*p++;
+      value |= (uint64_t)(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+         return true;
+   }
+   return false;
+}
+
+/**********************************************
+ * SNAPSHOT CODEC
+ * Encode and decode one element. A codec may carry state from
+ * one element to the next; reset() is called at the start of
+ * every block so that each block decodes on its own.
+ *
+ * Types without a codec cannot be saved or loaded, but the rest
+ * of unordered_set works on them just the same.
+ ***********************************************/
+template <typename T, typename Enable = void>
+struct snapshot_codec;
+
+/**********************************************
+ * SNAPSHOT CODEC : INTEGRAL
+ * Store the zig-zag encoded difference from the previous element
+ * as a varint. Neighboring buckets tend to hold neighboring
+ * values, so most differences fit in one or two bytes.
+ ***********************************************/
+template <typename T>
+struct snapshot_codec<T, typename std::enable_if<std::is_integral<T>::value &&
+                                                 !std::is_same<T, bool>::value>::type>
+{
+   typedef typename std::make_unsigned<T>::type U;
+
+   void reset() { prev = 0; }
+
+   void encode(std::string& out, const T& t)
+   {
+      int64_t delta = (int64_t)(typename std::make_signed<U>::type)(U)((U)t - prev);
+      varint_encode(out, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+      prev = (U)t;
+   }
+
+   bool decode(const char*& p, const char* pEnd, T& t)
+   {
+      uint64_t zigzag;
+      if (!varint_decode(p, pEnd, zigzag))
+         return false;
+      uint64_t delta = (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+      prev = (U)(prev + (U)delta);
+      t = (T)prev;
+      return true;
+   }
+
+   U prev = 0;   // the previous element in this block
+};
+
+/**********************************************
+ * SNAPSHOT CODEC : STRING
+ * A varint length followed by the raw characters
+ ***********************************************/
+template <>
+struct snapshot_codec<std::string>
+{
+   void reset() {}
+
+   void encode(std::string& out, const std::string& t)
+   {
+      varint_encode(out, t.size());
+      out.append(t);
+   }
+
+   bool decode(const char*& p, const char* pEnd, std::string& t)
+   {
+      uint64_t num;
+      if (!varint_decode(p, pEnd, num) || num > (uint64_t)(pEnd - p))
+         return false;
+      t.assign(p, (size_t)num);
+      p += num;
+      return true;
+   }
+};
+
+/**********************************************
+ * LITTLE ENDIAN
+ * Fixed-width fields in the header and block framing
+ ***********************************************/
+inline void put_u32(char* p, uint32_t value)
+{
+   for (int i = 0; i < 4; i++)
+      p[i] = (char)(value >> (8 * i));
+}
+
+inline uint32_t get_u32(const char* p)
+{
+   uint32_t value = 0;
+   for (int i = 0; i < 4; i++)
+      value |= (uint32_t)(unsigned char)p[i] << (8 * i);
+   return value;
+}
+
+inline void put_u64(char* p, uint64_t value)
+{
+   put_u32(p,     (uint32_t)value);
+   put_u32(p + 4, (uint32_t)(value >> 32));
+}
+
+inline uint64_t get_u64(const char* p)
+{
+   return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+/**********************************************
+ * SNAPSHOT SINKS and SOURCES
+ * Where the bytes go to and come from. A sink returns false when
+ * a write fails; a source returns false when it cannot deliver
+ * exactly the number of bytes asked for.
+ ***********************************************/
+class snapshot_ostream_sink
+{
+public:
+   snapshot_ostream_sink(std::ostream& out) : out(out) {}
+   bool write(const char* p, size_t num)
+   {
+      return (bool)out.write(p, (std::streamsize)num);
+   }
+private:
+   std::ostream& out;
+};
+
+class snapshot_istream_source
+{
+public:
+   snapshot_istream_source(std::istream& in) : in(in) {}
+   bool read(char* p, size_t num)
+   {
+      return (bool)in.read(p, (std::streamsize)num);
+   }
+private:
+   std::istream& in;
+};
+
+class snapshot_fd_sink
+{
+public:
+   snapshot_fd_sink(int fd) : fd(fd) {}
+   bool write(const char* p, size_t num)
+   {
+      while (num)
+      {
+#ifdef _WIN32
+         int numWritten = _write(fd, p, (unsigned int)num);
+#else
+         ssize_t numWritten = ::write(fd, p, num);
+         if (numWritten < 0 && errno == EINTR)
+            continue;
+#endif // _WIN32
+         if (numWritten <= 0)
+            return false;
+         p   += numWritten;
+         num -= (size_t)numWritten;
+      }
+      return true;
+   }
+private:
+   int fd;
+};
+
+class snapshot_fd_source
+{
+public:
+   snapshot_fd_source(int fd) : fd(fd) {}
+   bool read(char* p, size_t num)
+   {
+      while (num)
+      {
+#ifdef _WIN32
+         int numRead = _read(fd, p, (unsigned int)num);
+#else
+         ssize_t numRead = ::read(fd, p, num);
+         if (numRead < 0 && errno == EINTR)
+            continue;
+#endif // _WIN32
+         if (numRead <= 0)
+            return false;
+         p   += numRead;
+         num -= (size_t)numRead;
+      }
+      return true;
+   }
+private:
+   int fd;
+};
+
+/**********************************************
+ * SNAPSHOT LIMITS
+ * The writer flushes a block at whichever of the first two comes
+ * first. The reader rejects a block past either limit, which no
+ * writer makes, before allocating anything for it.
+ ***********************************************/
+const uint32_t SNAPSHOT_BLOCK_ELEMENTS = 4096;           // elements to a block
+const size_t SNAPSHOT_BLOCK_BYTES = 1 << 20;             // payload that ends a block early
+const size_t SNAPSHOT_MAX_BLOCK_BYTES = 64 << 20;        // payload no block may pass
+
+/**********************************************
+ * SNAPSHOT HEADER
+ * What load() needs to size the table before the first element
+ ***********************************************/
+struct snapshot_header
+{
+   static const size_t SIZE = 28;
+
+   uint64_t numElements;
+   uint64_t numBuckets;
+   float    maxLoadFactor;
+};
+
+/**********************************************
+ * SNAPSHOT WRITER
+ * Collect encoded elements into a block and flush the block,
+ * checksum and all, once it is full.
+ ***********************************************/
+template <typename T, typename Sink>
+class snapshot_writer
+{
+public:
+   snapshot_writer(Sink& sink) : sink(sink), count(0), ok(true)
+   {
+      buffer.resize(8);
+      codec.reset();
+   }
+
+   bool header(const snapshot_header& h)
+   {
+      char bytes[snapshot_header::SIZE];
+      std::memcpy(bytes, "CUS2", 4);
+      put_u64(bytes + 4,  h.numElements);
+      put_u64(bytes + 12, h.numBuckets);
+      uint32_t bits;
+      std::memcpy(&bits, &h.maxLoadFactor, 4);
+      put_u32(bytes + 20, bits);
+      put_u32(bytes + 24, crc32c(bytes, 24));
+      return ok = ok && sink.write(bytes, sizeof(bytes));
+   }
+
+   void push(const T& t)
+   {
+      codec.encode(buffer, t);
+      if (++count == SNAPSHOT_BLOCK_ELEMENTS || buffer.size() - 8 >= SNAPSHOT_BLOCK_BYTES)
+         flush();
+   }
+
+   // write out the last partial block and the end marker
+   bool finish()
+   {
+      if (count)
+         flush();
+      flush();
+      return ok;
+   }
+
+private:
+   void flush()
+   {
+      // One element too big for any block: no reader would take it
+      if (buffer.size() - 8 > SNAPSHOT_MAX_BLOCK_BYTES)
+         ok = false;
+      put_u32(&buffer[0], count);
+      put_u32(&buffer[4], (uint32_t)(buffer.size() - 8));
+      char crc[4];
+      put_u32(crc, crc32c(buffer.data(), buffer.size()));
+      ok = ok && sink.write(buffer.data(), buffer.size()) && sink.write(crc, 4);
+
+      buffer.resize(8);
+      count = 0;
+      codec.reset();
+   }
+
+   Sink& sink;
+   snapshot_codec<T> codec;
+   std::string buffer;    // framing followed by the encoded elements
+   uint32_t count;        // elements in the current block
+   bool ok;               // has every write succeeded so far?
+};
+
+/**********************************************
+ * SNAPSHOT READER
+ * Verify each block against its checksum before handing out the
+ * elements in it. Errors are thrown as strings, like the rest of
+ * the library does.
+ ***********************************************/
+template <typename T, typename Source>
+class snapshot_reader
+{
+public:
+   snapshot_reader(Source& source) : source(source), count(0), p(nullptr), pEnd(nullptr)
+   {}
+
+   snapshot_header header()
+   {
+      char bytes[snapshot_header::SIZE];
+      if (!source.read(bytes, sizeof(bytes)) || std::memcmp(bytes, "CUS2", 4) != 0)
+         throw "ERROR: not an unordered_set snapshot";
+      if (crc32c(bytes, 24) != get_u32(bytes + 24))
+         throw "ERROR: checksum mismatch in unordered_set snapshot";
+      snapshot_header h;
+      h.numElements = get_u64(bytes + 4);
+      h.numBuckets  = get_u64(bytes + 12);
+      uint32_t bits = get_u32(bytes + 20);
+      std::memcpy(&h.maxLoadFactor, &bits, 4);
+      return h;
+   }
+
+   // fetch the next element, false at the end of the snapshot
+   bool next(T& t)
+   {
+      if (count == 0 && !block())
+         return false;
+      if (!codec.decode(p, pEnd, t))
+         throw "ERROR: malformed element in unordered_set snapshot";
+      count--;
+      return true;
+   }
+
+private:
+   bool block()
+   {
+      char framing[8];
+      if (!source.read(framing, 8))
+         throw "ERROR: truncated unordered_set snapshot";
+      count = get_u32(framing);
+      size_t numBytes = get_u32(framing + 4);
+      if (count > SNAPSHOT_BLOCK_ELEMENTS || numBytes > SNAPSHOT_MAX_BLOCK_BYTES)
+         throw "ERROR: malformed block in unordered_set snapshot";
+
+      buffer.resize(numBytes + 4);
+      if (!source.read(&buffer[0], buffer.size()))
+         throw "ERROR: truncated unordered_set snapshot";
+      uint32_t crc = crc32c(buffer.data(), numBytes, crc32c(framing, 8));
+      if (crc != get_u32(buffer.data() + numBytes))
+         throw "ERROR: checksum mismatch in unordered_set snapshot";
+
+      p = buffer.data();
+      pEnd = p + numBytes;
+      codec.reset();
+      return count != 0;
+   }
+
+   Source& source;
+   snapshot_codec<T> codec;
+   std::string buffer;    // payload and checksum of the current block
+   uint32_t count;        // elements left in the current block
+   const char* p;         // the next encoded element
+   const char* pEnd;      // end of the payload
+};
+
+} // namespace custom
@@ -0,0 +1,236 @@
+/***********************************************************************
+ * Header:
+ *    STATIC HASH
+ * Summary:
+ *    An unordered set whose table is built by the compiler
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        static_hash                : A hash that works in a constant expression
+ *        static_unordered_set       : A fixed set laid out at compile time
+ *        make_static_unordered_set  : Build one from a braced list
+ *
+ *    Keyword and opcode tables never change after they are written,
+ *    so there is no reason to build them at startup. Declare one
+ *    constexpr at namespace scope:
+ *        constexpr auto keywords = custom::make_static_unordered_set<std::string_view>(
+ *           { "if", "else", "while", "for", "return" });
+ *    and the table is computed while compiling and placed in .rodata.
+ *    Nothing is allocated and nothing runs before main().
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint32_t and uint64_t
+#include <functional>   // for std::equal_to
+#include <string_view>  // for std::string_view
+#include <type_traits>  // for std::is_integral
+
+class TestStaticHash;   // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * STATIC HASH
+ * A hash that can run in a constant expression: the key itself for
+ * integers and enums, FNV-1a for strings. The set mixes the result
+ * before using it, so these only need to be distinct, not random.
+ ************************************************/
+template <typename T>
+struct static_hash
+{
+   static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                 "static_hash needs an integer, an enum, or a string_view");
+   constexpr size_t operator () (const T& t) const
+   {
+      return (size_t)t;
+   }
+};
+
+template <>
+struct static_hash<std::string_view>
+{
+   constexpr size_t operator () (std::string_view s) const
+   {
+      uint64_t h = 0xcbf29ce484222325ull;
+      for (size_t i = 0; i < s.size(); i++)
+      {
+         h ^= (unsigned char)s[i];
+         h *= 0x100000001b3ull;
+      }
+      return (size_t)h;
+   }
+};
+
+/************************************************
+ * STATIC NUM SLOTS
+ * Twice the keys, rounded up to a power of two
+ ************************************************/
+constexpr size_t static_num_slots(size_t numKeys)
+{
+   size_t num = 1;
+   while (num < 2 * numKeys)
+      num *= 2;
+   return num;
+}
+
+/************************************************
+ * STATIC UNORDERED SET
+ * N keys in a table of twice as many slots, rounded up to a power
+ * of two, with linear probing. While building, a handful of seeds
+ * are tried and the one with the shortest longest probe is kept,
+ * so a miss gives up after maxProbe slots rather than at an empty
+ * one. Each slot is an index into keys, which holds the distinct
+ * keys in the order they were listed.
+ ************************************************/
+template <typename T, size_t N,
+   typename Hash = static_hash<T>,
+   typename EqPred = std::equal_to<T>>
+class static_unordered_set
+{
+   friend class ::TestStaticHash;   // give unit tests access to the privates
+public:
+   static_assert(N > 0, "a static_unordered_set needs at least one key");
+   static_assert(N < 0xFFFFFFFFu, "a static_unordered_set holds under 4 billion keys");
+
+   static constexpr size_t NUM_SLOTS = static_num_slots(N);
+   static constexpr int NUM_SEEDS = 16;   // seeds tried while building
+
+   //
+   // Construct
+   //
+   constexpr static_unordered_set(const T (&list)[N])
+      : keys{}, slots{}, numElements(0), seed(0), maxProbe(0)
+   {
+      // keep the first of any duplicates
+      for (size_t i = 0; i < N; i++)
+      {
+         bool isDuplicate = false;
+         for (size_t j = 0; j < numElements && !isDuplicate; j++)
+            isDuplicate = EqPred()(keys[j], list[i]);
+         if (!isDuplicate)
+            keys[numElements++] = list[i];
+      }
+
+      // find the seed with the shortest longest probe, then use it
+      size_t bestProbe = NUM_SLOTS + 1;
+      uint64_t bestSeed = 0;
+      for (uint64_t s = 0; s < NUM_SEEDS && bestProbe > 1; s++)
+      {
+         size_t probe = fill(s);
+         if (probe < bestProbe)
+         {
+            bestProbe = probe;
+            bestSeed = s;
+         }
+      }
+      maxProbe = fill(bestSeed);
+      seed = bestSeed;
+   }
+
+   //
+   // Iterator
+   //
+   typedef const T* iterator;
+   constexpr iterator begin() const { return keys;               }
+   constexpr iterator end()   const { return keys + numElements; }
+
+   //
+   // Access
+   //
+   constexpr iterator find(const T& t) const
+   {
+      size_t iSlot = home(t, seed);
+      for (size_t i = 0; i < maxProbe; i++)
+      {
+         uint32_t iKey = slots[iSlot];
+         if (iKey == EMPTY)
+            break;
+         if (EqPred()(keys[iKey], t))
+            return keys + iKey;
+         iSlot = (iSlot + 1) & (NUM_SLOTS - 1);
+      }
+      return end();
+   }
+   constexpr bool contains(const T& t) const
+   {
+      return find(t) != end();
+   }
+
+   //
+   // Status
+   //
+   constexpr size_t size()         const { return numElements;      }
+   constexpr bool   empty()        const { return numElements == 0; }
+   constexpr size_t bucket_count() const { return NUM_SLOTS;        }
+   constexpr size_t max_probe()    const { return maxProbe;         }
+
+private:
+   static constexpr uint32_t EMPTY = 0xFFFFFFFFu;   // a slot with no key
+
+   // the murmur3 finalizer over the user's hash and the seed
+   static constexpr size_t home(const T& t, uint64_t seed)
+   {
+      uint64_t h = (uint64_t)Hash()(t) + seed * 0x9E3779B97F4A7C15ull;
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdull;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ull;
+      h ^= h >> 33;
+      return (size_t)(h & (NUM_SLOTS - 1));
+   }
+
+   // lay the keys out with this seed, returning the longest probe
+   constexpr size_t fill(uint64_t s)
+   {
+      for (size_t i = 0; i < NUM_SLOTS; i++)
+         slots[i] = EMPTY;
+
+      size_t longest = 0;
+      for (size_t iKey = 0; iKey < numElements; iKey++)
+      {
+         size_t iSlot = home(keys[iKey], s);
+         size_t probe = 1;
+         while (slots[iSlot] != EMPTY)
+         {
+            iSlot = (iSlot + 1) & (NUM_SLOTS - 1);
+            probe++;
+         }
+         slots[iSlot] = (uint32_t)iKey;
+         if (probe > longest)
+            longest = probe;
+      }
+      return longest;
+   }
+
+   T keys[N];                   // the distinct keys, in the order given
+   uint32_t slots[NUM_SLOTS];   // index into keys, or EMPTY
+   size_t numElements;          // number of distinct keys
+   uint64_t seed;               // the seed the table was laid out with
+   size_t maxProbe;             // the most slots any lookup has to look at
+};
+
+/************************************************
+ * MAKE STATIC UNORDERED SET
+ * Deduce N from a braced list:
+ *    constexpr auto ops = make_static_unordered_set<int>({ 1, 2, 3 });
+ ************************************************/
+template <typename T,
+   typename Hash = static_hash<T>,
+   typename EqPred = std::equal_to<T>,
+   size_t N>
+constexpr static_unordered_set<T, N, Hash, EqPred> make_static_unordered_set(const T (&list)[N])
+{
+   return static_unordered_set<T, N, Hash, EqPred>(list);
+}
+
+} // namespace custom
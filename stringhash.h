@@ -0,0 +1,451 @@
+/***********************************************************************
+ * Header:
+ *    STRING HASH
+ * Summary:
+ *    An unordered set of strings whose bytes live in one shared store
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        string_unordered_set           : A flat set of strings over a byte store
+ *        string_unordered_set::iterator : An iterator through the set
+ *
+ *    unordered_set<std::string> allocates a node for every key and,
+ *    past the small-string buffer, the string allocates again. Here
+ *    the key bytes are appended to one contiguous store and each slot
+ *    of a flat table holds the hash, the length, the offset into the
+ *    store, and the first 8 bytes. A probe rejects nearly every
+ *    mismatch on the hash or those 8 bytes without touching the
+ *    store, and keys of 8 bytes or less never go to the store at all.
+ *
+ *    Lookups take a std::string_view, so a key need not be copied
+ *    into a std::string to be looked up:
+ *        custom::string_unordered_set urls;
+ *        urls.insert(line.substr(0, end));   // line is a string_view
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>      // for uint32_t and uint64_t
+#include <cstring>      // for memcpy and memcmp
+#include <functional>   // for std::hash
+#include <memory>       // for std::allocator
+#include <string>       // for std::string, to copy a key out of the store
+#include <string_view>  // for std::string_view
+#include "vector.h"     // because the slots and the store are vectors
+#include "pair.h"       // because insert() returns a pair
+
+class TestStringHash;   // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * STRING UNORDERED SET
+ * Linear probing over a power-of-two array of slots. Erasing leaves
+ * a tombstone and leaves the key bytes in the store; a rehash
+ * drops the tombstones and, once at least half the store is dead,
+ * copies the live keys into a fresh one.
+ ************************************************/
+template <typename Hash = std::hash<std::string_view>,
+   typename A = std::allocator<char>>
+class string_unordered_set
+{
+   friend class ::TestStringHash;   // give unit tests access to the privates
+public:
+   static const size_t INLINE = 8;   // bytes of every key kept in its slot
+
+   //
+   // Construct
+   //
+   string_unordered_set(const A& a = A())
+      : slots(SlotAlloc(a)), store(a), numElements(0), numTombstones(0), numDead(0), shift(64)
+   {
+      allocate(8);
+   }
+   string_unordered_set(size_t numSlots, const A& a = A())
+      : slots(SlotAlloc(a)), store(a), numElements(0), numTombstones(0), numDead(0), shift(64)
+   {
+      allocate(numSlots);
+   }
+   string_unordered_set(const std::initializer_list<std::string_view>& il, const A& a = A())
+      : string_unordered_set(a)
+   {
+      reserve(il.size());
+      for (auto it = il.begin(); it != il.end(); ++it)
+         insert(*it);
+   }
+
+   //
+   // Assign
+   //
+   void swap(string_unordered_set& rhs)
+   {
+      slots.swap(rhs.slots);
+      store.swap(rhs.store);
+      std::swap(numElements, rhs.numElements);
+      std::swap(numTombstones, rhs.numTombstones);
+      std::swap(numDead, rhs.numDead);
+      std::swap(shift, rhs.shift);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const
+   {
+      return iterator(this, 0).settle();
+   }
+   iterator end() const
+   {
+      return iterator(this, slots.size());
+   }
+
+   //
+   // Access
+   //
+   iterator find(std::string_view s) const;
+
+   //
+   // Insert
+   //
+   custom::pair<iterator, bool> insert(std::string_view s);
+   void rehash(size_t numSlots);
+   void reserve(size_t num)
+   {
+      size_t numSlots = num * 4 / 3 + 1;
+      if (numSlots > slots.size())
+         rehash(numSlots);
+   }
+
+   //
+   // Remove
+   //
+   void clear()
+   {
+      for (size_t i = 0; i < slots.size(); i++)
+         slots[i].length = EMPTY;
+      store.clear();
+      numElements = 0;
+      numTombstones = 0;
+      numDead = 0;
+   }
+   size_t erase(std::string_view s);
+
+   //
+   // Status
+   //
+   size_t size()          const { return numElements;      }
+   bool   empty()         const { return numElements == 0; }
+   size_t bucket_count()  const { return slots.size();     }
+   float  load_factor()   const { return (float)numElements / (float)slots.size(); }
+   size_t bytes_stored()  const { return store.size();     }
+
+private:
+   // one key: everything a probe needs to reject it, and where the rest is
+   struct Slot
+   {
+      uint64_t hash;          // the full hash of the key
+      uint64_t offset;        // where the key starts in the store
+      uint32_t length;        // the length of the key, EMPTY, or TOMBSTONE
+      char prefix[INLINE];    // the first bytes of the key, zero filled
+   };
+
+   typedef typename std::allocator_traits<A>::template rebind_alloc<Slot> SlotAlloc;
+
+   static const uint32_t EMPTY = 0xFFFFFFFFu;       // a slot never used
+   static const uint32_t TOMBSTONE = 0xFFFFFFFEu;   // a slot whose key was erased
+
+   size_t home(uint64_t hash) const
+   {
+      return (size_t)((hash * 0x9E3779B97F4A7C15ull) >> shift);
+   }
+   size_t next(size_t iSlot) const
+   {
+      return (iSlot + 1) & (slots.size() - 1);
+   }
+
+   // does the key in this slot equal s, whose hash is hash?
+   bool matches(const Slot& slot, std::string_view s, uint64_t hash) const
+   {
+      if (slot.hash != hash || slot.length != s.size())
+         return false;
+      char prefix[INLINE] = {};
+      memcpy(prefix, s.data(), s.size() < INLINE ? s.size() : INLINE);
+      if (memcmp(slot.prefix, prefix, INLINE) != 0)
+         return false;
+      return s.size() <= INLINE ||
+             memcmp(&store[slot.offset] + INLINE, s.data() + INLINE, s.size() - INLINE) == 0;
+   }
+
+   // the key in a slot holding one
+   std::string_view key(const Slot& slot) const
+   {
+      if (slot.length <= INLINE)
+         return std::string_view(slot.prefix, slot.length);
+      return std::string_view(&store[slot.offset], slot.length);
+   }
+
+   // does s point into our own slots or store, say from one of our iterators?
+   bool owns(std::string_view s) const
+   {
+      std::less<const char*> less;
+      if (slots.size())
+      {
+         const char* pSlots = (const char*)&slots[0];
+         if (!less(s.data(), pSlots) && less(s.data(), pSlots + slots.size() * sizeof(Slot)))
+            return true;
+      }
+      if (store.size())
+      {
+         const char* pStore = &store[0];
+         if (!less(s.data(), pStore) && less(s.data(), pStore + store.size()))
+            return true;
+      }
+      return false;
+   }
+
+   uint64_t append(std::string_view s);
+   void allocate(size_t numSlots);
+
+   custom::vector<Slot, SlotAlloc> slots;   // the table
+   custom::vector<char, A> store;           // the bytes of every key longer than INLINE
+   size_t numElements;                      // number of keys in the set
+   size_t numTombstones;                    // number of slots holding TOMBSTONE
+   size_t numDead;                          // bytes in the store no key refers to
+   int shift;                               // 64 - log2(number of slots)
+};
+
+/************************************************
+ * STRING UNORDERED SET ITERATOR
+ * Walk the slots, skipping the empty ones and the tombstones. A
+ * dereferenced key is a view into the set: it lasts until the next
+ * insert() or rehash().
+ ************************************************/
+template <typename Hash, typename A>
+class string_unordered_set <Hash, A> ::iterator
+{
+   friend class ::TestStringHash;   // give unit tests access to the privates
+   template <typename H, typename AA>
+   friend class custom::string_unordered_set;
+public:
+   //
+   // Construct
+   //
+   iterator() : pSet(nullptr), iSlot(0) {}
+   iterator(const string_unordered_set* pSet, size_t iSlot) : pSet(pSet), iSlot(iSlot) {}
+
+   //
+   // Compare
+   //
+   bool operator == (const iterator& rhs) const { return iSlot == rhs.iSlot; }
+   bool operator != (const iterator& rhs) const { return iSlot != rhs.iSlot; }
+
+   //
+   // Access
+   //
+   std::string_view operator * () const
+   {
+      return pSet->key(pSet->slots[iSlot]);
+   }
+
+   //
+   // Arithmetic
+   //
+   iterator& operator ++ ()
+   {
+      ++iSlot;
+      return settle();
+   }
+   iterator operator ++ (int postfix)
+   {
+      iterator temp(*this);
+      ++(*this);
+      return temp;
+   }
+
+private:
+   // move forward to the first key at or after this slot
+   iterator& settle()
+   {
+      while (iSlot < pSet->slots.size() && pSet->slots[iSlot].length >= TOMBSTONE)
+         ++iSlot;
+      return *this;
+   }
+
+   const string_unordered_set* pSet;
+   size_t iSlot;
+};
+
+/*****************************************
+ * STRING UNORDERED SET :: FIND
+ * Probe from home until the key or an empty slot
+ ****************************************/
+template <typename Hash, typename A>
+typename string_unordered_set<Hash, A>::iterator string_unordered_set<Hash, A>::find(std::string_view s) const
+{
+   uint64_t hash = (uint64_t)Hash()(s);
+   for (size_t iSlot = home(hash); slots[iSlot].length != EMPTY; iSlot = next(iSlot))
+      if (matches(slots[iSlot], s, hash))
+         return iterator(this, iSlot);
+   return end();
+}
+
+/*****************************************
+ * STRING UNORDERED SET :: INSERT
+ * Probe as find() does, remembering the first tombstone passed so
+ * that a new key can reuse it, then copy the key into the store.
+ * Nothing changes until the probe has missed, so a key already here
+ * never causes a rehash.
+ ****************************************/
+template <typename Hash, typename A>
+custom::pair<typename string_unordered_set<Hash, A>::iterator, bool>
+string_unordered_set<Hash, A>::insert(std::string_view s)
+{
+   if (s.size() >= TOMBSTONE)
+      throw "ERROR: the key is too long for string_unordered_set";
+
+   uint64_t hash = (uint64_t)Hash()(s);
+   size_t iSlot = home(hash);
+   size_t iTombstone = slots.size();
+   for (; slots[iSlot].length != EMPTY; iSlot = next(iSlot))
+   {
+      if (matches(slots[iSlot], s, hash))
+         return custom::pair<iterator, bool>(iterator(this, iSlot), false);
+      if (slots[iSlot].length == TOMBSTONE && iTombstone == slots.size())
+         iTombstone = iSlot;
+   }
+
+   // The rehash and append() below may both move the slots and the
+   // store, so a key that lives in them must be copied out first.
+   std::string copy;
+   if (owns(s))
+   {
+      copy.assign(s.data(), s.size());
+      s = copy;
+   }
+
+   // grow, or just sweep out the tombstones, before three quarters full
+   if ((numElements + numTombstones + 1) * 4 > slots.size() * 3)
+   {
+      rehash((numElements + 1) * 8 > slots.size() * 3 ? slots.size() * 2 : slots.size());
+      for (iSlot = home(hash); slots[iSlot].length != EMPTY; iSlot = next(iSlot))
+         ;
+   }
+   else if (iTombstone != slots.size())
+   {
+      iSlot = iTombstone;
+      numTombstones--;
+   }
+   Slot& slot = slots[iSlot];
+   slot.hash = hash;
+   slot.length = (uint32_t)s.size();
+   memset(slot.prefix, 0, INLINE);
+   memcpy(slot.prefix, s.data(), s.size() < INLINE ? s.size() : INLINE);
+   slot.offset = s.size() > INLINE ? append(s) : 0;
+   numElements++;
+   return custom::pair<iterator, bool>(iterator(this, iSlot), true);
+}
+
+/*****************************************
+ * STRING UNORDERED SET :: ERASE
+ * Mark the slot; its bytes stay in the store until a rehash
+ ****************************************/
+template <typename Hash, typename A>
+size_t string_unordered_set<Hash, A>::erase(std::string_view s)
+{
+   iterator it = find(s);
+   if (it == end())
+      return 0;
+
+   Slot& slot = slots[it.iSlot];
+   if (slot.length > INLINE)
+      numDead += slot.length;
+   slot.length = TOMBSTONE;
+   numTombstones++;
+   numElements--;
+   return 1;
+}
+
+/*****************************************
+ * STRING UNORDERED SET :: REHASH
+ * Move every key into at least numSlots slots, enough to stay
+ * under three quarters full. The hashes are in the slots, so no key
+ * is hashed again; the store is only rebuilt when half of it is dead.
+ ****************************************/
+template <typename Hash, typename A>
+void string_unordered_set<Hash, A>::rehash(size_t numSlots)
+{
+   if (numSlots * 3 < (numElements + 1) * 4)
+      numSlots = (numElements + 1) * 4 / 3 + 1;
+
+   custom::vector<Slot, SlotAlloc> slotsOld(slots.get_allocator());
+   slotsOld.swap(slots);
+   allocate(numSlots);
+
+   custom::vector<char, A> storeOld(store.get_allocator());
+   bool compact = numDead * 2 > store.size();
+   if (compact)
+   {
+      storeOld.swap(store);
+      numDead = 0;
+   }
+
+   for (size_t i = 0; i < slotsOld.size(); i++)
+   {
+      Slot slot = slotsOld[i];
+      if (slot.length >= TOMBSTONE)
+         continue;
+      if (compact && slot.length > INLINE)
+         slot.offset = append(std::string_view(&storeOld[slot.offset], slot.length));
+      size_t iSlot = home(slot.hash);
+      while (slots[iSlot].length != EMPTY)
+         iSlot = next(iSlot);
+      slots[iSlot] = slot;
+   }
+}
+
+/*****************************************
+ * STRING UNORDERED SET :: APPEND
+ * Copy a key to the end of the store, doubling it when full
+ ****************************************/
+template <typename Hash, typename A>
+uint64_t string_unordered_set<Hash, A>::append(std::string_view s)
+{
+   size_t offset = store.size();
+   if (offset + s.size() > store.capacity())
+      store.reserve(offset + s.size() > store.capacity() * 2 ? offset + s.size() : store.capacity() * 2);
+   store.resize(offset + s.size());
+   memcpy(&store[offset], s.data(), s.size());
+   return offset;
+}
+
+/*****************************************
+ * STRING UNORDERED SET :: ALLOCATE
+ * Set up at least numSlots empty slots, a power of two no less than 8
+ ****************************************/
+template <typename Hash, typename A>
+void string_unordered_set<Hash, A>::allocate(size_t numSlots)
+{
+   size_t num = 1;
+   shift = 64;
+   while (num < numSlots || num < 8)
+   {
+      num *= 2;
+      shift--;
+   }
+   Slot empty = {};
+   empty.length = EMPTY;
+   custom::vector<Slot, SlotAlloc> slotsNew(num, empty, slots.get_allocator());
+   slots.swap(slotsNew);
+   numTombstones = 0;
+}
+
+} // namespace custom
@@ -0,0 +1,377 @@
+/***********************************************************************
+ * Header:
+ *    TEST BLOCK HASH
+ * Summary:
+ *    Unit tests for block_unordered_set
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+#ifdef DEBUG
+
+#include "blockhash.h"  // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <cstdint>
+#include <unordered_set>
+
+/***********************************************
+ * TEST BLOCK HASH
+ * Unit tests for the block_unordered_set class
+ ***********************************************/
+class TestBlockHash : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_layout();
+
+      // Match
+      test_match_32();
+      test_match_64();
+
+      // Insert
+      test_insert_one();
+      test_insert_duplicate();
+      test_insert_overflow();
+      test_insert_grow();
+
+      // Erase
+      test_erase_fillHole();
+      test_erase_keepsOverflow();
+      test_erase_clearsOverflow();
+      test_erase_churn();
+
+      // Iterator
+      test_iterator_visitsAll();
+
+      // Against the standard library
+      test_random_32();
+      test_random_64();
+
+      report("BlockHash");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // an empty set is one empty block
+   void test_construct_default()
+   {  // exercise
+      custom::block_unordered_set<uint32_t> s;
+      // verify
+      assertUnit(s.size() == 0);
+      assertUnit(s.empty());
+      assertUnit(s.bucket_count() == 1);
+      assertUnit(s.counts[0] == 0);
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // a block is exactly a cache line on a cache line
+   void test_construct_layout()
+   {  // setup
+      custom::block_unordered_set<uint64_t> s(4);
+      // exercise
+      uintptr_t p = (uintptr_t)&s.blocks[0];
+      // verify
+      assertUnit(sizeof(custom::block_unordered_set<uint32_t>::Block) == 64);
+      assertUnit(sizeof(custom::block_unordered_set<uint64_t>::Block) == 64);
+      assertUnit(custom::block_unordered_set<uint32_t>::BLOCK_KEYS == 16);
+      assertUnit(custom::block_unordered_set<uint64_t>::BLOCK_KEYS == 8);
+      assertUnit(p % 64 == 0);
+      assertUnit(s.bucket_count() == 4);
+   }  // teardown
+
+   /***************************************
+    * MATCH
+    ***************************************/
+
+   // every slot holding the key, and no other, lights up
+   void test_match_32()
+   {  // setup
+      typedef custom::block_unordered_set<uint32_t> Set;
+      Set::Block block;
+      for (uint32_t i = 0; i < 16; i++)
+         block.keys[i] = i;
+      block.keys[3] = 99;
+      block.keys[15] = 99;
+      // exercise
+      uint32_t mask = Set::match(block, 99);
+      // verify
+      assertUnit(mask == ((1u << 3) | (1u << 15)));
+      assertUnit(Set::match(block, 0) == 1u);
+      assertUnit(Set::match(block, 1000) == 0);
+   }  // teardown
+
+   // the halves of a 64 bit key must both match
+   void test_match_64()
+   {  // setup
+      typedef custom::block_unordered_set<uint64_t> Set;
+      Set::Block block;
+      for (uint64_t i = 0; i < 8; i++)
+         block.keys[i] = i;
+      block.keys[2] = 0x100000007ull;   // high half differs from 7
+      block.keys[5] = 0x700000000ull;   // low half differs from 7
+      block.keys[7] = 0x123456789ull;
+      // exercise
+      uint32_t mask = Set::match(block, 0x123456789ull);
+      // verify
+      assertUnit(mask == (1u << 7));
+      assertUnit(Set::match(block, 7) == 0);
+      assertUnit(Set::match(block, 0x100000007ull) == (1u << 2));
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // a key lands in its home block
+   void test_insert_one()
+   {  // setup
+      custom::block_unordered_set<uint32_t> s(8);
+      // exercise
+      auto result = s.insert(42);
+      // verify
+      assertUnit(result.second);
+      assertUnit(*result.first == 42);
+      assertUnit(s.size() == 1);
+      assertUnit(result.first.iBlock == s.home(42));
+      assertUnit(s.counts[s.home(42)] == 1);
+      assertUnit(s.find(42) == result.first);
+      assertUnit(s.find(43) == s.end());
+   }  // teardown
+
+   // the second insert finds the first
+   void test_insert_duplicate()
+   {  // setup
+      custom::block_unordered_set<uint64_t> s;
+      s.insert(7);
+      // exercise
+      auto result = s.insert(7);
+      // verify
+      assertUnit(!result.second);
+      assertUnit(*result.first == 7);
+      assertUnit(s.size() == 1);
+   }  // teardown
+
+   // a full block spills into the next one and says so
+   void test_insert_overflow()
+   {  // setup
+      typedef custom::block_unordered_set<uint64_t> Set;
+      Set s(8);
+      custom::vector<uint64_t> keys;
+      for (uint64_t k = 0; keys.size() < Set::BLOCK_KEYS + 1; k++)
+         if (s.home(k) == 3)
+            keys.push_back(k);
+      // exercise
+      for (size_t i = 0; i < keys.size(); i++)
+         s.insert(keys[i]);
+      // verify
+      assertUnit(s.bucket_count() == 8);
+      assertUnit(s.counts[3] == (Set::BLOCK_KEYS | Set::OVERFLOW_BIT));
+      assertUnit(s.counts[4] == 1);
+      assertUnit(s.find(keys[Set::BLOCK_KEYS]).iBlock == 4);
+      for (size_t i = 0; i < keys.size(); i++)
+         assertUnit(s.find(keys[i]) != s.end());
+   }  // teardown
+
+   // passing 7/8 full doubles the blocks and keeps every key
+   void test_insert_grow()
+   {  // setup
+      custom::block_unordered_set<uint32_t> s;
+      // exercise
+      for (uint32_t k = 0; k < 15; k++)
+         s.insert(k * 1000);
+      // verify
+      assertUnit(s.bucket_count() == 2);
+      assertUnit(s.size() == 15);
+      for (uint32_t k = 0; k < 15; k++)
+         assertUnit(s.find(k * 1000) != s.end());
+   }  // teardown
+
+   /***************************************
+    * ERASE
+    ***************************************/
+
+   // the last key of the block moves into the hole
+   void test_erase_fillHole()
+   {  // setup
+      custom::block_unordered_set<uint32_t> s;
+      s.insert(10);
+      s.insert(20);
+      s.insert(30);
+      // exercise
+      size_t num = s.erase(10);
+      // verify
+      assertUnit(num == 1);
+      assertUnit(s.size() == 2);
+      assertUnit(s.counts[0] == 2);
+      assertUnit(s.blocks[0].keys[0] == 30);
+      assertUnit(s.find(10) == s.end());
+      assertUnit(s.find(20) != s.end());
+      assertUnit(s.find(30) != s.end());
+      assertUnit(s.erase(10) == 0);
+   }  // teardown
+
+   // a spilled key is still found after its home block opens up
+   void test_erase_keepsOverflow()
+   {  // setup
+      typedef custom::block_unordered_set<uint32_t> Set;
+      Set s(8);
+      custom::vector<uint32_t> keys;
+      for (uint32_t k = 0; keys.size() < Set::BLOCK_KEYS + 1; k++)
+         if (s.home(k) == 7)
+            keys.push_back(k);
+      for (size_t i = 0; i < keys.size(); i++)
+         s.insert(keys[i]);
+      // exercise
+      s.erase(keys[0]);
+      // verify
+      assertUnit(s.counts[7] == ((Set::BLOCK_KEYS - 1) | Set::OVERFLOW_BIT));
+      assertUnit(s.find(keys[Set::BLOCK_KEYS]).iBlock == 0);   // wrapped around
+      assertUnit(s.size() == Set::BLOCK_KEYS);
+   }  // teardown
+
+   // once the spilled key is gone, a miss stops at its home block again
+   void test_erase_clearsOverflow()
+   {  // setup
+      typedef custom::block_unordered_set<uint32_t> Set;
+      Set s(8);
+      custom::vector<uint32_t> keys;
+      for (uint32_t k = 0; keys.size() < Set::BLOCK_KEYS + 2; k++)
+         if (s.home(k) == 2)
+            keys.push_back(k);
+      for (size_t i = 0; i < keys.size(); i++)
+         s.insert(keys[i]);
+      // exercise
+      s.erase(keys[Set::BLOCK_KEYS]);
+      bool isFlaggedAfterOne = s.counts[2] & Set::OVERFLOW_BIT;
+      s.erase(keys[Set::BLOCK_KEYS + 1]);
+      // verify
+      assertUnit(isFlaggedAfterOne);
+      assertUnit(s.counts[2] == Set::BLOCK_KEYS);
+      assertUnit(s.overflows[2] == 0);
+      assertUnit(s.size() == Set::BLOCK_KEYS);
+      assertUnit(s.find(keys[0]) != s.end());
+   }  // teardown
+
+   // a set held at one size under insert and erase churn keeps misses short
+   void test_erase_churn()
+   {  // setup
+      typedef custom::block_unordered_set<uint64_t> Set;
+      Set s(64);
+      uint64_t live[400];
+      uint64_t seed = 0x2545F4914F6CDD1Dull;
+      for (int i = 0; i < 400; i++)
+      {
+         seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+         live[i] = (seed >> 1) & ~(uint64_t)1;   // odd keys are never inserted
+         s.insert(live[i]);
+      }
+      // exercise
+      for (int i = 0; i < 200000; i++)
+      {
+         seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+         int iOut = (int)((seed >> 33) % 400);
+         s.erase(live[iOut]);
+         live[iOut] = (seed >> 1) & ~(uint64_t)1;
+         s.insert(live[iOut]);
+      }
+      // verify
+      assertUnit(s.bucket_count() == 64);
+      size_t numProbed = 0;
+      for (uint64_t k = 1; k < 2 * 1000; k += 2)
+      {
+         size_t iBlock = s.home(k);
+         for (size_t n = 1; n <= s.bucket_count(); n++, iBlock = s.next(iBlock))
+         {
+            numProbed++;
+            if (!(s.counts[iBlock] & Set::OVERFLOW_BIT))
+               break;
+         }
+      }
+      assertUnit(numProbed < 1000 * 8);   // not 64 blocks a miss
+      size_t numFound = 0;
+      for (int i = 0; i < 400; i++)
+         numFound += s.find(live[i]) != s.end();
+      assertUnit(numFound == s.size());
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // skips empty blocks and sees each key once
+   void test_iterator_visitsAll()
+   {  // setup
+      custom::block_unordered_set<uint64_t> s(16);
+      s.insert(5);
+      s.insert(500);
+      s.insert(50000);
+      uint64_t sum = 0;
+      size_t num = 0;
+      // exercise
+      for (auto it = s.begin(); it != s.end(); ++it)
+      {
+         sum += *it;
+         num++;
+      }
+      // verify
+      assertUnit(num == 3);
+      assertUnit(sum == 50505);
+   }  // teardown
+
+   /***************************************
+    * RANDOM
+    ***************************************/
+
+   void test_random_32()
+   {
+      assertUnit(agrees<uint32_t>(0x12345678u));
+   }
+
+   void test_random_64()
+   {
+      assertUnit(agrees<uint64_t>(0x9abcdef012345678ull));
+   }
+
+   // insert and erase pseudo-random keys from a small range so that
+   // blocks fill, spill and drain; the answers must match std
+   template <typename K>
+   bool agrees(uint64_t seed)
+   {
+      custom::block_unordered_set<K> s;
+      std::unordered_set<K> expected;
+      for (int i = 0; i < 20000; i++)
+      {
+         seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+         K k = (K)((seed >> 33) % 3000);
+         if ((seed >> 20) & 3)
+         {
+            if (s.insert(k).second != expected.insert(k).second)
+               return false;
+         }
+         else if (s.erase(k) != expected.erase(k))
+            return false;
+      }
+      if (s.size() != expected.size())
+         return false;
+      size_t num = 0;
+      for (auto it = s.begin(); it != s.end(); ++it, ++num)
+         if (expected.find(*it) == expected.end())
+            return false;
+      for (K k = 0; k < 3000; k++)
+         if ((s.find(k) != s.end()) != (expected.count(k) == 1))
+            return false;
+      return num == expected.size();
+   }
+};
+
+#endif // DEBUG
@@ -16,6 +16,13 @@
 #include "testList.h"       // for the list unit tests
 #include "testVector.h"     // for the vector unit tests
 #include "testSpy.h"        // for the spy unit tests
+#include "testBlockHash.h"  // for the block hash unit tests
+#include "testStaticHash.h" // for the static hash unit tests
+#include "testIntHash.h"    // for the int hash unit tests
+#include "testStringHash.h" // for the string hash unit tests
+#include "testHashFunc.h"   // for the hash function unit tests
+#include "testParallel.h"   // for the parallel unit tests
+#include "testHashMap.h"    // for the hash map unit tests
 int Spy::counters[] = {};
 
 /**********************************************************************
@@ -31,6 +38,13 @@ int main()
    TestList().run();
    TestVector().run();
    TestHash().run();
+   TestBlockHash().run();
+   TestStaticHash().run();
+   TestIntHash().run();
+   TestStringHash().run();
+   TestHashFunc().run();
+   TestParallel().run();
+   TestHashMap().run();
 #endif // DEBUG
    
    // driver
@@ -12,6 +12,9 @@
 #ifdef DEBUG
 
 #include "hash.h"
+#include "arena.h"
+#include "pool.h"
+#include "hugepage.h"
 #include "unitTest.h"
 #include "spy.h"
 
@@ -20,6 +23,11 @@
 #include <unordered_set>
 #include <functional>
 #include <vector>
+#include <string>
+#include <sstream>
+#include <memory_resource>
+#include <thread>
+#include <cctype>
 
 using std::cout;
 using std::endl;
@@ -34,6 +42,83 @@ class Hash1
 template <class T>
 size_t hash1(const T & t) { return 1; }
 
+// std::hash, counting how often it is called
+template <class T>
+class CountingHash
+{
+   public:
+      static int numCalls;
+      std::size_t operator() (const T & t) const { numCalls++; return std::hash<T>()(t); }
+};
+template <class T>
+int CountingHash<T>::numCalls = 0;
+
+// std::hash with a seed, so each instance hashes differently
+template <class T>
+class SeededHash
+{
+   public:
+      SeededHash(std::size_t seed = 0) : seed(seed) {}
+      std::size_t operator() (const T & t) const { return std::hash<T>()(t) ^ seed; }
+      std::size_t seed;
+};
+
+// strings equal whatever their case
+class CaseInsensitiveHash
+{
+   public:
+      std::size_t operator() (const std::string & s) const
+      {
+         std::string lower(s);
+         for (char & c : lower)
+            c = (char)std::tolower((unsigned char)c);
+         return std::hash<std::string>()(lower);
+      }
+};
+class CaseInsensitiveEqual
+{
+   public:
+      bool operator() (const std::string & lhs, const std::string & rhs) const
+      {
+         if (lhs.size() != rhs.size())
+            return false;
+         for (std::size_t i = 0; i < lhs.size(); i++)
+            if (std::tolower((unsigned char)lhs[i]) != std::tolower((unsigned char)rhs[i]))
+               return false;
+         return true;
+      }
+};
+
+/***************************************
+ * COUNTING RESOURCE
+ * A memory resource that counts what passes through it
+ ***************************************/
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+   CountingResource() : numAllocate(0), numDeallocate(0), numBytes(0) {}
+   int numAllocate;     // calls to allocate
+   int numDeallocate;   // calls to deallocate
+   long numBytes;       // bytes currently outstanding
+private:
+   void* do_allocate(size_t bytes, size_t alignment) override
+   {
+      numAllocate++;
+      numBytes += (long)bytes;
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+   }
+   void do_deallocate(void* p, size_t bytes, size_t alignment) override
+   {
+      numDeallocate++;
+      numBytes -= (long)bytes;
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+   }
+   bool do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override
+   {
+      return this == &rhs;
+   }
+};
+
 class TestHash : public UnitTest
 {
 
@@ -48,6 +133,7 @@ public:
       test_construct_nonDefaultIterator();
       test_construct_copyEmpty();
       test_construct_copyStandard();
+      test_construct_copySparse();
       test_construct_nonDefaultHash();
 
       // Assign
@@ -137,6 +223,119 @@ public:
       test_loadFactor_default();
       test_loadFactor_two();
       test_setLoadFactor_five();
+
+      // Shrink
+      test_shrinkToFit_empty();
+      test_shrinkToFit_standard();
+      test_minLoadFactor_eraseShrinks();
+      test_minLoadFactor_disabled();
+      test_minLoadFactor_nearMax();
+      test_clearAndRelease_standard();
+
+      // Allocator
+      test_pmr_insertErase();
+      test_pmr_rehash();
+      test_pmr_move();
+      test_pmr_copyOtherResource();
+      test_arena_insert();
+      test_arena_clearTrivial();
+      test_arena_clearSpy();
+      test_arena_resetReuse();
+      test_pool_eraseReuse();
+      test_pool_clearReuse();
+      test_pool_trim();
+      test_hugePage_buckets();
+      test_hugePage_poolSlabs();
+
+      // Snapshot
+      test_snapshot_empty();
+      test_snapshot_integers();
+      test_snapshot_strings();
+      test_snapshot_corrupt();
+      test_snapshot_corruptHeader();
+      test_snapshot_hugeBlock();
+      test_snapshot_lyingHeader();
+      test_snapshot_duplicate();
+      test_snapshot_growPastPresize();
+
+      // Flooding
+      test_flood_normalUnkeyed();
+      test_flood_stringsRescued();
+      test_flood_opaqueOnce();
+      test_flood_copyKeepsKey();
+      test_flood_highLoadUnkeyed();
+      test_seed_perSet();
+      test_seed_scattersBucketCollisions();
+
+      // Treeify
+      test_treeify_shortChain();
+      test_treeify_longChain();
+      test_treeify_findLogCompares();
+      test_treeify_eraseUntreeify();
+      test_treeify_insertBetweenThresholds();
+      test_treeify_rehashRebuilds();
+      test_treeify_copyOwnTree();
+      test_treeify_assignOwnTree();
+
+      // Stats
+      test_stats_empty();
+      test_stats_standard();
+      test_stats_bytes();
+
+      // Occupancy
+      test_occupancy_next();
+      test_occupancy_standard();
+      test_occupancy_insertErase();
+      test_occupancy_rehash();
+      test_occupancy_iterateSparse();
+
+      // Memory
+      test_memory_empty();
+      test_memory_nodes();
+      test_memory_matchesStats();
+      test_memory_noOverheadPmr();
+
+      // Counters
+      test_counters_off();
+      test_counters_find();
+      test_counters_insertErase();
+      test_counters_rehash();
+      test_counters_copyStartsOver();
+
+      // Const
+      test_const_find();
+      test_const_iterate();
+      test_const_localIterator();
+      test_const_counted();
+      test_const_threads();
+
+      // Prehashed
+      test_prehashed_find();
+      test_prehashed_insert();
+      test_prehashed_insertGrows();
+      test_prehashed_erase();
+      test_prehashed_wrapper();
+      test_prehashed_keyed();
+      test_prehashed_tree();
+
+      // Hash and EqPred
+      test_functors_emptyTakeNoRoom();
+      test_functors_seeded();
+      test_functors_copyMoveSwap();
+      test_functors_eqPred();
+      test_functors_eqPredNoTree();
+      test_functors_eqPredKeyed();
+
+      // Operation budgets
+      test_budget_insertNew();
+      test_budget_insertDuplicate();
+      test_budget_insertGrows();
+      test_budget_insertMany();
+      test_budget_findHit();
+      test_budget_findMiss();
+      test_budget_erase();
+      test_budget_rehash();
+      test_budget_iterate();
       
       report("Hash");
    }
@@ -238,6 +437,8 @@ public:
       // h[3] -->
       assertUnit(us.maxLoadFactor == (float)1.0);
       us.maxLoadFactor = (float)1.3;
+      us.seed = 0;   // place by the plain hash
+      us.rehash_to(us.bucket_count());
       assertStandardFixture(us);
       // teardown
       teardownStandardFixture(us);
@@ -289,6 +490,26 @@ public:
       teardownStandardFixture(usDes);
    } 
 
+   // a few elements in many buckets: same buckets, same order
+   void test_construct_copySparse()
+   {  // setup
+      custom::unordered_set<int> usSrc(1 << 20);
+      for (int i = 0; i < 1000; i++)
+         usSrc.insert(i * 7919);
+      // exercise
+      custom::unordered_set<int> usDes(usSrc);
+      // verify
+      assertUnit(usDes.size() == 1000);
+      assertUnit(usDes.bucket_count() == usSrc.bucket_count());
+      bool isSame = true;
+      auto itDes = usDes.begin();
+      for (auto itSrc = usSrc.begin(); itSrc != usSrc.end(); ++itSrc, ++itDes)
+         isSame = isSame && itDes != usDes.end() && *itDes == *itSrc;
+      assertUnit(isSame);
+      assertUnit(itDes == usDes.end());
+      assertUnit(usDes.occupied.next(0) == usSrc.occupied.next(0));
+   }  // teardown
+
    // empty 4-element with custom hash function 
    void test_construct_nonDefaultHash()
    {  // setup
@@ -327,6 +548,7 @@ public:
     void test_bucket_empty0()
     {  // setup
        custom::unordered_set<Spy> us;
+       us.seed = 0;   // place by the plain hash
        Spy s(0); // (0 % 8 = 0)
        size_t iBucket = 99;
        Spy::reset();
@@ -350,6 +572,7 @@ public:
     void test_bucket_empty7()
     {  // setup
        custom::unordered_set<Spy> us;
+       us.seed = 0;   // place by the plain hash
        Spy s(7); // (7 % 8 = 7)
        size_t iBucket = 99;
        Spy::reset();
@@ -373,6 +596,7 @@ public:
     void test_bucket_empty58()
     {  // setup
        custom::unordered_set<Spy> us;
+       us.seed = 0;   // place by the plain hash
        Spy s(58);  // (5+8 % 8 = 5)
        size_t iBucket = 99;
        Spy::reset();
@@ -474,6 +698,7 @@ public:
     void test_bucket_custom0()
     {  // setup
        custom::unordered_set<Spy, Hash1<Spy> > us;
+       us.seed = 0;   // place by the plain hash
        Spy s(0); 
        size_t iBucket = 99;
        Spy::reset();
@@ -496,6 +721,7 @@ public:
     void test_bucket_custom3()
     {  // setup
        custom::unordered_set<Spy, Hash1<Spy> > us;
+       us.seed = 0;   // place by the plain hash
        Spy s(3); 
        size_t iBucket = 99;
        Spy::reset();
@@ -1461,8 +1687,8 @@ public:
       // exercise
       us.rehash(6);
       // verify
-      assertUnit(Spy::numCopyMove() == 4);   // [31, 49, 67, 59]
-      assertUnit(Spy::numDestructor() == 4); // [31, 49, 67, 59]
+      assertUnit(Spy::numCopyMove() == 0);   // relinked, not moved
+      assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numAssignMove() == 0);
       assertUnit(Spy::numAssign() == 0);
       assertUnit(Spy::numAlloc() == 0);
@@ -1514,8 +1740,8 @@ public:
       // exercise
       us.rehash(8);
       // verify
-      assertUnit(Spy::numCopyMove() == 4);   // [31, 49, 67, 59]
-      assertUnit(Spy::numDestructor() == 4); // [31, 49, 67, 59]
+      assertUnit(Spy::numCopyMove() == 0);   // relinked, not moved
+      assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numAssignMove() == 0);
       assertUnit(Spy::numAssign() == 0);
       assertUnit(Spy::numAlloc() == 0);
@@ -1659,8 +1885,8 @@ public:
       // exercise
       us.reserve(6);
       // verify
-      assertUnit(Spy::numCopyMove() == 4);   // [31, 49, 67, 59]
-      assertUnit(Spy::numDestructor() == 4); // [31, 49, 67, 59]
+      assertUnit(Spy::numCopyMove() == 0);   // relinked, not moved
+      assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numAssignMove() == 0);
       assertUnit(Spy::numAssign() == 0);
       assertUnit(Spy::numAlloc() == 0);
@@ -1713,8 +1939,8 @@ public:
       // exercise
       us.reserve(8);
       // verify
-      assertUnit(Spy::numCopyMove() == 4);   // [31, 49, 67, 59]
-      assertUnit(Spy::numDestructor() == 4); // [31, 49, 67, 59]
+      assertUnit(Spy::numCopyMove() == 0);   // relinked, not moved
+      assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numAssignMove() == 0);
       assertUnit(Spy::numAssign() == 0);
       assertUnit(Spy::numAlloc() == 0);
@@ -1778,6 +2004,7 @@ public:
    void test_insert_empty0()
    {  // setup
       custom::unordered_set<Spy> us;
+      us.seed = 0;   // place by the plain hash
       Spy s(0);
       custom::pair<custom::unordered_set<Spy>::iterator, bool> p;
       Spy::reset();
@@ -1815,6 +2042,7 @@ public:
    void test_insert_empty58()
    {  // setup
       custom::unordered_set<Spy> us;
+      us.seed = 0;   // place by the plain hash
       Spy s(58);   // into slot (5+8)%8 = 5
       custom::pair<custom::unordered_set<Spy>::iterator, bool> p;
       Spy::reset();
@@ -1999,8 +2227,8 @@ public:
        // verify
        assertUnit(Spy::numAlloc() == 1);      // allocate [44]
        assertUnit(Spy::numCopy() == 1);       // copy     [44]
-       assertUnit(Spy::numCopyMove() == 4);   // [31, 49, 67, 59]
-       assertUnit(Spy::numDestructor() == 4); // [31, 49, 67, 59]
+       assertUnit(Spy::numCopyMove() == 0);   // relinked, not moved
+       assertUnit(Spy::numDestructor() == 0);
        assertUnit(Spy::numAssign() == 0);
        assertUnit(Spy::numDelete() == 0);
        assertUnit(Spy::numDefault() == 0);
@@ -2879,33 +3107,1842 @@ public:
       teardownStandardFixture(us);
    }
 
-   /*************************************************************
-    * SETUP STANDARD FIXTURE
-    *      h[0] --> 31 
-    *      h[1] --> 49 67
-    *      h[2] --> 59 
-    *      h[3] --> 
-    *************************************************************/
-   void setupStandardFixture(custom::unordered_set<Spy> & us)
-   {
-      // clear out whatever the default constructor created
-      us.buckets.clear();
+   /***************************************
+    * SHRINK
+    ***************************************/
 
-      // allocate 4 buckets
-      us.buckets.resize(4);
-      assert(us.buckets.size() == 4);
-      
-      // place in four elements
-      std::hash<Spy> pHash;
-      assert(pHash(Spy(31)) % size_t(4) == 0);
-      us.buckets[0].push_back(Spy(31));
-      assert(pHash(Spy(49)) % size_t(4) == 1);
-      us.buckets[1].push_back(Spy(49));
-      assert(pHash(Spy(59)) % size_t(4) == 2);
-      us.buckets[2].push_back(Spy(59));
-      assert(pHash(Spy(67)) % size_t(4) == 1);
-      us.buckets[1].push_back(Spy(67));
-      
+   // shrink a large empty hash back to the default size
+   void test_shrinkToFit_empty()
+   {  // setup
+      custom::unordered_set<Spy> us(100);
+      Spy::reset();
+      // exercise
+      us.shrink_to_fit();
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertEmptyFixture(us);
+   }  // teardown
+
+   // shrink the standard fixture back down after a rehash to 40
+   void test_shrinkToFit_standard()
+   {  // setup
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] --> 
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      us.rehash(40);
+      Spy::reset();
+      // exercise
+      us.shrink_to_fit();
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);   // relinked, not moved
+      assertUnit(us.numElements == 4);
+      assertUnit(us.buckets.size() == 8);
+      assertUnit(us.find(Spy(31)) != us.end());
+      assertUnit(us.find(Spy(49)) != us.end());
+      assertUnit(us.find(Spy(59)) != us.end());
+      assertUnit(us.find(Spy(67)) != us.end());
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // erasing below the min load factor gives buckets back
+   void test_minLoadFactor_eraseShrinks()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.min_load_factor((float)0.25);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      size_t numBucketsPeak = us.bucket_count();
+      // exercise
+      for (int i = 0; i < 990; i++)
+         us.erase(i);
+      // verify
+      assertUnit(numBucketsPeak >= 1000);
+      assertUnit(us.numElements == 10);
+      assertUnit(us.bucket_count() < 64);
+      assertUnit(us.bucket_count() >= 8);
+      bool allFound = true;
+      for (int i = 990; i < 1000; i++)
+         if (us.find(i) == us.end())
+            allFound = false;
+      assertUnit(allFound);
+   }  // teardown
+
+   // a min load factor near the max still shrinks only now and then
+   void test_minLoadFactor_nearMax()
+   {  // setup
+      CountedSet us;
+      us.min_load_factor((float)0.6);
+      for (int i = 0; i < 4096; i++)
+         us.insert(Spy(i));
+      us.reset_counters();
+      // exercise
+      for (int i = 0; i < 4096; i++)
+         us.erase(Spy(i));
+      // verify
+      assertUnit(us.empty());
+      assertUnit(us.counters().rehashes >= 4);
+      assertUnit(us.counters().rehashes <= 12);   // about log2(4096 / 8)
+      assertUnit(us.bucket_count() < 64);
+   }  // teardown
+
+   // without a min load factor, erase never rehashes
+   void test_minLoadFactor_disabled()
+   {  // setup
+      custom::unordered_set<int> us;
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      size_t numBucketsPeak = us.bucket_count();
+      // exercise
+      for (int i = 0; i < 990; i++)
+         us.erase(i);
+      // verify
+      assertUnit(us.min_load_factor() == (float)0.0);
+      assertUnit(us.numElements == 10);
+      assertUnit(us.bucket_count() == numBucketsPeak);
+   }  // teardown
+
+   // clear and give the bucket array back
+   void test_clearAndRelease_standard()
+   {  // setup
+      // h[0] --> 31 
+      // h[1] --> 49 67
+      // h[2] --> 59 
+      // h[3] --> 
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      us.rehash(40);
+      Spy::reset();
+      // exercise
+      us.clear_and_release();
+      // verify
+      assertUnit(Spy::numDelete() == 4);     // [31, 49, 67, 59]
+      assertUnit(Spy::numDestructor() == 4); // [31, 49, 67, 59]
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(us.numElements == 0);
+      assertUnit(us.buckets.size() == 8);
+      assertUnit(us.buckets.capacity() == 8);
+      assertUnit(us.maxLoadFactor == (float)1.3);
+   }  // teardown
+
+   /***************************************
+    * ALLOCATOR
+    ***************************************/
+
+   // nodes and buckets come from and go back to the resource
+   void test_pmr_insertErase()
+   {  // setup
+      CountingResource resource;
+      {
+         custom::pmr::unordered_set<int> us(&resource);
+         int numAllocateEmpty = resource.numAllocate;
+         // exercise
+         us.insert({ 31, 49, 59, 67 });
+         int numAllocateFull = resource.numAllocate;
+         us.erase(49);
+         // verify
+         assertUnit(numAllocateEmpty == 2);       // the bucket array and its bitmap
+         assertUnit(numAllocateFull == 6);        // [31, 49, 59, 67]
+         assertUnit(resource.numDeallocate == 1); // [49]
+         assertUnit(us.buckets[0].get_allocator().resource() == &resource);
+         assertUnit(us.buckets[7].get_allocator().resource() == &resource);
+      }
+      // teardown
+      assertUnit(resource.numBytes == 0);
+   }
+
+   // a rehash keeps drawing from the same resource
+   void test_pmr_rehash()
+   {  // setup
+      CountingResource resource;
+      {
+         custom::pmr::unordered_set<int> us(4, &resource);
+         us.insert({ 31, 49, 59 });
+         // exercise
+         us.rehash(40);
+         // verify
+         assertUnit(us.buckets.size() == 40);
+         assertUnit(us.get_allocator().resource() == &resource);
+         assertUnit(us.buckets[39].get_allocator().resource() == &resource);
+         assertUnit(us.find(31) != us.end());
+         assertUnit(us.find(49) != us.end());
+         assertUnit(us.find(59) != us.end());
+      }
+      // teardown
+      assertUnit(resource.numBytes == 0);
+   }
+
+   // moving steals the nodes and the resource along with them
+   void test_pmr_move()
+   {  // setup
+      CountingResource resource;
+      {
+         custom::pmr::unordered_set<int> usSrc(&resource);
+         usSrc.insert({ 31, 49, 59, 67 });
+         int numAllocate = resource.numAllocate;
+         // exercise
+         custom::pmr::unordered_set<int> usDes(std::move(usSrc));
+         // verify
+         assertUnit(resource.numAllocate == numAllocate + 2);  // usSrc's new buckets and bitmap
+         assertUnit(usDes.numElements == 4);
+         assertUnit(usDes.get_allocator().resource() == &resource);
+         assertUnit(usSrc.numElements == 0);
+         assertUnit(usSrc.buckets.size() == 8);
+         assertUnit(usSrc.get_allocator().resource() == &resource);
+      }
+      // teardown
+      assertUnit(resource.numBytes == 0);
+   }
+
+   // assigning between resources copies into our own resource
+   void test_pmr_copyOtherResource()
+   {  // setup
+      CountingResource resourceSrc;
+      CountingResource resourceDes;
+      {
+         custom::pmr::unordered_set<int> usSrc(&resourceSrc);
+         usSrc.insert({ 31, 49, 59, 67 });
+         custom::pmr::unordered_set<int> usDes(&resourceDes);
+         int numAllocateSrc = resourceSrc.numAllocate;
+         // exercise
+         usDes = usSrc;
+         // verify
+         assertUnit(resourceSrc.numAllocate == numAllocateSrc);
+         assertUnit(resourceDes.numAllocate == 2 + 2 + 4);  // old and new buckets and bitmap, [31, 49, 59, 67]
+         assertUnit(usDes.numElements == 4);
+         assertUnit(usDes.find(67) != usDes.end());
+      }
+      // teardown
+      assertUnit(resourceSrc.numBytes == 0);
+      assertUnit(resourceDes.numBytes == 0);
+   }
+
+   // a set in an arena keeps all its memory there
+   void test_arena_insert()
+   {  // setup
+      custom::arena a;
+      custom::arena_unordered_set<int> us(&a);
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      // verify
+      assertUnit(us.numElements == 1000);
+      assertUnit(us.buckets[0].get_allocator().resource() == &a);
+      assertUnit(a.bytes_used() >= 1000 * sizeof(int));
+      assertUnit(a.bytes_reserved() >= a.bytes_used());
+      bool allFound = true;
+      for (int i = 0; i < 1000; i++)
+         if (us.find(i) == us.end())
+            allFound = false;
+      assertUnit(allFound);
+   }  // teardown
+
+   // clearing trivial elements neither frees nor visits the nodes
+   void test_arena_clearTrivial()
+   {  // setup
+      custom::arena a;
+      custom::arena_unordered_set<int> us(&a);
+      us.insert({ 31, 49, 59, 67 });
+      size_t numUsed = a.bytes_used();
+      // exercise
+      us.clear();
+      // verify
+      assertUnit(us.numElements == 0);
+      assertUnit(us.buckets[1].pHead == nullptr);
+      assertUnit(us.buckets[1].numElements == 0);
+      assertUnit(a.bytes_used() == numUsed);
+      assertUnit(us.find(31) == us.end());
+      us.insert(31);
+      assertUnit(us.find(31) != us.end());
+   }  // teardown
+
+   // elements that need destroying are still destroyed
+   void test_arena_clearSpy()
+   {  // setup
+      custom::arena a;
+      custom::arena_unordered_set<Spy> us(&a);
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(59));
+      Spy::reset();
+      // exercise
+      us.clear();
+      // verify
+      assertUnit(Spy::numDestructor() == 3);  // [31, 49, 59]
+      assertUnit(Spy::numDelete() == 3);      // [31, 49, 59]
+      assertUnit(us.numElements == 0);
+   }  // teardown
+
+   // after a reset the next request reuses the same chunks
+   void test_arena_resetReuse()
+   {  // setup
+      custom::arena a(1024);
+      {
+         custom::arena_unordered_set<int> us(&a);
+         for (int i = 0; i < 5000; i++)
+            us.insert(i);
+      }
+      size_t numReserved = a.bytes_reserved();
+      // exercise
+      a.reset();
+      {
+         custom::arena_unordered_set<int> us(&a);
+         for (int i = 0; i < 5000; i++)
+            us.insert(i);
+         assertUnit(us.find(4999) != us.end());
+      }
+      // verify
+      assertUnit(numReserved > 0);
+      assertUnit(a.bytes_reserved() == numReserved);
+      a.release();
+      assertUnit(a.bytes_reserved() == 0);
+      assertUnit(a.bytes_used() == 0);
+   }  // teardown
+
+   // a node freed by erase is the next one insert uses
+   void test_pool_eraseReuse()
+   {  // setup
+      CountingResource upstream;
+      custom::node_pool pool(16, &upstream);
+      custom::pmr::unordered_set<int> us(64, &pool);
+      for (int i = 0; i < 40; i++)
+         us.insert(i);
+      int numAllocate = upstream.numAllocate;
+      // exercise
+      for (int i = 0; i < 1000; i++)
+      {
+         us.erase(i);
+         us.insert(i + 40);
+      }
+      // verify
+      assertUnit(upstream.numAllocate == numAllocate);
+      assertUnit(us.numElements == 40);
+      assertUnit(us.find(1039) != us.end());
+      assertUnit(us.find(999) == us.end());
+   }  // teardown
+
+   // clear puts every node back on the free list
+   void test_pool_clearReuse()
+   {  // setup
+      CountingResource upstream;
+      custom::node_pool pool(16, &upstream);
+      custom::pmr::unordered_set<int> us(64, &pool);
+      for (int i = 0; i < 40; i++)
+         us.insert(i);
+      size_t numReserved = pool.bytes_reserved();
+      int numAllocate = upstream.numAllocate;
+      // exercise
+      us.clear();
+      size_t numInUse = pool.bytes_in_use();
+      for (int i = 0; i < 40; i++)
+         us.insert(i + 100);
+      // verify
+      assertUnit(numInUse == us.occupied.bytes());   // only the bitmap
+      assertUnit(upstream.numAllocate == numAllocate);
+      assertUnit(pool.bytes_reserved() == numReserved);
+      assertUnit(pool.bytes_in_use() > 0);
+   }  // teardown
+
+   // trim keeps the last peak, then gives back what goes unused
+   void test_pool_trim()
+   {  // setup
+      CountingResource upstream;
+      custom::node_pool pool(16, &upstream);
+      custom::pmr::unordered_set<int> us(1024, &pool);
+      for (int i = 0; i < 500; i++)
+         us.insert(i);
+      us.clear();
+      size_t numReserved = pool.bytes_reserved();
+      // exercise
+      pool.trim();
+      size_t numAfterFirst = pool.bytes_reserved();
+      pool.trim();
+      // verify
+      assertUnit(numReserved >= 500 * sizeof(int));
+      assertUnit(numAfterFirst == numReserved);   // the peak was just now
+      assertUnit(pool.bytes_reserved() == 16 * us.occupied.bytes());   // the bitmap's slab
+      assertUnit(pool.high_water_mark() == us.occupied.bytes());
+      us.insert(7);
+      assertUnit(us.find(7) != us.end());
+      assertUnit(pool.bytes_in_use() > 0);
+   }  // teardown
+
+   // a big bucket array gets an aligned region of its own
+   void test_hugePage_buckets()
+   {  // setup
+      const size_t PAGE = custom::huge_page_resource::PAGE;
+      custom::huge_page_resource huge;
+      {
+         // exercise
+         custom::pmr::unordered_set<int> us(1 << 16, &huge);
+         us.insert({ 31, 49, 59, 67 });
+         // verify
+         assertUnit((uintptr_t)us.buckets.data % PAGE == 0);
+         assertUnit(huge.bytes_mapped() >= 2 * PAGE);   // buckets, nodes
+         assertUnit(huge.pCurrent != nullptr);
+         if (huge.pCurrent)
+            assertUnit(huge.pCurrent->numLive == 5);     // bitmap, [31, 49, 59, 67]
+         assertUnit(us.find(67) != us.end());
+      }
+      // teardown
+      assertUnit(huge.bytes_mapped() == PAGE);          // the region we carve from
+   }
+
+   // node slabs carved from huge pages
+   void test_hugePage_poolSlabs()
+   {  // setup
+      const size_t PAGE = custom::huge_page_resource::PAGE;
+      custom::huge_page_resource huge;
+      custom::node_pool pool(256, &huge);
+      {
+         custom::pmr::unordered_set<int> us(&pool);
+         // exercise
+         for (int i = 0; i < 1000; i++)
+            us.insert(i);
+         // verify
+         assertUnit(huge.pCurrent != nullptr);
+         if (huge.pCurrent)
+         {
+            uintptr_t pRegion = (uintptr_t)huge.pCurrent;
+            uintptr_t pNode = (uintptr_t)us.buckets[us.bucket(0)].pHead;
+            assertUnit(pNode > pRegion && pNode < pRegion + PAGE);
+         }
+         assertUnit(us.find(999) != us.end());
+      }
+      pool.release();
+      // teardown
+      assertUnit(huge.bytes_mapped() <= PAGE);
+   }
+
+   /***************************************
+    * SNAPSHOT
+    ***************************************/
+
+   // save an empty hash and load it over a filled one
+   void test_snapshot_empty()
+   {  // setup
+      custom::unordered_set<int> usSrc;
+      custom::unordered_set<int> usDes;
+      usDes.insert({ 1, 2, 3 });
+      std::stringstream ss;
+      // exercise
+      usSrc.save(ss);
+      usDes.load(ss);
+      // verify
+      assertUnit(usDes.numElements == 0);
+      assertUnit(usDes.buckets.size() == 8);
+      assertUnit(usDes.maxLoadFactor == (float)1.0);
+      assertUnit(usDes.find(1) == usDes.end());
+   }  // teardown
+
+   // save and load more than one block worth of integers
+   void test_snapshot_integers()
+   {  // setup
+      custom::unordered_set<int> usSrc;
+      usSrc.max_load_factor((float)0.5);
+      for (int i = -5000; i < 5000; i += 3)
+         usSrc.insert(i * 7);
+      custom::unordered_set<int> usDes;
+      usDes.seed = usSrc.seed;   // so the buckets can be compared
+      std::stringstream ss;
+      // exercise
+      usSrc.save(ss);
+      usDes.load(ss);
+      // verify
+      assertUnit(usDes.numElements == usSrc.numElements);
+      assertUnit(usDes.buckets.size() == usSrc.buckets.size());
+      assertUnit(usDes.maxLoadFactor == (float)0.5);
+      bool allFound = true;
+      for (int i = -5000; i < 5000; i += 3)
+         if (usDes.find(i * 7) == usDes.end())
+            allFound = false;
+      assertUnit(allFound);
+      assertUnit(usDes.find(1) == usDes.end());
+      bool sameBuckets = true;
+      for (size_t i = 0; i < usSrc.buckets.size() && i < usDes.buckets.size(); i++)
+         if (usSrc.buckets[i].size() != usDes.buckets[i].size())
+            sameBuckets = false;
+      assertUnit(sameBuckets);
+   }  // teardown
+
+   // save and load strings, including an empty one
+   void test_snapshot_strings()
+   {  // setup
+      custom::unordered_set<std::string> usSrc;
+      usSrc.insert({ "", "a", "bucket", "a much longer string that is not short" });
+      custom::unordered_set<std::string> usDes;
+      std::stringstream ss;
+      // exercise
+      usSrc.save(ss);
+      usDes.load(ss);
+      // verify
+      assertUnit(usDes.numElements == 4);
+      assertUnit(usDes.find("") != usDes.end());
+      assertUnit(usDes.find("a") != usDes.end());
+      assertUnit(usDes.find("bucket") != usDes.end());
+      assertUnit(usDes.find("a much longer string that is not short") != usDes.end());
+      assertUnit(usDes.find("b") == usDes.end());
+   }  // teardown
+
+   // a damaged snapshot is rejected and the destination is untouched
+   void test_snapshot_corrupt()
+   {  // setup
+      custom::unordered_set<int> usSrc;
+      usSrc.insert({ 31, 49, 59, 67 });
+      custom::unordered_set<int> usDes;
+      usDes.insert(3);
+      std::stringstream ssSave;
+      usSrc.save(ssSave);
+      std::string bytes = ssSave.str();
+      bytes[custom::snapshot_header::SIZE + 8] ^= 0x40;   // first byte of the first block's payload
+      std::stringstream ssLoad(bytes);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         usDes.load(ssLoad);
+      }
+      catch (const char*)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(usDes.numElements == 1);
+      assertUnit(usDes.find(3) != usDes.end());
+   }  // teardown
+
+   // the header has its own checksum
+   void test_snapshot_corruptHeader()
+   {  // setup
+      custom::unordered_set<int> usSrc;
+      usSrc.insert({ 31, 49, 59, 67 });
+      custom::unordered_set<int> usDes;
+      std::stringstream ssSave;
+      usSrc.save(ssSave);
+      std::string bytes = ssSave.str();
+      bytes[4] ^= 0x01;   // numElements
+      std::stringstream ssLoad(bytes);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         usDes.load(ssLoad);
+      }
+      catch (const char*)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(usDes.numElements == 0);
+   }  // teardown
+
+   // a block claiming 4 GB is rejected before anything is allocated for it
+   void test_snapshot_hugeBlock()
+   {  // setup
+      custom::unordered_set<int> usSrc;
+      std::stringstream ssSave;
+      usSrc.save(ssSave);
+      std::string bytes = ssSave.str().substr(0, custom::snapshot_header::SIZE);
+      char framing[8];
+      custom::put_u32(framing, 1);
+      custom::put_u32(framing + 4, 0xFFFFFFFF);
+      bytes.append(framing, 8);
+      bytes.append("\x02\x00\x00\x00", 4);
+      std::stringstream ssLoad(bytes);
+      custom::unordered_set<int> usDes;
+      bool thrown = false;
+      // exercise
+      try
+      {
+         usDes.load(ssLoad);
+      }
+      catch (const char*)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(usDes.numElements == 0);
+   }  // teardown
+
+   // a header asking for 2^50 elements at a load factor of 0 sizes a sane table
+   void test_snapshot_lyingHeader()
+   {  // setup
+      std::stringstream ss;
+      custom::snapshot_ostream_sink sink(ss);
+      custom::snapshot_writer<int, custom::snapshot_ostream_sink> writer(sink);
+      custom::snapshot_header header;
+      header.numElements = 2;
+      header.numBuckets = (uint64_t)1 << 50;
+      header.maxLoadFactor = 0.0;
+      writer.header(header);
+      writer.push(4);
+      writer.push(9);
+      writer.finish();
+      custom::unordered_set<int> usDes;
+      // exercise
+      usDes.load(ss);
+      // verify
+      assertUnit(usDes.numElements == 2);
+      assertUnit(usDes.maxLoadFactor > 0.0);
+      assertUnit(usDes.buckets.size() <= ((size_t)1 << 20));
+      assertUnit(usDes.find(4) != usDes.end());
+      assertUnit(usDes.find(9) != usDes.end());
+   }  // teardown
+
+   // a snapshot bigger than the presize grows straight to the header's table
+   void test_snapshot_growPastPresize()
+   {  // setup
+      const int num = (1 << 20) + 4096;
+      std::stringstream ss;
+      custom::snapshot_ostream_sink sink(ss);
+      custom::snapshot_writer<int, custom::snapshot_ostream_sink> writer(sink);
+      custom::snapshot_header header;
+      header.numElements = num;
+      header.numBuckets = 8;
+      header.maxLoadFactor = 1.0;
+      writer.header(header);
+      for (int i = 0; i < num; i++)
+         writer.push(i);
+      writer.finish();
+      custom::unordered_set<int> usDes;
+      // exercise
+      usDes.load(ss);
+      // verify
+      assertUnit(usDes.numElements == num);
+      assertUnit(usDes.buckets.size() == (size_t)num);
+      bool allFound = true;
+      for (int i = 0; i < num; i += 1000)
+         if (usDes.find(i) == usDes.end())
+            allFound = false;
+      assertUnit(allFound);
+      assertUnit(usDes.find(num) == usDes.end());
+   }  // teardown
+
+   // with checkDuplicates, the same element twice is rejected
+   void test_snapshot_duplicate()
+   {  // setup
+      std::stringstream ss;
+      custom::snapshot_ostream_sink sink(ss);
+      custom::snapshot_writer<int, custom::snapshot_ostream_sink> writer(sink);
+      custom::snapshot_header header;
+      header.numElements = 3;
+      header.numBuckets = 8;
+      header.maxLoadFactor = 1.0;
+      writer.header(header);
+      writer.push(5);
+      writer.push(6);
+      writer.push(5);
+      writer.finish();
+      custom::unordered_set<int> usDes;
+      usDes.insert(3);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         usDes.load(ss, true /*checkDuplicates*/);
+      }
+      catch (const char*)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(usDes.numElements == 1);
+      assertUnit(usDes.find(3) != usDes.end());
+   }  // teardown
+
+   /***************************************
+    * FLOODING
+    ***************************************/
+
+   // ordinary keys never come near the threshold
+   void test_flood_normalUnkeyed()
+   {  // setup
+      custom::unordered_set<int> us;
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         us.insert(i * 7);
+      // verify
+      assertUnit(!us.keyed);
+      assertUnit(us.key[0] == 0 && us.key[1] == 0);
+      assertUnit(us.numElements == 1000);
+   }  // teardown
+
+   // strings that all hash alike are spread out by SipHash
+   void test_flood_stringsRescued()
+   {  // setup
+      custom::unordered_set<std::string, Hash1<std::string>> us(64);
+      size_t longest = 0;
+      // exercise
+      for (int i = 0; i < 40; i++)
+         us.insert("attack-" + std::to_string(i));
+      // verify
+      assertUnit(us.keyed);
+      assertUnit(us.is_keyed());
+      assertUnit(us.numElements == 40);
+      assertUnit(us.buckets.size() == 64);
+      for (size_t i = 0; i < us.buckets.size(); i++)
+         longest = us.buckets[i].size() > longest ? us.buckets[i].size() : longest;
+      assertUnit(longest < 10);
+      for (int i = 0; i < 40; i++)
+         assertUnit(us.find("attack-" + std::to_string(i)) != us.end());
+   }  // teardown
+
+   // with no bytes to key, equal hashes stay together, and we give up after one try
+   void test_flood_opaqueOnce()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> us(64);
+      // exercise
+      for (int i = 0; i < 40; i++)
+         us.insert(Spy(i));
+      uint64_t key0 = us.key[0];
+      us.insert(Spy(40));
+      // verify
+      assertUnit(us.keyed);
+      assertUnit(us.key[0] == key0);
+      assertUnit(us.numElements == 41);
+      for (int i = 0; i <= 40; i++)
+         assertUnit(us.find(Spy(i)) != us.end());
+   }  // teardown
+
+   // a copy hashes with the same key, so it finds what it copied
+   void test_flood_copyKeepsKey()
+   {  // setup
+      custom::unordered_set<std::string, Hash1<std::string>> usSrc(64);
+      for (int i = 0; i < 40; i++)
+         usSrc.insert("attack-" + std::to_string(i));
+      // exercise
+      custom::unordered_set<std::string, Hash1<std::string>> usDes(usSrc);
+      // verify
+      assertUnit(usDes.keyed);
+      assertUnit(usDes.key[0] == usSrc.key[0]);
+      assertUnit(usDes.key[1] == usSrc.key[1]);
+      for (int i = 0; i < 40; i++)
+         assertUnit(usDes.find("attack-" + std::to_string(i)) != usDes.end());
+   }  // teardown
+
+   // a set run at a high max load factor has long chains by chance, not by attack
+   void test_flood_highLoadUnkeyed()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.max_load_factor((float)64.0);
+      // exercise
+      for (int i = 0; i < 8192; i++)
+         us.insert(i * 7);
+      // verify
+      assertUnit(!us.keyed);
+      assertUnit(us.bucket_count() <= 256);
+      assertUnit(us.numElements == 8192);
+   }  // teardown
+
+   /***************************************
+    * SEED
+    ***************************************/
+
+   // each set draws its own seed, and lays out the same keys its own way
+   void test_seed_perSet()
+   {  // setup
+      custom::unordered_set<int> us1(1024);
+      custom::unordered_set<int> us2(1024);
+      // exercise
+      int numSame = 0;
+      for (int i = 0; i < 100; i++)
+         numSame += us1.bucket(i) == us2.bucket(i) ? 1 : 0;
+      custom::unordered_set<int> usCopy(us1);
+      // verify
+      assertUnit(us1.seed != 0);
+      assertUnit(us2.seed != 0);
+      assertUnit(us1.seed != us2.seed);
+      assertUnit(numSame < 10);
+      assertUnit(usCopy.seed == us1.seed);
+   }  // teardown
+
+   // keys that collide modulo the bucket count are scattered without keying
+   void test_seed_scattersBucketCollisions()
+   {  // setup
+      custom::unordered_set<int> us(4096);
+      // exercise
+      for (int i = 0; i < 40; i++)
+         us.insert(i * 4096);
+      // verify
+      size_t longest = 0;
+      for (size_t i = 0; i < us.buckets.size(); i++)
+         longest = us.buckets[i].size() > longest ? us.buckets[i].size() : longest;
+      assertUnit(!us.keyed);
+      assertUnit(us.trees.size() == 0);
+      assertUnit(longest < 4);
+      for (int i = 0; i < 40; i++)
+         assertUnit(us.find(i * 4096) != us.end());
+   }  // teardown
+
+   /***************************************
+    * TREEIFY
+    ***************************************/
+
+   // a chain under the threshold is only a list
+   void test_treeify_shortChain()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> us(64);
+      us.seed = 0;   // place by the plain hash
+      // exercise
+      for (int i = 0; i < 7; i++)
+         us.insert(Spy(i));
+      // verify
+      assertUnit(us.buckets[1].size() == 7);
+      assertUnit(us.trees.size() == 0);
+   }  // teardown
+
+   // a long chain is indexed, and the list is left as it was
+   void test_treeify_longChain()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> us(64);
+      us.seed = 0;   // place by the plain hash
+      // exercise
+      for (int i = 0; i < 20; i++)
+         us.insert(Spy(i));
+      // verify
+      assertUnit(!us.keyed);
+      assertUnit(us.trees.size() == 1);
+      assertUnit(us.trees[0].iBucket == 1);
+      assertUnit(us.trees[0].index.size() == 20);
+      assertUnit(us.trees[0].index.height() <= 6);
+      assertUnit(us.buckets[1].size() == 20);
+      assertUnit(us.buckets[1].front() == Spy(0));
+      assertUnit(us.buckets[1].back() == Spy(19));
+      for (int i = 0; i < 20; i++)
+         assertUnit(us.find(Spy(i)) != us.end());
+      assertUnit(us.find(Spy(20)) == us.end());
+      assertUnit(us.insert(Spy(5)).second == false);
+      assertUnit(us.numElements == 20);
+   }  // teardown
+
+   // a find walks down the tree rather than along the chain
+   void test_treeify_findLogCompares()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> us(64);
+      for (int i = 0; i < 30; i++)
+         us.insert(Spy(i));
+      Spy s(29);
+      Spy::reset();
+      // exercise
+      custom::unordered_set<Spy, Hash1<Spy>>::iterator it = us.find(s);
+      // verify
+      assertUnit(it != us.end());
+      assertUnit(*it == Spy(29));
+      assertUnit(Spy::numEquals() <= 1);
+      assertUnit(Spy::numLessthan() <= 2 * us.trees[0].index.height());
+      assertUnit(Spy::numLessthan() < 30);
+   }  // teardown
+
+   // a tree kept over a chain of 6 or 7 still indexes what is added
+   void test_treeify_insertBetweenThresholds()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> us(64);
+      for (int i = 0; i < 8; i++)
+         us.insert(Spy(i));
+      us.erase(Spy(0));
+      us.erase(Spy(1));
+      // exercise
+      us.insert(Spy(100));
+      us.insert(Spy(101));
+      bool isInserted = us.insert(Spy(100)).second;
+      // verify
+      assertUnit(!isInserted);
+      assertUnit(us.size() == 8);
+      assertUnit(us.trees.size() == 1);
+      assertUnit(us.trees[0].index.size() == 8);
+      assertUnit(us.find(Spy(100)) != us.end());
+      assertUnit(us.find(Spy(101)) != us.end());
+      for (int i = 2; i < 8; i++)
+         assertUnit(us.find(Spy(i)) != us.end());
+   }  // teardown
+
+   // erasing down past the low threshold drops the tree
+   void test_treeify_eraseUntreeify()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> us(64);
+      for (int i = 0; i < 10; i++)
+         us.insert(Spy(i));
+      assertUnit(us.trees.size() == 1);
+      // exercise
+      us.erase(Spy(0));
+      us.erase(Spy(9));
+      us.erase(Spy(4));
+      bool treedAtSeven = us.trees.size() == 1 && us.trees[0].index.size() == 7;
+      us.erase(Spy(1));
+      us.erase(Spy(2));
+      // verify
+      assertUnit(treedAtSeven);
+      assertUnit(us.trees.size() == 0);
+      assertUnit(us.numElements == 5);
+      assertUnit(us.find(Spy(3)) != us.end());
+      assertUnit(us.find(Spy(8)) != us.end());
+      assertUnit(us.find(Spy(4)) == us.end());
+   }  // teardown
+
+   // moving the nodes into new buckets builds the trees again
+   void test_treeify_rehashRebuilds()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> us(64);
+      for (int i = 0; i < 20; i++)
+         us.insert(Spy(i));
+      // exercise
+      us.rehash(128);
+      // verify
+      assertUnit(us.buckets.size() == 128);
+      assertUnit(us.trees.size() == 1);
+      assertUnit(us.trees[0].index.size() == 20);
+      for (int i = 0; i < 20; i++)
+         assertUnit(us.find(Spy(i)) != us.end());
+   }  // teardown
+
+   // a copy indexes its own nodes, not those of the original
+   void test_treeify_copyOwnTree()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> usSrc(64);
+      for (int i = 0; i < 20; i++)
+         usSrc.insert(Spy(i));
+      // exercise
+      custom::unordered_set<Spy, Hash1<Spy>> usDes(usSrc);
+      usSrc.clear();
+      // verify
+      assertUnit(usSrc.trees.size() == 0);
+      assertUnit(usDes.trees.size() == 1);
+      assertUnit(usDes.trees[0].index.size() == 20);
+      for (int i = 0; i < 20; i++)
+         assertUnit(usDes.find(Spy(i)) != usDes.end());
+   }  // teardown
+
+   // assignment builds its own nodes and tree, and survives itself
+   void test_treeify_assignOwnTree()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> usSrc(64);
+      for (int i = 0; i < 20; i++)
+         usSrc.insert(Spy(i));
+      custom::unordered_set<Spy, Hash1<Spy>> usDes;
+      usDes.insert(Spy(99));
+      Spy::reset();
+      // exercise
+      usDes = usSrc;
+      usDes = *&usDes;
+      int numAssigned = Spy::numAssign() + Spy::numAssignMove();
+      usSrc.clear();
+      // verify
+      assertUnit(numAssigned == 0);
+      assertUnit(usDes.size() == 20);
+      assertUnit(usDes.find(Spy(99)) == usDes.end());
+      assertUnit(usDes.trees.size() == 1);
+      assertUnit(usDes.trees[0].index.size() == 20);
+      for (int i = 0; i < 20; i++)
+         assertUnit(usDes.find(Spy(i)) != usDes.end());
+   }  // teardown
+
+   /***************************************
+    * STATS
+    ***************************************/
+
+   // eight empty buckets
+   void test_stats_empty()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      // exercise
+      custom::unordered_set_stats stats = us.stats();
+      // verify
+      assertUnit(stats.numElements == 0);
+      assertUnit(stats.numBuckets == 8);
+      assertUnit(stats.numEmpty == 8);
+      assertUnit(stats.histogram.size() == 1);
+      assertUnit(stats.histogram[0] == 8);
+      assertUnit(stats.maxProbeHit == 0);
+      assertUnit(stats.meanProbeHit == 0.0);
+      assertUnit(stats.meanProbeMiss == 0.0);
+      assertUnit(stats.chiSquared == 0.0);
+      assertUnit(stats.bytesNodes == 0);
+   }  // teardown
+
+   // the standard fixture: chains of 1, 2, 1, and 0
+   void test_stats_standard()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      custom::unordered_set_stats stats = us.stats();
+      // verify
+      assertUnit(stats.numElements == 4);
+      assertUnit(stats.numBuckets == 4);
+      assertUnit(stats.numEmpty == 1);
+      assertUnit(stats.histogram.size() == 3);
+      assertUnit(stats.histogram[0] == 1);
+      assertUnit(stats.histogram[1] == 2);
+      assertUnit(stats.histogram[2] == 1);
+      assertUnit(stats.maxProbeHit == 2);
+      assertUnit(stats.maxProbeMiss == 2);
+      assertUnit(stats.meanProbeHit == 1.25);    // (1 + 1 + 2 + 1) / 4
+      assertUnit(stats.meanProbeMiss == 1.0);    // (1 + 2 + 1 + 0) / 4
+      assertUnit(stats.chiSquared == 2.0);       // 0 + 1 + 0 + 1
+      assertUnit(stats.uniformity() == 0.5);
+      assertUnit(Spy::numEquals() == 0);         // never looks at an element
+      assertUnit(Spy::numCopy() == 0);
+   }  // teardown
+
+   // what the buckets and nodes take
+   void test_stats_bytes()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> us(64);
+      for (int i = 0; i < 10; i++)
+         us.insert(Spy(i));
+      // exercise
+      custom::unordered_set_stats stats = us.stats();
+      // verify
+      assertUnit(stats.bytesBuckets == 64 * sizeof(custom::list<Spy>));
+      assertUnit(stats.bytesNodes == 10 * custom::list<Spy>::node_size());
+      assertUnit(stats.bytesNodes >= 10 * (sizeof(Spy) + 2 * sizeof(void*)));
+      assertUnit(stats.bytesTrees > 10 * sizeof(void*));
+      assertUnit(stats.histogram.size() == 11);
+      assertUnit(stats.histogram[10] == 1);
+      assertUnit(stats.histogram[0] == 63);
+   }  // teardown
+
+   /***************************************
+    * OCCUPANCY
+    ***************************************/
+
+   // bits 3, 64, and 130 of 150, across three words
+   void test_occupancy_next()
+   {  // setup
+      custom::occupancy_bitmap<> bitmap(150);
+      bitmap.mark(3);
+      bitmap.mark(64);
+      bitmap.mark(130);
+      // exercise and verify
+      assertUnit(bitmap.words.size() == 3);
+      assertUnit(bitmap.next(0) == 3);
+      assertUnit(bitmap.next(3) == 3);
+      assertUnit(bitmap.next(4) == 64);
+      assertUnit(bitmap.next(65) == 130);
+      assertUnit(bitmap.next(131) == 150);
+      assertUnit(bitmap.next(150) == 150);
+      bitmap.unmark(64);
+      assertUnit(!bitmap.test(64));
+      assertUnit(bitmap.next(4) == 130);
+      assertUnit(custom::count_trailing_zeros((uint64_t)1 << 63) == 63);
+   }  // teardown
+
+   // h[0], h[1], and h[2] are marked; h[3] is not
+   void test_occupancy_standard()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy::reset();
+      // exercise
+      custom::unordered_set<Spy>::iterator it = us.begin();
+      // verify
+      assertUnit(us.occupied.size() == 4);
+      assertUnit(us.occupied.words[0] == 0x7);
+      assertUnit(it.pOccupied == us.occupied.data());
+      assertUnit(it.itVector == us.buckets.begin());
+      assertUnit(Spy::numEquals() == 0);   // begin() never looks at an element
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a bucket is marked by its first element and cleared by its last
+   void test_occupancy_insertErase()
+   {  // setup
+      custom::unordered_set<Spy> us(16);
+      us.seed = 0;   // place by the plain hash
+      // exercise
+      us.insert(Spy(49));   // bucket 13
+      us.insert(Spy(67));   // bucket 13
+      us.insert(Spy(5));    // bucket 5
+      uint64_t wordFull = us.occupied.words[0];
+      us.erase(Spy(49));
+      uint64_t wordOne = us.occupied.words[0];
+      us.erase(Spy(67));
+      // verify
+      assertUnit(wordFull == ((1u << 13) | (1u << 5)));
+      assertUnit(wordOne == wordFull);
+      assertUnit(us.occupied.words[0] == (1u << 5));
+      us.clear();
+      assertUnit(us.occupied.words[0] == 0);
+      assertUnit(us.begin() == us.end());
+   }  // teardown
+
+   // a rehash draws a new bitmap to go with the new buckets
+   void test_occupancy_rehash()
+   {  // setup
+      custom::unordered_set<int> us;
+      for (int i = 0; i < 100; i++)
+         us.insert(i * 7);
+      // exercise
+      us.rehash(1000);
+      // verify
+      assertUnit(us.occupied.size() == us.bucket_count());
+      for (size_t i = 0; i < us.bucket_count(); i++)
+         assertUnit(us.occupied.test(i) == !us.buckets[i].empty());
+   }  // teardown
+
+   // ten elements in a hundred thousand buckets, then a hundred erased of a hundred and ten
+   void test_occupancy_iterateSparse()
+   {  // setup
+      custom::unordered_set<int> us(100000);
+      for (int i = 0; i < 110; i++)
+         us.insert(i * 9973);
+      for (int i = 10; i < 110; i++)
+         us.erase(i * 9973);
+      int sum = 0;
+      int count = 0;
+      // exercise
+      for (auto it = us.begin(); it != us.end(); ++it)
+      {
+         sum += *it / 9973;
+         count++;
+      }
+      // verify
+      assertUnit(count == 10);
+      assertUnit(sum == 45);   // 0 + 1 + ... + 9
+   }  // teardown
+
+   /***************************************
+    * MEMORY
+    ***************************************/
+
+   // only the array of eight buckets, in one allocation
+   void test_memory_empty()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      // exercise
+      custom::unordered_set_memory memory = us.memory_usage();
+      // verify
+      assertUnit(memory.bucketArray == 8 * sizeof(custom::list<Spy>));
+      assertUnit(memory.nodes == 0);
+      assertUnit(memory.trees == 0);
+      assertUnit(memory.occupancy == sizeof(uint64_t));
+      assertUnit(memory.numAllocations == 2);
+      assertUnit(memory.allocatorOverhead >= 16);
+      assertUnit(memory.total() == memory.bucketArray + memory.occupancy + memory.allocatorOverhead);
+   }  // teardown
+
+   // one node, and one malloc header, per element
+   void test_memory_nodes()
+   {  // setup
+      custom::unordered_set<Spy> us(16);
+      custom::unordered_set_memory memoryBefore = us.memory_usage();
+      // exercise
+      for (int i = 0; i < 5; i++)
+         us.insert(Spy(i));
+      custom::unordered_set_memory memory = us.memory_usage();
+      // verify
+      size_t nodeSize = custom::list<Spy>::node_size();
+      assertUnit(memory.bucketArray == memoryBefore.bucketArray);
+      assertUnit(memory.nodes == 5 * nodeSize);
+      assertUnit(memory.numAllocations == 7);
+      assertUnit(memory.allocatorOverhead - memoryBefore.allocatorOverhead ==
+                 5 * (custom::malloc_block_size(nodeSize) - nodeSize));
+      assertUnit(custom::malloc_block_size(1) == 32);
+      assertUnit(custom::malloc_block_size(24) == 32);
+      assertUnit(custom::malloc_block_size(25) == 48);
+   }  // teardown
+
+   // stats() reports the same bytes, trees included
+   void test_memory_matchesStats()
+   {  // setup
+      custom::unordered_set<Spy, Hash1<Spy>> us(64);
+      for (int i = 0; i < 10; i++)
+         us.insert(Spy(i));
+      // exercise
+      custom::unordered_set_memory memory = us.memory_usage();
+      custom::unordered_set_stats stats = us.stats();
+      // verify
+      assertUnit(memory.bucketArray == stats.bytesBuckets);
+      assertUnit(memory.nodes == stats.bytesNodes);
+      assertUnit(memory.trees == stats.bytesTrees);
+      assertUnit(memory.numAllocations == 1 + 10 + 1 + 10 + 1);
+   }  // teardown
+
+   // a memory resource adds no headers we know of
+   void test_memory_noOverheadPmr()
+   {  // setup
+      custom::pmr::unordered_set<int> us(std::pmr::new_delete_resource());
+      us.insert(7);
+      // exercise
+      custom::unordered_set_memory memory = us.memory_usage();
+      // verify
+      typedef custom::list<int, std::pmr::polymorphic_allocator<int>> Bucket;
+      assertUnit(memory.nodes == Bucket::node_size());
+      assertUnit(memory.allocatorOverhead == 0);
+      assertUnit(memory.total() == memory.bucketArray + memory.nodes + memory.occupancy);
+   }  // teardown
+
+   /***************************************
+    * COUNTERS
+    ***************************************/
+   typedef custom::unordered_set<Spy, std::hash<Spy>, std::equal_to<Spy>,
+                                 std::allocator<Spy>, custom::relaxed_counters> CountedSet;
+
+   // the default policy takes no room and counts nothing
+   void test_counters_off()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      us.insert(Spy(31));
+      // exercise
+      us.find(Spy(31));
+      custom::unordered_set_counters c = us.counters();
+      // verify
+      assertUnit(sizeof(CountedSet) >=
+                 sizeof(custom::unordered_set<Spy>) + custom::relaxed_counters::NUM_STRIPES * 64);
+      assertUnit(c.finds == 0);
+      assertUnit(c.inserts == 0);
+   }  // teardown
+
+   // buckets 0: 31, 1: 49 67, 2: 59, 3: empty
+   void test_counters_find()
+   {  // setup
+      CountedSet us(4);
+      us.seed = 0;   // place by the plain hash
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.insert(Spy(59));
+      us.insert(Spy(67));
+      us.reset_counters();
+      // exercise
+      us.find(Spy(67));   // second in bucket 1
+      us.find(Spy(13));   // bucket 0, not there
+      us.find(Spy(3));    // bucket 3, empty
+      custom::unordered_set_counters c = us.counters();
+      // verify
+      assertUnit(us.buckets.size() == 4);
+      assertUnit(c.finds == 3);
+      assertUnit(c.hits == 1);
+      assertUnit(c.misses == 2);
+      assertUnit(c.nodesVisited == 3);
+      assertUnit(c.inserts == 0);
+   }  // teardown
+
+   // an erase is not a find, and a duplicate is not an insert
+   void test_counters_insertErase()
+   {  // setup
+      CountedSet us(8);
+      // exercise
+      us.insert(Spy(1));
+      us.insert(Spy(2));
+      us.insert(Spy(1));
+      us.erase(Spy(2));
+      us.erase(Spy(5));
+      custom::unordered_set_counters c = us.counters();
+      // verify
+      assertUnit(c.inserts == 2);
+      assertUnit(c.duplicateInserts == 1);
+      assertUnit(c.erases == 1);
+      assertUnit(c.finds == 0);
+      assertUnit(c.rehashes == 0);
+   }  // teardown
+
+   // growing counts one rehash of what was there
+   void test_counters_rehash()
+   {  // setup
+      CountedSet us(4);
+      us.insert(Spy(1));
+      us.insert(Spy(2));
+      us.insert(Spy(3));
+      // exercise
+      us.rehash(16);
+      us.rehash(8);       // already big enough
+      custom::unordered_set_counters c = us.counters();
+      // verify
+      assertUnit(us.buckets.size() == 16);
+      assertUnit(c.rehashes == 1);
+      assertUnit(c.rehashElements == 3);
+   }  // teardown
+
+   // counts belong to the set, not to its contents
+   void test_counters_copyStartsOver()
+   {  // setup
+      CountedSet usSrc(8);
+      usSrc.insert(Spy(1));
+      usSrc.find(Spy(1));
+      // exercise
+      CountedSet usDes(usSrc);
+      usDes.find(Spy(1));
+      // verify
+      assertUnit(usSrc.counters().finds == 1);
+      assertUnit(usDes.counters().finds == 1);
+      assertUnit(usDes.counters().inserts == 0);
+   }  // teardown
+
+   /***************************************
+    * CONST
+    ***************************************/
+
+   // find through a const reference, hit and miss
+   void test_const_find()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      const custom::unordered_set<Spy>& cus = us;
+      Spy::reset();
+      // exercise
+      custom::unordered_set<Spy>::const_iterator itHit = cus.find(Spy(67));
+      custom::unordered_set<Spy>::const_iterator itMiss = cus.find(Spy(12));
+      // verify
+      assertUnit(itHit != cus.end());
+      if (itHit != cus.end())
+         assertUnit(*itHit == Spy(67));
+      assertUnit(itHit == us.find(Spy(67)));
+      assertUnit(itMiss == cus.end());
+      assertUnit(cus.bucket(Spy(67)) == 1);
+      assertUnit(Spy::numCopy() == 0);
+      assertStandardFixture(us);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a const walk sees what a plain one does, in the same order
+   void test_const_iterate()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      const custom::unordered_set<Spy>& cus = us;
+      std::vector<int> values;
+      // exercise
+      for (custom::unordered_set<Spy>::const_iterator it = cus.cbegin(); it != cus.cend(); ++it)
+         values.push_back((*it).get());
+      // verify
+      assertUnit(values == std::vector<int>({ 31, 49, 67, 59 }));
+      assertUnit(us.begin() == cus.begin());
+      assertUnit(custom::unordered_set<Spy>::const_iterator(us.end()) == cus.end());
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // one bucket of a const set
+   void test_const_localIterator()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      const custom::unordered_set<Spy>& cus = us;
+      std::vector<int> values;
+      // exercise
+      for (auto it = cus.begin(1); it != cus.end(1); ++it)
+         values.push_back((*it).get());
+      // verify
+      assertUnit(values == std::vector<int>({ 49, 67 }));
+      assertUnit(cus.cbegin(3) == cus.cend(3));
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a lookup on a const set still counts
+   void test_const_counted()
+   {  // setup
+      CountedSet us(4);
+      us.insert(Spy(31));
+      us.insert(Spy(49));
+      us.reset_counters();
+      const CountedSet& cus = us;
+      // exercise
+      cus.find(Spy(49));
+      cus.find(Spy(13));
+      custom::unordered_set_counters c = cus.counters();
+      // verify
+      assertUnit(c.finds == 2);
+      assertUnit(c.hits == 1);
+      assertUnit(c.misses == 1);
+   }  // teardown
+
+   // readers share one frozen set with no lock
+   void test_const_threads()
+   {  // setup
+      typedef custom::unordered_set<std::string, std::hash<std::string>, std::equal_to<std::string>,
+                                    std::allocator<std::string>, custom::relaxed_counters> Set;
+      Set us;
+      for (int i = 0; i < 1000; i++)
+         us.insert("key" + std::to_string(i));
+      const Set& cus = us;
+      int numFound[4] = {};
+      // exercise
+      std::vector<std::thread> readers;
+      for (int r = 0; r < 4; r++)
+         readers.push_back(std::thread([&cus, &numFound, r]() {
+            for (int i = 0; i < 2000; i++)
+               numFound[r] += cus.find("key" + std::to_string(i)) != cus.end();
+            for (Set::const_iterator it = cus.begin(); it != cus.end(); ++it)
+               numFound[r] += (*it)[0] == 'k' ? 0 : 1;
+         }));
+      for (std::thread& reader : readers)
+         reader.join();
+      // verify
+      for (int r = 0; r < 4; r++)
+         assertUnit(numFound[r] == 1000);
+      assertUnit(us.size() == 1000);
+      assertUnit(cus.counters().finds == 8000);
+      assertUnit(cus.counters().hits == 4000);
+   }  // teardown
+
+   /***************************************
+    * PREHASHED
+    ***************************************/
+
+   // the hash the caller passes in is the only one
+   void test_prehashed_find()
+   {  // setup
+      custom::unordered_set<int, CountingHash<int>> us;
+      us.insert({ 3, 14, 15, 92 });
+      size_t h15 = std::hash<int>()(15);
+      size_t h65 = std::hash<int>()(65);
+      CountingHash<int>::numCalls = 0;
+      // exercise
+      auto itHit = us.find(15, h15);
+      auto itMiss = us.find(65, h65);
+      // verify
+      assertUnit(CountingHash<int>::numCalls == 0);
+      assertUnit(itHit != us.end());
+      assertUnit(*itHit == 15);
+      assertUnit(itMiss == us.end());
+   }  // teardown
+
+   // a new element and a duplicate, neither hashed
+   void test_prehashed_insert()
+   {  // setup
+      custom::unordered_set<int, CountingHash<int>> us;
+      us.insert({ 3, 14, 15 });
+      CountingHash<int>::numCalls = 0;
+      // exercise
+      auto pairNew = us.insert(92, std::hash<int>()(92));
+      auto pairDup = us.insert(14, std::hash<int>()(14));
+      // verify
+      assertUnit(CountingHash<int>::numCalls == 0);
+      assertUnit(pairNew.second == true);
+      assertUnit(*pairNew.first == 92);
+      assertUnit(pairDup.second == false);
+      assertUnit(*pairDup.first == 14);
+      assertUnit(us.size() == 4);
+      assertUnit(us.find(92) != us.end());
+   }  // teardown
+
+   // growing hashes what was already there, but not the new one again
+   void test_prehashed_insertGrows()
+   {  // setup
+      custom::unordered_set<int, CountingHash<int>> us;
+      for (int i = 0; i < 8; i++)
+         us.insert(i);
+      assertUnit(us.bucket_count() == 8);
+      CountingHash<int>::numCalls = 0;
+      // exercise
+      auto pairNew = us.insert(8, std::hash<int>()(8));
+      // verify
+      assertUnit(us.bucket_count() > 8);
+      assertUnit(CountingHash<int>::numCalls == 8);   // the rehash, 0 through 7
+      assertUnit(pairNew.second == true);
+      assertUnit(*pairNew.first == 8);
+      assertUnit(us.find(8) != us.end());
+   }  // teardown
+
+   // erase finds what to take without hashing
+   void test_prehashed_erase()
+   {  // setup
+      custom::unordered_set<int, CountingHash<int>> us;
+      us.insert({ 3, 14, 15, 92 });
+      CountingHash<int>::numCalls = 0;
+      // exercise
+      us.erase(15, std::hash<int>()(15));
+      // verify
+      assertUnit(CountingHash<int>::numCalls == 0);
+      assertUnit(us.size() == 3);
+      assertUnit(us.find(15) == us.end());
+      assertUnit(us.find(92) != us.end());
+   }  // teardown
+
+   // the wrapper carries the hash through insert, find, and erase
+   void test_prehashed_wrapper()
+   {  // setup
+      custom::unordered_set<std::string, CountingHash<std::string>> us;
+      std::string s("prehashed");
+      size_t h = std::hash<std::string>()(s);
+      CountingHash<std::string>::numCalls = 0;
+      // exercise
+      bool isInserted = us.insert(custom::prehashed<std::string>(s, h)).second;
+      bool isFound = us.find(custom::prehashed<std::string>(s, h)) != us.end();
+      us.erase(custom::prehashed<std::string>(s, h));
+      // verify
+      assertUnit(CountingHash<std::string>::numCalls == 0);
+      assertUnit(isInserted);
+      assertUnit(isFound);
+      assertUnit(us.empty());
+   }  // teardown
+
+   // once the set is keyed, the caller's hash is of no use and is ignored
+   void test_prehashed_keyed()
+   {  // setup
+      custom::unordered_set<int> us;
+      us.insert({ 3, 14, 15, 92 });
+      us.defend();
+      // exercise
+      bool isFound = us.find(15, std::hash<int>()(15)) != us.end();
+      bool isNew = us.insert(65, std::hash<int>()(65)).second;
+      bool isFoundNew = us.find(65) != us.end();
+      us.erase(3, std::hash<int>()(3));
+      // verify
+      assertUnit(us.is_keyed());
+      assertUnit(isFound);
+      assertUnit(isNew);
+      assertUnit(isFoundNew);
+      assertUnit(us.find(3) == us.end());
+      assertUnit(us.size() == 4);
+   }  // teardown
+
+   // a chain with a tree finds by the given hash too
+   void test_prehashed_tree()
+   {  // setup
+      custom::unordered_set<int, Hash1<int>> us(64);
+      us.seed = 0;   // place by the plain hash
+      for (int i = 0; i < 20; i++)
+         us.insert(i);
+      assertUnit(us.tree(1) != nullptr);
+      // exercise
+      auto itHit = us.find(17, 1);
+      auto itMiss = us.find(20, 1);
+      // verify
+      assertUnit(itHit != us.end());
+      assertUnit(*itHit == 17);
+      assertUnit(itMiss == us.end());
+   }  // teardown
+
+   /***************************************
+    * HASH AND EQPRED
+    ***************************************/
+
+   // an empty Hash or EqPred adds nothing to the set; a seed adds itself
+   void test_functors_emptyTakeNoRoom()
+   {  // setup
+      typedef custom::unordered_set<int> Plain;
+      typedef custom::unordered_set<int, SeededHash<int>> Seeded;
+      // exercise
+      size_t sizePlain = sizeof(Plain);
+      size_t sizeSeeded = sizeof(Seeded);
+      // verify
+      assertUnit(sizeSeeded == sizePlain + sizeof(SeededHash<int>));
+   }  // teardown
+
+   // the set hashes with the instance it was given
+   void test_functors_seeded()
+   {  // setup
+      SeededHash<int> hash(0x5eed);
+      // exercise
+      custom::unordered_set<int, SeededHash<int>> us(16, hash);
+      us.seed = 0;   // place by the plain hash
+      us.insert({ 3, 14, 15, 92 });
+      // verify
+      assertUnit(us.hash_function().seed == 0x5eed);
+      assertUnit(us.bucket_count() == 16);
+      assertUnit(us.bucket(15) == (std::hash<int>()(15) ^ 0x5eed) % 16);
+      assertUnit(us.find(15) != us.end());
+      assertUnit(us.find(65) == us.end());
+   }  // teardown
+
+   // the Hash goes along with the elements
+   void test_functors_copyMoveSwap()
+   {  // setup
+      custom::unordered_set<int, SeededHash<int>> us1(16, SeededHash<int>(1));
+      custom::unordered_set<int, SeededHash<int>> us2(16, SeededHash<int>(2));
+      us1.insert({ 3, 14 });
+      us2.insert({ 15, 92 });
+      // exercise
+      custom::unordered_set<int, SeededHash<int>> usCopy(us1);
+      custom::unordered_set<int, SeededHash<int>> usMove(std::move(usCopy));
+      us1.swap(us2);
+      // verify
+      assertUnit(usMove.hash_function().seed == 1);
+      assertUnit(usMove.find(14) != usMove.end());
+      assertUnit(us1.hash_function().seed == 2);
+      assertUnit(us1.find(92) != us1.end());
+      assertUnit(us2.hash_function().seed == 1);
+      assertUnit(us2.find(3) != us2.end());
+   }  // teardown
+
+   // every comparison goes through EqPred
+   void test_functors_eqPred()
+   {  // setup
+      custom::unordered_set<std::string, CaseInsensitiveHash, CaseInsensitiveEqual> us;
+      us.insert("Hello");
+      // exercise
+      bool isNew = us.insert("HELLO").second;
+      bool isFound = us.find("hello") != us.end();
+      us.erase("hELLo");
+      // verify
+      assertUnit(!isNew);
+      assertUnit(isFound);
+      assertUnit(us.empty());
+   }  // teardown
+
+   // operator < may not agree with EqPred, so a long chain gets no tree
+   void test_functors_eqPredNoTree()
+   {  // setup
+      custom::unordered_set<std::string, Hash1<std::string>, CaseInsensitiveEqual> us(64);
+      us.seed = 0;   // place by the plain hash
+      for (int i = 0; i < 20; i++)
+         us.insert("key" + std::to_string(i));
+      // exercise
+      bool isFound = us.find("KEY17") != us.end();
+      bool isNew = us.insert("Key3").second;
+      // verify
+      assertUnit(us.bucket_size(1) == 20);
+      assertUnit(us.tree(1) == nullptr);
+      assertUnit(isFound);
+      assertUnit(!isNew);
+   }  // teardown
+
+   // once keyed, elements EqPred calls equal still share a bucket
+   void test_functors_eqPredKeyed()
+   {  // setup
+      custom::unordered_set<std::string, CaseInsensitiveHash, CaseInsensitiveEqual> us;
+      us.insert({ "alpha", "beta", "gamma" });
+      us.defend();
+      // exercise
+      bool isNew = us.insert("BETA").second;
+      bool isFound = us.find("Gamma") != us.end();
+      // verify
+      assertUnit(us.is_keyed());
+      assertUnit(!isNew);
+      assertUnit(isFound);
+      assertUnit(us.size() == 3);
+   }  // teardown
+
+   /***************************************
+    * OPERATION BUDGETS
+    * Upper bounds on what each operation may do to the elements.
+    * These are performance contracts: a change that adds a copy, a
+    * move, or a scan of the chain should fail here.
+    ***************************************/
+
+   // a new element is copied once and compared at most once per node in its chain
+   void test_budget_insertNew()
+   {  // setup
+      // h[0] --> 31
+      // h[1] --> 49 67
+      // h[2] --> 59
+      // h[3] -->
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(58);   // (5 + 8) % 4 = 1
+      Spy::reset();
+      // exercise
+      us.insert(s);
+      // verify
+      assertUnit(Spy::numCopy() == 1);
+      assertUnit(Spy::numAlloc() == 1);
+      assertUnit(Spy::numEquals() <= 2);   // 49, 67
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(us.buckets[1].size() == 3);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a duplicate is compared against its chain once and nothing else
+   void test_budget_insertDuplicate()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(67);
+      Spy::reset();
+      // exercise
+      us.insert(s);
+      // verify
+      assertUnit(Spy::numEquals() <= 2);   // 49, 67
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // growing the table on the way in does not touch the old elements
+   void test_budget_insertGrows()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      us.maxLoadFactor = 1.0;
+      Spy s(44);   // (4 + 4) % 4 = 0, with 31
+      Spy::reset();
+      // exercise
+      us.insert(s);
+      // verify
+      assertUnit(us.buckets.size() == 8);
+      assertUnit(Spy::numCopy() == 1);
+      assertUnit(Spy::numAlloc() == 1);
+      assertUnit(Spy::numEquals() <= 1);   // 31
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // n inserts cost n copies, however many times the table grows
+   void test_budget_insertMany()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      std::vector<Spy> spies;
+      for (int i = 0; i < 1000; i++)
+         spies.push_back(Spy(i * 101));
+      Spy::reset();
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         us.insert(spies[i]);
+      // verify
+      assertUnit(us.numElements == 1000);
+      assertUnit(Spy::numCopy() == 1000);
+      assertUnit(Spy::numAlloc() == 1000);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+   }  // teardown
+
+   // a hit stops at the element
+   void test_budget_findHit()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(49);
+      Spy::reset();
+      // exercise
+      us.find(s);
+      // verify
+      assertUnit(Spy::numEquals() == 1);   // 49 is first in its chain
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a miss looks at its own chain and no other
+   void test_budget_findMiss()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(85);   // (8 + 5) % 4 = 1
+      Spy::reset();
+      // exercise
+      us.find(s);
+      // verify
+      assertUnit(Spy::numEquals() == 2);   // 49, 67
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // erasing destroys exactly the one element
+   void test_budget_erase()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      Spy s(67);
+      Spy::reset();
+      // exercise
+      us.erase(s);
+      // verify
+      assertUnit(Spy::numEquals() <= 2);   // 49, 67
+      assertUnit(Spy::numDestructor() == 1);
+      assertUnit(Spy::numDelete() == 1);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   // a rehash relinks nodes: no copies, moves, allocations, or compares
+   void test_budget_rehash()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      for (int i = 0; i < 500; i++)
+         us.insert(Spy(i * 7));
+      Spy* pFirst = &*us.find(Spy(0));
+      Spy::reset();
+      // exercise
+      us.rehash(5000);
+      // verify
+      assertUnit(us.buckets.size() == 5000);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(&*us.find(Spy(0)) == pFirst);   // the same node
+   }  // teardown
+
+   // walking the set touches nothing
+   void test_budget_iterate()
+   {  // setup
+      custom::unordered_set<Spy> us;
+      setupStandardFixture(us);
+      int count = 0;
+      Spy::reset();
+      // exercise
+      for (auto it = us.begin(); it != us.end(); ++it)
+         count++;
+      // verify
+      assertUnit(count == 4);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      // teardown
+      teardownStandardFixture(us);
+   }
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      h[0] --> 31 
+    *      h[1] --> 49 67
+    *      h[2] --> 59 
+    *      h[3] --> 
+    *************************************************************/
+   void setupStandardFixture(custom::unordered_set<Spy> & us)
+   {
+      // clear out whatever the default constructor created, and place
+      // elements by the plain hash
+      us.buckets.clear();
+      us.seed = 0;
+
+      // allocate 4 buckets
+      us.buckets.resize(4);
+      assert(us.buckets.size() == 4);
+      
+      // place in four elements
+      std::hash<Spy> pHash;
+      assert(pHash(Spy(31)) % size_t(4) == 0);
+      us.buckets[0].push_back(Spy(31));
+      assert(pHash(Spy(49)) % size_t(4) == 1);
+      us.buckets[1].push_back(Spy(49));
+      assert(pHash(Spy(59)) % size_t(4) == 2);
+      us.buckets[2].push_back(Spy(59));
+      assert(pHash(Spy(67)) % size_t(4) == 1);
+      us.buckets[1].push_back(Spy(67));
+      us.remark_occupied();
 
       // set the number of elements
       us.numElements = 4;
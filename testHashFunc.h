@@ -0,0 +1,198 @@
+/***********************************************************************
+ * Header:
+ *    TEST HASH FUNC
+ * Summary:
+ *    Unit tests for the hash functions
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+#ifdef DEBUG
+
+#include "hashfunc.h"   // functions under test
+#include "hash.h"       // to use them as a Hash
+#include "unitTest.h"   // unit test baseclass
+
+#include <cstdint>
+#include <string>
+
+/***********************************************
+ * TEST HASH FUNC
+ * Unit tests for mix64, hash_bytes, crc_bytes and the Hash wrappers
+ ***********************************************/
+class TestHashFunc : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Integers
+      test_mix64_avalanche();
+      test_hash_integerSpread();
+
+      // Bytes
+      test_hashBytes_everyLength();
+      test_hashBytes_seed();
+      test_hashBytes_simdMatchesScalar();
+      test_crcBytes_everyLength();
+      test_siphash_reference();
+
+      // Drop-in
+      test_hash_stringMatchesView();
+      test_hash_inUnorderedSet();
+
+      report("HashFunc");
+   }
+
+   /***************************************
+    * INTEGERS
+    ***************************************/
+
+   // flipping one input bit flips close to half the output bits
+   void test_mix64_avalanche()
+   {  // setup
+      uint64_t numFlipped = 0;
+      // exercise
+      for (int bit = 0; bit < 64; bit++)
+         for (uint64_t k = 1; k <= 16; k++)
+            numFlipped += popcount(custom::mix64(k) ^ custom::mix64(k ^ ((uint64_t)1 << bit)));
+      // verify
+      uint64_t numTrials = 64 * 16;
+      assertUnit(numFlipped > numTrials * 30);
+      assertUnit(numFlipped < numTrials * 34);
+   }  // teardown
+
+   // multiples of the bucket count no longer share a bucket
+   void test_hash_integerSpread()
+   {  // setup
+      custom::hash<uint64_t> h;
+      bool used[64] = {};
+      size_t numUsed = 0;
+      // exercise
+      for (uint64_t k = 0; k < 64; k++)
+      {
+         size_t i = h(k * 64) % 64;
+         if (!used[i])
+            numUsed++;
+         used[i] = true;
+      }
+      // verify: std::hash puts all 64 in bucket 0
+      assertUnit(numUsed > 32);
+   }  // teardown
+
+   /***************************************
+    * BYTES
+    ***************************************/
+
+   // every length from 0 past the long path, and each one differs
+   // from the same bytes one shorter
+   void test_hashBytes_everyLength()
+   {  // setup
+      unsigned char buffer[1500];
+      for (size_t i = 0; i < sizeof(buffer); i++)
+         buffer[i] = (unsigned char)(i * 131 + 7);
+      bool allDiffer = true;
+      // exercise
+      for (size_t len = 1; len <= sizeof(buffer); len++)
+         allDiffer = allDiffer && custom::hash_bytes(buffer, len) != custom::hash_bytes(buffer, len - 1);
+      // verify
+      assertUnit(allDiffer);
+      assertUnit(custom::hash_bytes(buffer, 1000) == custom::hash_bytes(buffer, 1000));
+   }  // teardown
+
+   void test_hashBytes_seed()
+   {  // setup
+      const char* s = "the quick brown fox";
+      // exercise
+      uint64_t a = custom::hash_bytes(s, 19, 1);
+      uint64_t b = custom::hash_bytes(s, 19, 2);
+      // verify
+      assertUnit(a != b);
+      assertUnit(a == custom::hash_bytes(s, 19, 1));
+   }  // teardown
+
+   // whichever instructions were compiled in, the stripes add up the same
+   void test_hashBytes_simdMatchesScalar()
+   {  // setup
+      unsigned char buffer[64 * 20];
+      for (size_t i = 0; i < sizeof(buffer); i++)
+         buffer[i] = (unsigned char)(i * 37 + 11);
+      uint64_t accScalar[8];
+      uint64_t accSimd[8];
+      for (int i = 0; i < 8; i++)
+         accScalar[i] = accSimd[i] = 0x0123456789abcdefull * (i + 1);
+      // exercise
+      custom::hash_detail::accumulate_scalar(accScalar, buffer, 20);
+      custom::hash_detail::accumulate_simd(accSimd, buffer, 20);
+      // verify
+      for (int i = 0; i < 8; i++)
+         assertUnit(accScalar[i] == accSimd[i]);
+   }  // teardown
+
+   void test_crcBytes_everyLength()
+   {  // setup
+      unsigned char buffer[100];
+      for (size_t i = 0; i < sizeof(buffer); i++)
+         buffer[i] = (unsigned char)(i * 29 + 3);
+      bool allDiffer = true;
+      // exercise
+      for (size_t len = 1; len <= sizeof(buffer); len++)
+         allDiffer = allDiffer && custom::crc_bytes(buffer, len) != custom::crc_bytes(buffer, len - 1);
+      // verify
+      assertUnit(allDiffer);
+      assertUnit(custom::crc_hash<uint32_t>()(7) != custom::crc_hash<uint32_t>()(8));
+   }  // teardown
+
+   // the test vector from the SipHash paper
+   void test_siphash_reference()
+   {  // setup
+      unsigned char message[15];
+      for (int i = 0; i < 15; i++)
+         message[i] = (unsigned char)i;
+      // exercise
+      uint64_t h = custom::siphash(message, 15, 0x0706050403020100ull, 0x0f0e0d0c0b0a0908ull);
+      // verify
+      assertUnit(h == 0xa129ca6149be45e5ull);
+   }  // teardown
+
+   /***************************************
+    * DROP-IN
+    ***************************************/
+
+   void test_hash_stringMatchesView()
+   {  // setup
+      std::string s = "a string long enough to skip the small string buffer";
+      // exercise
+      size_t a = custom::hash<std::string>()(s);
+      size_t b = custom::hash<std::string_view>()(s);
+      // verify
+      assertUnit(a == b);
+      assertUnit(custom::crc_hash<std::string>()(s) == custom::crc_hash<std::string_view>()(s));
+   }  // teardown
+
+   void test_hash_inUnorderedSet()
+   {  // setup
+      custom::unordered_set<uint64_t, custom::hash<uint64_t>> us;
+      // exercise
+      for (uint64_t k = 0; k < 100; k++)
+         us.insert(k * 1024);
+      // verify
+      assertUnit(us.size() == 100);
+      for (uint64_t k = 0; k < 100; k++)
+         assertUnit(us.find(k * 1024) != us.end());
+      assertUnit(us.find(1) == us.end());
+   }  // teardown
+
+   static int popcount(uint64_t x)
+   {
+      int num = 0;
+      for (; x; x &= x - 1)
+         num++;
+      return num;
+   }
+};
+
+#endif // DEBUG
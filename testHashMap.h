@@ -0,0 +1,341 @@
+/***********************************************************************
+ * Header:
+ *    TEST HASH MAP
+ * Summary:
+ *    Unit tests for unordered_map
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+#ifdef DEBUG
+
+#include "hashmap.h"    // class under test
+#include "spy.h"        // for the Spy class
+#include "unitTest.h"   // unit test baseclass
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+/***********************************************
+ * TEST HASH MAP
+ * Unit tests for the unordered_map class
+ ***********************************************/
+class TestHashMap : public UnitTest
+{
+   // std::hash, counting how often a key is hashed
+   class CountingKeyHash
+   {
+   public:
+      static inline int numCalls = 0;
+      size_t operator() (const std::string& s) const { numCalls++; return std::hash<std::string>()(s); }
+   };
+
+   // every key collides, in the full hash and not just in a bucket
+   class ConstantKeyHash
+   {
+   public:
+      size_t operator() (const std::string& s) const { return 42; }
+   };
+
+public:
+   void run()
+   {
+      reset();
+
+      // Access
+      test_subscript_count();
+      test_subscript_oneHash();
+      test_at_missing();
+      test_iterator_mutable();
+
+      // Insert
+      test_tryEmplace_missBuilds();
+      test_tryEmplace_hitBuildsNothing();
+      test_insertOrAssign();
+      test_insert_duplicate();
+
+      // Remove
+      test_erase();
+
+      // Flood
+      test_flood_fullCollisions();
+
+      // Construct
+      test_construct_copy();
+      test_assign_copy();
+
+      // Against the standard library
+      test_random();
+
+      report("HashMap");
+   }
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // the counter idiom: a missing key starts at V()
+   void test_subscript_count()
+   {  // setup
+      custom::unordered_map<std::string, int> um;
+      const char* words[] = { "the", "cat", "the", "hat", "the", "cat" };
+      // exercise
+      for (const char* word : words)
+         um[word]++;
+      // verify
+      assertUnit(um.size() == 3);
+      assertUnit(um["the"] == 3);
+      assertUnit(um["cat"] == 2);
+      assertUnit(um["hat"] == 1);
+      assertUnit(um.size() == 3);
+   }  // teardown
+
+   // a miss and then a hit each hash the key once and walk the chain once
+   void test_subscript_oneHash()
+   {  // setup
+      custom::unordered_map<std::string, int, CountingKeyHash, std::equal_to<std::string>,
+         std::allocator<custom::pair<const std::string, int>>, custom::relaxed_counters> um(64);
+      CountingKeyHash::numCalls = 0;
+      // exercise
+      um["apple"] = 1;
+      int hashesMiss = CountingKeyHash::numCalls;
+      um["apple"]++;
+      int hashesHit = CountingKeyHash::numCalls - hashesMiss;
+      // verify
+      assertUnit(hashesMiss == 1);
+      assertUnit(hashesHit == 1);
+      assertUnit(um.counters().inserts == 1);
+      assertUnit(um.counters().duplicateInserts == 1);
+      assertUnit(um.counters().finds == 0);
+      assertUnit(um["apple"] == 2);
+   }  // teardown
+
+   // at() throws for a missing key and adds nothing
+   void test_at_missing()
+   {  // setup
+      custom::unordered_map<int, int> um;
+      um[1] = 10;
+      bool isThrown = false;
+      // exercise
+      try
+      {
+         um.at(2);
+      }
+      catch (const char* error)
+      {
+         isThrown = true;
+      }
+      // verify
+      assertUnit(isThrown);
+      assertUnit(um.at(1) == 10);
+      assertUnit(um.size() == 1);
+   }  // teardown
+
+   // the value can be changed through an iterator, the key cannot
+   void test_iterator_mutable()
+   {  // setup
+      custom::unordered_map<int, int> um;
+      for (int i = 0; i < 100; i++)
+         um[i] = i;
+      // exercise
+      for (auto it = um.begin(); it != um.end(); ++it)
+         (*it).second *= 2;
+      // verify
+      int sum = 0;
+      for (auto it = um.cbegin(); it != um.cend(); ++it)
+      {
+         assertUnit((*it).second == (*it).first * 2);
+         sum += (*it).second;
+      }
+      assertUnit(sum == 99 * 100);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // a miss builds the value once, in its node
+   void test_tryEmplace_missBuilds()
+   {  // setup
+      custom::unordered_map<int, Spy> um;
+      Spy::reset();
+      // exercise
+      auto result = um.try_emplace(5, 50);
+      int numBuilt = Spy::numNondefault();
+      int numCopied = Spy::numCopy();
+      int numMoved = Spy::numCopyMove();
+      // verify
+      assertUnit(result.second);
+      assertUnit((*result.first).first == 5);
+      assertUnit((*result.first).second == Spy(50));
+      assertUnit(numBuilt == 1);
+      assertUnit(numCopied == 0);
+      assertUnit(numMoved <= 1);   // into the pair
+   }  // teardown
+
+   // a hit builds, copies and assigns nothing
+   void test_tryEmplace_hitBuildsNothing()
+   {  // setup
+      custom::unordered_map<int, Spy> um;
+      um.try_emplace(5, 50);
+      Spy::reset();
+      // exercise
+      auto result = um.try_emplace(5, 99);
+      int numBuilt = Spy::numNondefault() + Spy::numDefault();
+      int numCopied = Spy::numCopy() + Spy::numCopyMove();
+      int numAssigned = Spy::numAssign() + Spy::numAssignMove();
+      // verify
+      assertUnit(!result.second);
+      assertUnit(numBuilt == 0);
+      assertUnit(numCopied == 0);
+      assertUnit(numAssigned == 0);
+      assertUnit((*result.first).second == Spy(50));
+   }  // teardown
+
+   // the value is replaced on a hit and added on a miss
+   void test_insertOrAssign()
+   {  // setup
+      custom::unordered_map<std::string, std::string> um;
+      um["a"] = "apple";
+      // exercise
+      auto hit = um.insert_or_assign("a", std::string("avocado"));
+      auto miss = um.insert_or_assign("b", std::string("banana"));
+      // verify
+      assertUnit(!hit.second);
+      assertUnit(miss.second);
+      assertUnit(um.size() == 2);
+      assertUnit(um.at("a") == "avocado");
+      assertUnit(um.at("b") == "banana");
+   }  // teardown
+
+   // insert() leaves the value that is there alone
+   void test_insert_duplicate()
+   {  // setup
+      custom::unordered_map<int, int> um;
+      um.insert(custom::pair<const int, int>(7, 70));
+      // exercise
+      auto result = um.insert(custom::pair<const int, int>(7, 77));
+      // verify
+      assertUnit(!result.second);
+      assertUnit(um.at(7) == 70);
+      assertUnit(um.size() == 1);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   void test_erase()
+   {  // setup
+      custom::unordered_map<int, int> um;
+      for (int i = 0; i < 10; i++)
+         um[i] = i;
+      // exercise
+      um.erase(3);
+      um.erase(42);
+      // verify
+      assertUnit(um.size() == 9);
+      assertUnit(um.count(3) == 0);
+      assertUnit(um.find(3) == um.end());
+      assertUnit(um.count(4) == 1);
+   }  // teardown
+
+   /***************************************
+    * FLOOD
+    ***************************************/
+
+   // keys whose whole hashes collide are scattered by their own bytes
+   void test_flood_fullCollisions()
+   {  // setup
+      custom::unordered_map<std::string, int, ConstantKeyHash> um(1024);
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         um["key" + std::to_string(i)] = i;
+      // verify
+      size_t maxChain = 0;
+      for (size_t i = 0; i < um.bucket_count(); i++)
+         maxChain = std::max(maxChain, um.bucket_size(i));
+      assertUnit(um.is_keyed());
+      assertUnit(maxChain < 16);
+      assertUnit(um.size() == 1000);
+      bool isFound = true;
+      for (int i = 0; i < 1000; i++)
+         isFound = isFound && um.at("key" + std::to_string(i)) == i;
+      assertUnit(isFound);
+      assertUnit(um.count("key1000") == 0);
+   }  // teardown
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // the copy has its own values
+   void test_construct_copy()
+   {  // setup
+      custom::unordered_map<std::string, int> umSrc = { { "one", 1 }, { "two", 2 } };
+      // exercise
+      custom::unordered_map<std::string, int> umDes(umSrc);
+      umDes["one"] = 100;
+      // verify
+      assertUnit(umDes.size() == 2);
+      assertUnit(umDes.at("two") == 2);
+      assertUnit(umSrc.at("one") == 1);
+      assertUnit(umDes.at("one") == 100);
+   }  // teardown
+
+   // assigning over a map with const keys replaces them all
+   void test_assign_copy()
+   {  // setup
+      custom::unordered_map<int, int> umSrc;
+      custom::unordered_map<int, int> umDes;
+      for (int i = 0; i < 5; i++)
+      {
+         umSrc[i] = i;
+         umDes[i + 100] = i;
+      }
+      // exercise
+      umDes = umSrc;
+      // verify
+      assertUnit(umDes.size() == 5);
+      assertUnit(umDes.count(100) == 0);
+      assertUnit(umDes.at(4) == 4);
+   }  // teardown
+
+   /***************************************
+    * RANDOM
+    ***************************************/
+
+   // the same operations on std::unordered_map give the same answers
+   void test_random()
+   {  // setup
+      custom::unordered_map<int, int> um;
+      std::unordered_map<int, int> stdMap;
+      unsigned int seed = 1;
+      // exercise
+      for (int i = 0; i < 20000; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         int key = (seed >> 16) % 500;
+         switch (i % 4)
+         {
+            case 0: um[key] += i;             stdMap[key] += i;             break;
+            case 1: um.try_emplace(key, i);   stdMap.try_emplace(key, i);   break;
+            case 2: um.insert_or_assign(key, i); stdMap.insert_or_assign(key, i); break;
+            case 3: um.erase(key);            stdMap.erase(key);            break;
+         }
+      }
+      // verify
+      assertUnit(um.size() == stdMap.size());
+      bool isSame = true;
+      for (auto it = stdMap.begin(); it != stdMap.end(); ++it)
+      {
+         auto itFound = um.find(it->first);
+         isSame = isSame && itFound != um.end() && (*itFound).second == it->second;
+      }
+      assertUnit(isSame);
+   }  // teardown
+};
+
+#endif // DEBUG
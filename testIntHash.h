@@ -0,0 +1,287 @@
+/***********************************************************************
+ * Header:
+ *    TEST INT HASH
+ * Summary:
+ *    Unit tests for int_unordered_set
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+#ifdef DEBUG
+
+#include "inthash.h"    // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <cstdint>
+#include <unordered_set>
+
+/***********************************************
+ * TEST INT HASH
+ * Unit tests for the int_unordered_set class
+ ***********************************************/
+class TestIntHash : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_sentinels();
+
+      // Insert
+      test_insert_one();
+      test_insert_duplicate();
+      test_insert_reserved();
+      test_insert_reuseTombstone();
+      test_insert_grow();
+      test_insert_sweepTombstones();
+
+      // Erase
+      test_erase_beforeEmpty();
+      test_erase_tombstone();
+
+      // Iterator
+      test_iterator_skips();
+
+      // Against the standard library
+      test_random_multiplyShift();
+      test_random_identity();
+
+      report("IntHash");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // eight empty slots, each exactly one key wide
+   void test_construct_default()
+   {  // exercise
+      custom::int_unordered_set<uint32_t> s;
+      // verify
+      assertUnit(s.size() == 0);
+      assertUnit(s.bucket_count() == 8);
+      assertUnit(s.numBits == 3);
+      assertUnit(sizeof(s.slots[0]) == sizeof(uint32_t));
+      for (size_t i = 0; i < 8; i++)
+         assertUnit(s.slots[i] == 0xFFFFFFFFu);
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // chosen sentinels fill the slots instead
+   void test_construct_sentinels()
+   {  // exercise
+      custom::int_unordered_set<int64_t, 0, -1> s(5);
+      // verify
+      assertUnit(s.bucket_count() == 8);
+      for (size_t i = 0; i < 8; i++)
+         assertUnit(s.slots[i] == 0);
+      assertUnit(s.insert(0xFFFFFFFFFFFFll).second);
+      assertUnit(s.find(0) == s.end());
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   void test_insert_one()
+   {  // setup
+      custom::int_unordered_set<uint64_t> s;
+      // exercise
+      auto result = s.insert(42);
+      // verify
+      assertUnit(result.second);
+      assertUnit(*result.first == 42);
+      assertUnit(result.first.iSlot == s.home(42));
+      assertUnit(s.size() == 1);
+      assertUnit(s.find(42) == result.first);
+      assertUnit(s.find(43) == s.end());
+   }  // teardown
+
+   void test_insert_duplicate()
+   {  // setup
+      custom::int_unordered_set<int> s;
+      s.insert(-7);
+      // exercise
+      auto result = s.insert(-7);
+      // verify
+      assertUnit(!result.second);
+      assertUnit(*result.first == -7);
+      assertUnit(s.size() == 1);
+   }  // teardown
+
+   // the marker keys cannot go in
+   void test_insert_reserved()
+   {  // setup
+      custom::int_unordered_set<uint32_t> s;
+      bool thrown = false;
+      // exercise
+      try
+      {
+         s.insert(0xFFFFFFFEu);
+      }
+      catch (const char* error)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(s.size() == 0);
+   }  // teardown
+
+   // a new key takes the first tombstone on its probe
+   void test_insert_reuseTombstone()
+   {  // setup
+      custom::int_unordered_set<uint32_t, 0xFFFFFFFFu, 0xFFFFFFFEu, custom::identity_hash> s;
+      s.insert(1);
+      s.insert(9);    // 1 and 9 both start at slot 1
+      s.insert(17);
+      s.erase(9);
+      // exercise
+      s.insert(25);
+      // verify
+      assertUnit(s.slots[1] == 1);
+      assertUnit(s.slots[2] == 25);
+      assertUnit(s.slots[3] == 17);
+      assertUnit(s.numTombstones == 0);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // past three quarters full the slots double
+   void test_insert_grow()
+   {  // setup
+      custom::int_unordered_set<uint32_t> s;
+      for (uint32_t k = 0; k < 6; k++)
+         s.insert(k);
+      assertUnit(s.bucket_count() == 8);
+      // exercise
+      s.insert(6);
+      // verify
+      assertUnit(s.bucket_count() == 16);
+      assertUnit(s.size() == 7);
+      for (uint32_t k = 0; k < 7; k++)
+         assertUnit(s.find(k) != s.end());
+   }  // teardown
+
+   // tombstones alone trigger a same-size rehash that removes them
+   void test_insert_sweepTombstones()
+   {  // setup
+      custom::int_unordered_set<uint32_t, 0xFFFFFFFFu, 0xFFFFFFFEu, custom::identity_hash> s;
+      for (uint32_t k = 0; k < 6; k++)
+         s.insert(8 * k);     // all start at slot 0
+      for (uint32_t k = 0; k < 5; k++)
+         s.erase(8 * k);
+      assertUnit(s.numTombstones == 5);
+      // exercise
+      s.insert(3);
+      // verify
+      assertUnit(s.bucket_count() == 8);
+      assertUnit(s.numTombstones == 0);
+      assertUnit(s.size() == 2);
+      assertUnit(s.find(40) != s.end());
+      assertUnit(s.find(3) != s.end());
+   }  // teardown
+
+   /***************************************
+    * ERASE
+    ***************************************/
+
+   // nothing probes past a key with an empty slot after it
+   void test_erase_beforeEmpty()
+   {  // setup
+      custom::int_unordered_set<uint32_t, 0xFFFFFFFFu, 0xFFFFFFFEu, custom::identity_hash> s;
+      s.insert(2);
+      // exercise
+      size_t num = s.erase(2);
+      // verify
+      assertUnit(num == 1);
+      assertUnit(s.slots[2] == 0xFFFFFFFFu);
+      assertUnit(s.numTombstones == 0);
+      assertUnit(s.erase(2) == 0);
+   }  // teardown
+
+   // a key in the middle of a run leaves a tombstone
+   void test_erase_tombstone()
+   {  // setup
+      custom::int_unordered_set<uint32_t, 0xFFFFFFFFu, 0xFFFFFFFEu, custom::identity_hash> s;
+      s.insert(4);
+      s.insert(12);   // 4 and 12 both start at slot 4
+      // exercise
+      s.erase(4);
+      // verify
+      assertUnit(s.slots[4] == 0xFFFFFFFEu);
+      assertUnit(s.numTombstones == 1);
+      assertUnit(s.find(12) != s.end());
+      assertUnit(s.size() == 1);
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   void test_iterator_skips()
+   {  // setup
+      custom::int_unordered_set<uint32_t, 0xFFFFFFFFu, 0xFFFFFFFEu, custom::identity_hash> s;
+      s.insert(1);
+      s.insert(9);
+      s.insert(5);
+      s.erase(1);     // a tombstone at slot 1
+      uint32_t sum = 0;
+      size_t num = 0;
+      // exercise
+      for (auto it = s.begin(); it != s.end(); ++it, ++num)
+         sum += *it;
+      // verify
+      assertUnit(num == 2);
+      assertUnit(sum == 14);
+   }  // teardown
+
+   /***************************************
+    * RANDOM
+    ***************************************/
+
+   void test_random_multiplyShift()
+   {
+      assertUnit((agrees<custom::int_unordered_set<uint64_t>>(0x12345678u)));
+   }
+
+   void test_random_identity()
+   {
+      assertUnit((agrees<custom::int_unordered_set<uint32_t, 0, 1, custom::identity_hash>>(0x9abcdefu)));
+   }
+
+   // insert and erase pseudo-random keys from a small range so that
+   // tombstones pile up and get swept; the answers must match std
+   template <typename Set>
+   bool agrees(uint64_t seed)
+   {
+      Set s;
+      std::unordered_set<uint64_t> expected;
+      for (int i = 0; i < 20000; i++)
+      {
+         seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+         uint64_t k = (seed >> 33) % 2000 + 2;
+         if ((seed >> 20) & 1)
+         {
+            if (s.insert(k).second != expected.insert(k).second)
+               return false;
+         }
+         else if (s.erase(k) != expected.erase(k))
+            return false;
+      }
+      size_t num = 0;
+      for (auto it = s.begin(); it != s.end(); ++it, ++num)
+         if (expected.count(*it) == 0)
+            return false;
+      for (uint64_t k = 2; k < 2002; k++)
+         if ((s.find(k) != s.end()) != (expected.count(k) == 1))
+            return false;
+      return num == expected.size() && s.size() == expected.size();
+   }
+};
+
+#endif // DEBUG
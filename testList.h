@@ -8,7 +8,9 @@
  ************************************************************************/
 
 #pragma once
+#ifdef _MSC_VER
 #pragma warning(disable : 4312)  // disable warning on 'type cast': conversion from 'unsigned int' to 'custom::list<T,A>::Node *' of greater size
+#endif
 
 #ifdef DEBUG
 
@@ -101,6 +103,8 @@ public:
       test_insertMove_empty();
       test_insertMove_standardFront();
       test_insertMove_standardMiddle();
+      test_spliceBack_middleToEmpty();
+      test_spliceBack_tailToStandard();
 
       // Remove
       test_clear_empty();
@@ -2483,6 +2487,89 @@ public:
    }
 
 
+   /***************************************
+    * SPLICE BACK
+    ***************************************/
+
+   // move the middle node of the standard list onto an empty one
+   void test_spliceBack_middleToEmpty()
+   {  // setup
+      //       +----+   +----+   +----+
+      //       | 11 | - | 26 | - | 31 |
+      //       +----+   +----+   +----+
+      //                  it
+      custom::list<Spy> lSrc;
+      setupStandardFixture(lSrc);
+      custom::list<Spy> lDes;
+      custom::list<Spy>::iterator it;
+      it.p = lSrc.pHead->pNext;
+      custom::list<Spy>::Node* pNode = it.p;
+      Spy::reset();
+      // exercise
+      lDes.splice_back(lSrc, it);
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      //       +----+   +----+        +----+
+      //       | 11 | - | 31 |        | 26 |
+      //       +----+   +----+        +----+
+      assertUnit(lSrc.numElements == 2);
+      assertUnit(lSrc.pHead->data == Spy(11));
+      assertUnit(lSrc.pHead->pNext == lSrc.pTail);
+      assertUnit(lSrc.pTail->data == Spy(31));
+      assertUnit(lSrc.pTail->pPrev == lSrc.pHead);
+      assertUnit(lDes.numElements == 1);
+      assertUnit(lDes.pHead == pNode);
+      assertUnit(lDes.pTail == pNode);
+      assertUnit(pNode->pNext == nullptr);
+      assertUnit(pNode->pPrev == nullptr);
+      // teardown
+      teardownStandardFixture(lDes);
+      teardownStandardFixture(lSrc);
+   }
+
+   // move the tail of one list onto the back of another
+   void test_spliceBack_tailToStandard()
+   {  // setup
+      //       +----+   +----+   +----+
+      //       | 11 | - | 26 | - | 31 |
+      //       +----+   +----+   +----+
+      custom::list<Spy> lDes;
+      setupStandardFixture(lDes);
+      custom::list<Spy> lSrc;
+      lSrc.push_back(Spy(50));
+      lSrc.push_back(Spy(60));
+      custom::list<Spy>::iterator it;
+      it.p = lSrc.pTail;
+      Spy::reset();
+      // exercise
+      lDes.splice_back(lSrc, it);
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      //       +----+   +----+   +----+   +----+        +----+
+      //       | 11 | - | 26 | - | 31 | - | 60 |        | 50 |
+      //       +----+   +----+   +----+   +----+        +----+
+      assertUnit(lSrc.numElements == 1);
+      assertUnit(lSrc.pHead == lSrc.pTail);
+      assertUnit(lSrc.pHead->data == Spy(50));
+      assertUnit(lSrc.pHead->pNext == nullptr);
+      assertUnit(lDes.numElements == 4);
+      assertUnit(lDes.pTail->data == Spy(60));
+      assertUnit(lDes.pTail->pPrev->data == Spy(31));
+      assertUnit(lDes.pTail->pPrev->pNext == lDes.pTail);
+      assertUnit(lDes.pTail->pNext == nullptr);
+      // teardown
+      teardownStandardFixture(lDes);
+   }
+
    /***************************************
     * ERASE
     ***************************************/
@@ -0,0 +1,313 @@
+/***********************************************************************
+ * Header:
+ *    TEST PARALLEL
+ * Summary:
+ *    Unit tests for the thread pool and the parallel algorithms
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+#ifdef DEBUG
+
+#include "parallel.h"   // algorithms under test
+#include "threadpool.h" // pool under test
+#include "pool.h"       // for node_pool, which is not thread safe
+#include "unitTest.h"   // unit test baseclass
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************
+ * TEST PARALLEL
+ * Unit tests for thread_pool and parallel_*
+ ***********************************************/
+class TestParallel : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Pool
+      test_pool_everyChunkOnce();
+      test_pool_noWorkers();
+      test_pool_steal();
+      test_pool_exception();
+
+      // Algorithms
+      test_forEach_sum();
+      test_countIf_half();
+      test_anyOf();
+      test_eraseIf_half();
+      test_eraseIf_trees();
+      test_eraseIf_memoryResource();
+      test_clone_same();
+      test_clone_trees();
+      test_clone_memoryResource();
+
+      report("Parallel");
+   }
+
+   /***************************************
+    * POOL
+    ***************************************/
+
+   // ten thousand chunks over four threads, each run exactly once
+   void test_pool_everyChunkOnce()
+   {  // setup
+      custom::thread_pool pool(3);
+      std::vector<std::atomic<int>> numRuns(10000);
+      // exercise
+      pool.run(numRuns.size(), [&](size_t iChunk) { numRuns[iChunk]++; });
+      pool.run(numRuns.size(), [&](size_t iChunk) { numRuns[iChunk]++; });
+      // verify
+      assertUnit(pool.size() == 3);
+      bool isTwice = true;
+      for (size_t i = 0; i < numRuns.size(); i++)
+         isTwice = isTwice && numRuns[i] == 2;
+      assertUnit(isTwice);
+   }  // teardown
+
+   // with no workers the caller does it all
+   void test_pool_noWorkers()
+   {  // setup
+      custom::thread_pool pool(0);
+      std::thread::id caller = std::this_thread::get_id();
+      bool isCaller = true;
+      int count = 0;
+      // exercise
+      pool.run(100, [&](size_t iChunk)
+      {
+         isCaller = isCaller && std::this_thread::get_id() == caller;
+         count++;
+      });
+      // verify
+      assertUnit(pool.size() == 0);
+      assertUnit(count == 100);
+      assertUnit(isCaller);
+   }  // teardown
+
+   // the worker is stuck on its first chunk, so the caller takes the rest of its share
+   void test_pool_steal()
+   {  // setup
+      custom::thread_pool pool(1);
+      std::thread::id caller = std::this_thread::get_id();
+      std::vector<std::thread::id> ranOn(100);
+      // exercise
+      pool.run(ranOn.size(), [&](size_t iChunk)
+      {
+         if (iChunk == 0 && std::this_thread::get_id() != caller)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+         ranOn[iChunk] = std::this_thread::get_id();
+      });
+      // verify
+      assertUnit(ranOn[49] == caller);   // the back of the worker's share
+      assertUnit(ranOn[99] == caller);   // the back of the caller's own
+   }  // teardown
+
+   // the first exception comes back to the caller, and the pool goes on
+   void test_pool_exception()
+   {  // setup
+      custom::thread_pool pool(2);
+      std::atomic<int> count(0);
+      bool isThrown = false;
+      // exercise
+      try
+      {
+         pool.run(50, [&](size_t iChunk)
+         {
+            count++;
+            if (iChunk == 7)
+               throw std::runtime_error("chunk 7");
+         });
+      }
+      catch (const std::runtime_error&)
+      {
+         isThrown = true;
+      }
+      pool.run(50, [&](size_t iChunk) { count++; });
+      // verify
+      assertUnit(isThrown);
+      assertUnit(count == 100);
+   }  // teardown
+
+   /***************************************
+    * ALGORITHMS
+    ***************************************/
+
+   // the sum of 0 to 99999 over every element
+   void test_forEach_sum()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::unordered_set<int> us;
+      for (int i = 0; i < 100000; i++)
+         us.insert(i);
+      std::atomic<long long> sum(0);
+      // exercise
+      custom::parallel_for_each(pool, us, [&](const int& n) { sum += n; });
+      // verify
+      assertUnit(sum == 99999LL * 100000 / 2);
+   }  // teardown
+
+   // half of them are even
+   void test_countIf_half()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::unordered_set<int> us;
+      for (int i = 0; i < 100000; i++)
+         us.insert(i);
+      // exercise
+      size_t numEven = custom::parallel_count_if(pool, us, [](const int& n) { return n % 2 == 0; });
+      // verify
+      assertUnit(numEven == 50000);
+   }  // teardown
+
+   // one element matches, then none
+   void test_anyOf()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::unordered_set<std::string> us;
+      for (int i = 0; i < 10000; i++)
+         us.insert("key" + std::to_string(i));
+      // exercise
+      bool isHit = custom::parallel_any_of(pool, us, [](const std::string& s) { return s == "key9876"; });
+      bool isMiss = custom::parallel_any_of(pool, us, [](const std::string& s) { return s == "key10000"; });
+      // verify
+      assertUnit(isHit);
+      assertUnit(!isMiss);
+   }  // teardown
+
+   // erase the odd ones out of a hundred thousand
+   void test_eraseIf_half()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::unordered_set<int> us;
+      for (int i = 0; i < 100000; i++)
+         us.insert(i);
+      // exercise
+      size_t numErased = custom::parallel_erase_if(pool, us, [](const int& n) { return n % 2 == 1; });
+      // verify
+      assertUnit(numErased == 50000);
+      assertUnit(us.size() == 50000);
+      assertUnit(us.find(4) != us.end());
+      assertUnit(us.find(5) == us.end());
+      size_t count = 0;
+      for (auto it = us.begin(); it != us.end(); ++it)
+         count++;
+      assertUnit(count == 50000);
+      assertUnit(us.stats().numElements == 50000);
+   }  // teardown
+
+   // a chain that keeps a tree, and one that loses it
+   void test_eraseIf_trees()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::unordered_set<int> us(4096);
+      us.seed = 0;   // so that the chains below collide
+      for (int i = 0; i < 20; i++)
+      {
+         us.insert(i * 4096);          // all in bucket 0
+         us.insert(i * 4096 + 2000);   // all in bucket 2000
+      }
+      size_t bytesTwoTrees = us.memory_usage().trees;
+      // exercise
+      size_t numErased = custom::parallel_erase_if(pool, us,
+         [](const int& n) { return n % 4096 == 0 ? n >= 10 * 4096 : n >= 4 * 4096; });
+      // verify
+      assertUnit(numErased == 10 + 16);
+      assertUnit(us.size() == 10 + 4);
+      assertUnit(us.bucket_size(0) == 10);
+      assertUnit(us.bucket_size(2000) == 4);
+      assertUnit(us.memory_usage().trees > 0);
+      assertUnit(us.memory_usage().trees < bytesTwoTrees);
+      for (int i = 0; i < 20; i++)
+      {
+         assertUnit((us.find(i * 4096) != us.end()) == (i < 10));
+         assertUnit((us.find(i * 4096 + 2000) != us.end()) == (i < 4));
+      }
+      us.insert(20 * 4096);
+      assertUnit(us.find(20 * 4096) != us.end());
+   }  // teardown
+
+   // a node_pool is not thread safe, so the erase stays on this thread
+   void test_eraseIf_memoryResource()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::node_pool nodes;
+      custom::pmr::unordered_set<int> us(&nodes);
+      for (int i = 0; i < 10000; i++)
+         us.insert(i);
+      // exercise
+      size_t numErased = custom::parallel_erase_if(pool, us, [](const int& n) { return n < 2500; });
+      // verify
+      assertUnit(numErased == 2500);
+      assertUnit(us.size() == 7500);
+      assertUnit(us.find(2499) == us.end());
+      assertUnit(us.find(2500) != us.end());
+   }  // teardown
+
+   // every element, in the same bucket, under the same settings
+   void test_clone_same()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::unordered_set<int> usSrc;
+      usSrc.max_load_factor(2.0);
+      for (int i = 0; i < 100000; i++)
+         usSrc.insert(i * 31);
+      // exercise
+      custom::unordered_set<int> usDes = custom::parallel_clone(pool, usSrc);
+      // verify
+      assertUnit(usDes.size() == 100000);
+      assertUnit(usDes.bucket_count() == usSrc.bucket_count());
+      assertUnit(usDes.max_load_factor() == 2.0);
+      bool isSame = true;
+      auto itDes = usDes.begin();
+      for (auto itSrc = usSrc.begin(); itSrc != usSrc.end(); ++itSrc, ++itDes)
+         isSame = isSame && itDes != usDes.end() && *itDes == *itSrc;
+      assertUnit(isSame);
+      assertUnit(itDes == usDes.end());
+      assertUnit(usDes.find(31 * 99999) != usDes.end());
+   }  // teardown
+
+   // a long chain gets its own tree in the clone
+   void test_clone_trees()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::unordered_set<int> usSrc(4096);
+      usSrc.seed = 0;   // so that every multiple of 4096 shares bucket 0
+      for (int i = 0; i < 20; i++)
+         usSrc.insert(i * 4096);
+      // exercise
+      custom::unordered_set<int> usDes = custom::parallel_clone(pool, usSrc);
+      usSrc.clear();
+      // verify
+      assertUnit(usDes.memory_usage().trees > 0);
+      assertUnit(usDes.bucket_size(0) == 20);
+      assertUnit(usDes.find(19 * 4096) != usDes.end());
+      assertUnit(usDes.find(20 * 4096) == usDes.end());
+   }  // teardown
+
+   // a node_pool is not thread safe, so the clone stays on this thread
+   void test_clone_memoryResource()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::node_pool nodes;
+      custom::pmr::unordered_set<int> usSrc(&nodes);
+      for (int i = 0; i < 10000; i++)
+         usSrc.insert(i);
+      // exercise
+      custom::pmr::unordered_set<int> usDes = custom::parallel_clone(pool, usSrc);
+      // verify
+      assertUnit(usDes.size() == 10000);
+      assertUnit(usDes.get_allocator().resource() == std::pmr::get_default_resource());
+      assertUnit(usDes.find(9999) != usDes.end());
+   }  // teardown
+};
+
+#endif // DEBUG
@@ -0,0 +1,139 @@
+/***********************************************************************
+ * Header:
+ *    TEST STATIC HASH
+ * Summary:
+ *    Unit tests for static_unordered_set
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+#ifdef DEBUG
+
+#include "statichash.h"   // class under test
+#include "unitTest.h"     // unit test baseclass
+
+#include <string_view>
+
+// built by the compiler; a mistake here fails the build, not the tests
+constexpr auto testKeywords = custom::make_static_unordered_set<std::string_view>(
+   { "if", "else", "while", "for", "do", "return", "break", "continue" });
+constexpr auto testOpcodes = custom::make_static_unordered_set<int>(
+   { 0x01, 0x10, 0x20, 0x37, 0x40, 0x80, 0x81, 0xFF, 0x10 });
+static_assert(testKeywords.contains("while"), "keyword found at compile time");
+static_assert(!testKeywords.contains("whilst"), "non-keyword missed at compile time");
+static_assert(testOpcodes.size() == 8, "duplicate opcode dropped at compile time");
+
+/***********************************************
+ * TEST STATIC HASH
+ * Unit tests for the static_unordered_set class
+ ***********************************************/
+class TestStaticHash : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_layout();
+      test_construct_duplicates();
+      test_construct_collisions();
+
+      // Find
+      test_find_hit();
+      test_find_miss();
+
+      // Iterator
+      test_iterator_order();
+
+      report("StaticHash");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // twice the keys, rounded up, each key in exactly one slot
+   void test_construct_layout()
+   {  // setup
+      size_t numUsed = 0;
+      // exercise
+      for (size_t i = 0; i < testKeywords.bucket_count(); i++)
+         if (testKeywords.slots[i] != testKeywords.EMPTY)
+            numUsed++;
+      // verify
+      assertUnit(testKeywords.size() == 8);
+      assertUnit(testKeywords.bucket_count() == 16);
+      assertUnit(numUsed == 8);
+      assertUnit(testKeywords.max_probe() >= 1);
+      assertUnit(testKeywords.max_probe() <= 8);
+   }  // teardown
+
+   // the first of each repeated key is kept
+   void test_construct_duplicates()
+   {  // exercise
+      constexpr auto s = custom::make_static_unordered_set<int>({ 5, 5, 5, 6 });
+      // verify
+      assertUnit(s.size() == 2);
+      assertUnit(s.keys[0] == 5);
+      assertUnit(s.keys[1] == 6);
+      assertUnit(s.bucket_count() == 8);
+   }  // teardown
+
+   // with every key hashing alike, the probe covers them all
+   void test_construct_collisions()
+   {  // setup
+      struct Zero
+      {
+         constexpr size_t operator () (int) const { return 0; }
+      };
+      // exercise
+      constexpr auto s = custom::make_static_unordered_set<int, Zero>({ 1, 2, 3, 4 });
+      // verify
+      assertUnit(s.max_probe() == 4);
+      assertUnit(s.contains(1));
+      assertUnit(s.contains(4));
+      assertUnit(!s.contains(5));
+   }  // teardown
+
+   /***************************************
+    * FIND
+    ***************************************/
+
+   void test_find_hit()
+   {  // verify
+      for (auto it = testKeywords.begin(); it != testKeywords.end(); ++it)
+         assertUnit(*testKeywords.find(*it) == *it);
+      assertUnit(*testOpcodes.find(0x37) == 0x37);
+      assertUnit(testOpcodes.contains(0xFF));
+   }
+
+   void test_find_miss()
+   {  // verify
+      assertUnit(testKeywords.find("") == testKeywords.end());
+      assertUnit(testKeywords.find("If") == testKeywords.end());
+      assertUnit(testKeywords.find("return ") == testKeywords.end());
+      for (int op = 0x41; op < 0x80; op++)
+         assertUnit(!testOpcodes.contains(op));
+   }
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // the keys come back in the order they were listed
+   void test_iterator_order()
+   {  // setup
+      const int expected[] = { 0x01, 0x10, 0x20, 0x37, 0x40, 0x80, 0x81, 0xFF };
+      size_t i = 0;
+      // exercise
+      for (auto it = testOpcodes.begin(); it != testOpcodes.end(); ++it, ++i)
+         assertUnit(*it == expected[i]);
+      // verify
+      assertUnit(i == 8);
+   }  // teardown
+};
+
+#endif // DEBUG
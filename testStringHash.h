@@ -0,0 +1,265 @@
+/***********************************************************************
+ * Header:
+ *    TEST STRING HASH
+ * Summary:
+ *    Unit tests for string_unordered_set
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+#ifdef DEBUG
+
+#include "stringhash.h"   // class under test
+#include "unitTest.h"     // unit test baseclass
+
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+/***********************************************
+ * TEST STRING HASH
+ * Unit tests for the string_unordered_set class
+ ***********************************************/
+class TestStringHash : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+
+      // Insert
+      test_insert_short();
+      test_insert_long();
+      test_insert_duplicate();
+      test_insert_samePrefix();
+      test_insert_empty();
+      test_insert_ownKeyGrowing();
+
+      // Erase
+      test_erase_tombstone();
+      test_erase_compactStore();
+
+      // Iterator
+      test_iterator_visitsAll();
+
+      // Against the standard library
+      test_random();
+
+      report("StringHash");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   void test_construct_default()
+   {  // exercise
+      custom::string_unordered_set<> s;
+      // verify
+      assertUnit(s.size() == 0);
+      assertUnit(s.bucket_count() == 8);
+      assertUnit(s.bytes_stored() == 0);
+      assertUnit(s.begin() == s.end());
+      assertUnit(sizeof(s.slots[0]) == 32);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // up to 8 bytes the key lives entirely in its slot
+   void test_insert_short()
+   {  // setup
+      custom::string_unordered_set<> s;
+      // exercise
+      auto result = s.insert("12345678");
+      // verify
+      assertUnit(result.second);
+      assertUnit(*result.first == "12345678");
+      assertUnit(s.bytes_stored() == 0);
+      assertUnit(s.find("12345678") == result.first);
+      assertUnit(s.find("1234567") == s.end());
+   }  // teardown
+
+   // longer keys are copied to the store
+   void test_insert_long()
+   {  // setup
+      custom::string_unordered_set<> s;
+      std::string url = "https://example.com/index.html";
+      // exercise
+      auto result = s.insert(url);
+      url[8] = 'X';   // the set has its own copy
+      // verify
+      assertUnit(result.second);
+      assertUnit(s.bytes_stored() == 30);
+      assertUnit(s.slots[result.first.iSlot].offset == 0);
+      assertUnit(std::string_view(s.slots[result.first.iSlot].prefix, 8) == "https://");
+      assertUnit(*s.find("https://example.com/index.html") == "https://example.com/index.html");
+   }  // teardown
+
+   void test_insert_duplicate()
+   {  // setup
+      custom::string_unordered_set<> s;
+      s.insert("a long enough key");
+      // exercise
+      auto result = s.insert(std::string("a long enough key"));
+      // verify
+      assertUnit(!result.second);
+      assertUnit(s.size() == 1);
+      assertUnit(s.bytes_stored() == 17);
+   }  // teardown
+
+   // keys sharing a hash and 8 bytes are told apart in the store
+   void test_insert_samePrefix()
+   {  // setup
+      struct One
+      {
+         size_t operator () (std::string_view) const { return 1; }
+      };
+      custom::string_unordered_set<One> s;
+      // exercise
+      s.insert("prefix00-alpha");
+      s.insert("prefix00-bravo");
+      s.insert("prefix00");
+      // verify
+      assertUnit(s.size() == 3);
+      assertUnit(s.find("prefix00-alpha") != s.end());
+      assertUnit(s.find("prefix00-bravo") != s.end());
+      assertUnit(s.find("prefix00") != s.end());
+      assertUnit(s.find("prefix00-charl") == s.end());
+      assertUnit(s.find("prefix0") == s.end());
+   }  // teardown
+
+   void test_insert_empty()
+   {  // setup
+      custom::string_unordered_set<> s;
+      // exercise
+      s.insert("");
+      // verify
+      assertUnit(s.size() == 1);
+      assertUnit(s.find("") != s.end());
+      assertUnit((*s.find("")).empty());
+   }  // teardown
+
+   // a key taken from the set itself survives the rehash and append it causes
+   void test_insert_ownKeyGrowing()
+   {  // setup
+      custom::string_unordered_set<> s;
+      s.insert("short");
+      for (int i = 0; i < 5; i++)
+         s.insert("a key long enough for the store " + std::to_string(i));
+      size_t numSlots = s.bucket_count();
+      // exercise
+      auto resultShort = s.insert((*s.find("short")).substr(1));                              // grows
+      auto resultLong = s.insert((*s.find("a key long enough for the store 3")).substr(2));   // appends
+      // verify
+      assertUnit(s.bucket_count() > numSlots);
+      assertUnit(resultShort.second);
+      assertUnit(resultLong.second);
+      assertUnit(*resultShort.first == "hort");
+      assertUnit(*resultLong.first == "key long enough for the store 3");
+      assertUnit(s.find("key long enough for the store 3") != s.end());
+      assertUnit(s.find("a key long enough for the store 3") != s.end());
+      assertUnit(s.find("hort") != s.end());
+      assertUnit(s.size() == 8);
+   }  // teardown
+
+   /***************************************
+    * ERASE
+    ***************************************/
+
+   // the slot is marked, the bytes wait for a rehash
+   void test_erase_tombstone()
+   {  // setup
+      custom::string_unordered_set<> s;
+      s.insert("the first long key");
+      s.insert("short");
+      // exercise
+      size_t num = s.erase("the first long key");
+      // verify
+      assertUnit(num == 1);
+      assertUnit(s.size() == 1);
+      assertUnit(s.numTombstones == 1);
+      assertUnit(s.numDead == 18);
+      assertUnit(s.bytes_stored() == 18);
+      assertUnit(s.find("the first long key") == s.end());
+      assertUnit(s.find("short") != s.end());
+      assertUnit(s.erase("the first long key") == 0);
+   }  // teardown
+
+   // a rehash with the store mostly dead copies out the live keys
+   void test_erase_compactStore()
+   {  // setup
+      custom::string_unordered_set<> s;
+      s.insert("keep this one around");
+      s.insert("drop this one please");
+      s.insert("and drop this one too");
+      s.erase("drop this one please");
+      s.erase("and drop this one too");
+      // exercise
+      s.rehash(16);
+      // verify
+      assertUnit(s.bucket_count() == 16);
+      assertUnit(s.numTombstones == 0);
+      assertUnit(s.numDead == 0);
+      assertUnit(s.bytes_stored() == 20);
+      assertUnit(*s.find("keep this one around") == "keep this one around");
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   void test_iterator_visitsAll()
+   {  // setup
+      custom::string_unordered_set<> s { "one", "two", "three hundred and three" };
+      s.erase("two");
+      size_t numBytes = 0;
+      size_t num = 0;
+      // exercise
+      for (auto it = s.begin(); it != s.end(); ++it, ++num)
+         numBytes += (*it).size();
+      // verify
+      assertUnit(num == 2);
+      assertUnit(numBytes == 26);
+   }  // teardown
+
+   /***************************************
+    * RANDOM
+    ***************************************/
+
+   // short and long keys, inserted and erased until tombstones are
+   // swept and the store compacted; the answers must match std
+   void test_random()
+   {  // setup
+      custom::string_unordered_set<> s;
+      std::unordered_set<std::string> expected;
+      uint64_t seed = 0x5eed;
+      bool agrees = true;
+      // exercise
+      for (int i = 0; i < 20000 && agrees; i++)
+      {
+         seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+         uint64_t n = (seed >> 33) % 1500;
+         std::string k = n % 2 ? std::to_string(n) : "key number " + std::to_string(n);
+         if ((seed >> 20) & 1)
+            agrees = s.insert(k).second == expected.insert(k).second;
+         else
+            agrees = s.erase(k) == expected.erase(k);
+      }
+      for (auto it = s.begin(); it != s.end(); ++it)
+         agrees = agrees && expected.count(std::string(*it)) == 1;
+      for (auto it = expected.begin(); it != expected.end(); ++it)
+         agrees = agrees && s.find(*it) != s.end();
+      // verify
+      assertUnit(agrees);
+      assertUnit(s.size() == expected.size());
+   }  // teardown
+};
+
+#endif // DEBUG
@@ -0,0 +1,277 @@
+/***********************************************************************
+ * Header:
+ *    THREAD POOL
+ * Summary:
+ *    A small work-stealing pool for splitting one job into chunks
+ *      __      __     _______        __
+ *     /  |    /  |   |  _____|   _  / /
+ *     `| |    `| |   | |____    (_)/ /
+ *      | |     | |   '_.____''.   / / _
+ *     _| |_   _| |_  | \____) |  / / (_)
+ *    |_____| |_____|  \______.' /_/
+ *
+ *    This will contain the class definition of:
+ *        thread_pool : Worker threads that run the chunks of a job
+ *
+ *    A job is numbered chunks 0 to n-1 and a body to call on each:
+ *        custom::thread_pool pool;
+ *        pool.run(numChunks, [&](size_t iChunk) { ... });
+ *    Each thread, the caller's included, starts on its own contiguous
+ *    share of the chunks and takes them from the front. One that runs
+ *    out steals from the back of the share of another, so a few slow
+ *    chunks, such as buckets with long chains, do not hold up the
+ *    rest. A share is one atomic word, so taking or stealing a chunk
+ *    is one compare-and-swap and never a lock.
+ * Author
+ *    Nathan Bird, Brock Hoskins
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>              // for std::atomic
+#include <condition_variable>  // for std::condition_variable
+#include <cstddef>             // for size_t
+#include <cstdint>             // for uint64_t
+#include <exception>           // for std::exception_ptr
+#include <functional>          // for std::function
+#include <memory>              // for std::unique_ptr
+#include <mutex>               // for std::mutex
+#include <thread>              // for std::thread
+#include <vector>              // for std::vector
+
+class TestParallel;            // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * THREAD POOL
+ * numThreads workers, asleep between jobs. run() takes one job at a
+ * time; a body must not call run() on the same pool.
+ ************************************************/
+class thread_pool
+{
+   friend class ::TestParallel;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   explicit thread_pool(size_t numThreads = default_threads());
+   thread_pool(const thread_pool& rhs) = delete;
+   thread_pool& operator = (const thread_pool& rhs) = delete;
+   ~thread_pool();
+
+   //
+   // Run
+   //
+   template <class Body>
+   void run(size_t numChunks, Body body)
+   {
+      std::function<void(size_t)> job(std::ref(body));
+      run_job(numChunks, job);
+   }
+
+   //
+   // Status
+   //
+   size_t size() const { return workers.size(); }   // not counting the caller
+   static size_t default_threads()
+   {
+      size_t num = std::thread::hardware_concurrency();
+      return num > 1 ? num - 1 : 0;   // the caller is the last one
+   }
+
+private:
+   // chunks [front, back) of one share, packed as front << 32 | back
+   struct Share
+   {
+      std::atomic<uint64_t> range{ 0 };
+   };
+   static uint64_t pack(uint64_t front, uint64_t back) { return front << 32 | back; }
+
+   void run_job(size_t numChunks, const std::function<void(size_t)>& job);
+   void work(size_t iShare);
+   bool take(size_t iShare, size_t& iChunk);
+   bool steal(size_t iShare, size_t& iChunk);
+   void loop(size_t iWorker);
+
+   std::vector<std::thread> workers;
+   std::unique_ptr<Share[]> shares;            // one per worker, then the caller's
+   const std::function<void(size_t)>* pJob = nullptr;
+   std::exception_ptr error;                   // the first a body threw
+
+   std::mutex mutex;                           // guards everything below
+   std::condition_variable wake;               // a new job, or stopping
+   std::condition_variable done;               // the last worker finished
+   uint64_t generation = 0;                    // bumped for every job
+   size_t numBusy = 0;                         // workers still on this job
+   bool stopping = false;
+};
+
+/*****************************************
+ * THREAD POOL :: CONSTRUCTOR
+ ****************************************/
+inline thread_pool::thread_pool(size_t numThreads)
+   : shares(new Share[numThreads + 1])
+{
+   workers.reserve(numThreads);
+   for (size_t i = 0; i < numThreads; i++)
+      workers.push_back(std::thread(&thread_pool::loop, this, i));
+}
+
+/*****************************************
+ * THREAD POOL :: DESTRUCTOR
+ * Wake every worker to stop, and wait for them
+ ****************************************/
+inline thread_pool::~thread_pool()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+   }
+   wake.notify_all();
+   for (std::thread& worker : workers)
+      worker.join();
+}
+
+/*****************************************
+ * THREAD POOL :: RUN JOB
+ * Deal the chunks out in equal contiguous shares, wake the workers,
+ * work alongside them, and wait until every chunk is done. Rethrow
+ * the first exception any body threw.
+ ****************************************/
+inline void thread_pool::run_job(size_t numChunks, const std::function<void(size_t)>& job)
+{
+   if (numChunks == 0)
+      return;
+   size_t numShares = workers.size() + 1;
+   for (size_t i = 0; i < numShares; i++)
+      shares[i].range.store(pack(numChunks * i / numShares, numChunks * (i + 1) / numShares),
+                            std::memory_order_relaxed);
+   pJob = &job;
+   error = nullptr;
+
+   if (!workers.empty())
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         numBusy = workers.size();
+         generation++;
+      }
+      wake.notify_all();
+   }
+
+   work(workers.size());
+
+   if (!workers.empty())
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait(lock, [this] { return numBusy == 0; });
+   }
+   pJob = nullptr;
+   if (error)
+      std::rethrow_exception(error);
+}
+
+/*****************************************
+ * THREAD POOL :: WORK
+ * Run our own chunks, then everyone else's
+ ****************************************/
+inline void thread_pool::work(size_t iShare)
+{
+   size_t iChunk;
+   while (take(iShare, iChunk) || steal(iShare, iChunk))
+   {
+      try
+      {
+         (*pJob)(iChunk);
+      }
+      catch (...)
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (!error)
+            error = std::current_exception();
+      }
+   }
+}
+
+/*****************************************
+ * THREAD POOL :: TAKE
+ * The chunk at the front of our own share
+ ****************************************/
+inline bool thread_pool::take(size_t iShare, size_t& iChunk)
+{
+   std::atomic<uint64_t>& range = shares[iShare].range;
+   uint64_t old = range.load(std::memory_order_relaxed);
+   for (;;)
+   {
+      uint64_t front = old >> 32;
+      uint64_t back = old & 0xffffffff;
+      if (front >= back)
+         return false;
+      if (range.compare_exchange_weak(old, pack(front + 1, back), std::memory_order_acq_rel))
+      {
+         iChunk = (size_t)front;
+         return true;
+      }
+   }
+}
+
+/*****************************************
+ * THREAD POOL :: STEAL
+ * The chunk at the back of some other share, starting with the next
+ * one over so that thieves spread out
+ ****************************************/
+inline bool thread_pool::steal(size_t iShare, size_t& iChunk)
+{
+   size_t numShares = workers.size() + 1;
+   for (size_t k = 1; k < numShares; k++)
+   {
+      std::atomic<uint64_t>& range = shares[(iShare + k) % numShares].range;
+      uint64_t old = range.load(std::memory_order_relaxed);
+      for (;;)
+      {
+         uint64_t front = old >> 32;
+         uint64_t back = old & 0xffffffff;
+         if (front >= back)
+            break;
+         if (range.compare_exchange_weak(old, pack(front, back - 1), std::memory_order_acq_rel))
+         {
+            iChunk = (size_t)(back - 1);
+            return true;
+         }
+      }
+   }
+   return false;
+}
+
+/*****************************************
+ * THREAD POOL :: LOOP
+ * A worker's life: sleep until a job comes, work it, report done
+ ****************************************/
+inline void thread_pool::loop(size_t iWorker)
+{
+   uint64_t seen = 0;
+   for (;;)
+   {
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         wake.wait(lock, [&] { return stopping || generation != seen; });
+         if (stopping)
+            return;
+         seen = generation;
+      }
+
+      work(iWorker);
+
+      bool isLast;
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         isLast = --numBusy == 0;
+      }
+      if (isLast)
+         done.notify_one();
+   }
+}
+
+} // namespace custom
@@ -23,6 +23,7 @@
 #include <cassert>  // because I am paranoid
 #include <new>      // std::bad_alloc
 #include <memory>   // for std::allocator
+#include <memory_resource> // for std::pmr::polymorphic_allocator
 
 class TestVector; // forward declaration for unit tests
 class TestStack;
@@ -44,6 +45,7 @@ namespace custom
       friend class ::TestPQueue;
       friend class ::TestHash;
    public:
+      typedef A allocator_type;
 
       //
       // Construct
@@ -64,7 +66,8 @@ namespace custom
          std::swap(data, rhs.data);
          std::swap(numElements, rhs.numElements);
          std::swap(numCapacity, rhs.numCapacity);
-         std::swap(alloc, rhs.alloc);
+         if constexpr (Traits::propagate_on_container_swap::value)
+            std::swap(alloc, rhs.alloc);
       }
       vector& operator = (const vector& rhs);
       vector& operator = (vector&& rhs);
@@ -108,7 +111,7 @@ namespace custom
       {
          // Destroy all elements
          for (size_t i = 0; i < numElements; i++)
-            alloc.destroy(data + i);
+            Traits::destroy(alloc, data + i);
 
          numElements = 0;
       }
@@ -116,7 +119,7 @@ namespace custom
       {
          if (numElements != 0)
          {
-            alloc.destroy(data + numElements - 1);
+            Traits::destroy(alloc, data + numElements - 1);
             numElements--;
          }
       }
@@ -128,8 +131,10 @@ namespace custom
       size_t  size()          const { return numElements;      }
       size_t  capacity()      const { return numCapacity;      }
       bool    empty()         const { return numElements == 0; }
+      A       get_allocator() const { return alloc;            }
 
    private:
+      typedef std::allocator_traits<A> Traits;
 
       A  alloc;                  // use allocator for memory allocation
       T* data;                   // user data, a dynamically-allocated array
@@ -160,7 +165,7 @@ namespace custom
       iterator() : p(nullptr) {}
       iterator(T* p) : p(p) {}
       iterator(const iterator& rhs) : p(rhs.p) {}
-      iterator(size_t index, vector<T>& v) : p(v.data + index) { }
+      iterator(size_t index, vector& v) : p(v.data + index) { }
       iterator& operator = (const iterator& rhs)
       {
          p = rhs.p;
@@ -176,7 +181,7 @@ namespace custom
       }
 
       // dereference operator
-      T& operator * ()
+      T& operator * () const
       {
          return *p;
       }
@@ -222,9 +227,8 @@ namespace custom
     * construct each element, and copy the values over
     ****************************************/
    template <typename T, typename A>
-   vector <T, A> ::vector(const A& a)
+   vector <T, A> ::vector(const A& a) : alloc(a)
    {
-      alloc = a;
       data = nullptr;
       numElements = 0;
       numCapacity = 0;
@@ -237,15 +241,14 @@ namespace custom
     * construct each element, and copy the values over
     ****************************************/
    template <typename T, typename A>
-   vector <T, A> ::vector(size_t num, const T& t, const A& a)
+   vector <T, A> ::vector(size_t num, const T& t, const A& a) : alloc(a)
    {
-      alloc = a;
       numElements = num;
       numCapacity = num;
       data = alloc.allocate(num);
-      for (int i = 0; i < num; i++)
+      for (size_t i = 0; i < num; i++)
       {
-         alloc.construct(data + i, t);
+         Traits::construct(alloc, data + i, t);
       }
    }
 
@@ -254,9 +257,8 @@ namespace custom
     * Create a vector with an initialization list.
     ****************************************/
    template <typename T, typename A>
-   vector <T, A> ::vector(const std::initializer_list<T>& l, const A& a)
+   vector <T, A> ::vector(const std::initializer_list<T>& l, const A& a) : alloc(a)
    {
-      alloc = a;
       numElements = l.size();
       numCapacity = l.size();
       data = alloc.allocate(l.size());
@@ -264,7 +266,7 @@ namespace custom
       T* current = data;
       for (auto it = l.begin(); it != l.end(); it++, current++)
       {
-         alloc.construct(current, *it);
+         Traits::construct(alloc, current, *it);
       }
    }
 
@@ -274,15 +276,14 @@ namespace custom
     * construct each element, and copy the values over
     ****************************************/
    template <typename T, typename A>
-   vector <T, A> ::vector(size_t num, const A& a)
+   vector <T, A> ::vector(size_t num, const A& a) : alloc(a)
    {
-      alloc = a;
       numElements = num;
       numCapacity = num;
       data = alloc.allocate(num);
-      for (int i = 0; i < num; i++)
+      for (size_t i = 0; i < num; i++)
       {
-         alloc.construct(data + i);
+         Traits::construct(alloc, data + i);
       }
    }
 
@@ -293,15 +294,16 @@ namespace custom
     ****************************************/
    template <typename T, typename A>
    vector <T, A> ::vector(const vector& rhs)
+      : alloc(Traits::select_on_container_copy_construction(rhs.alloc))
    {
       if (!rhs.empty())
       {
          data = alloc.allocate(rhs.numElements);
          numCapacity = rhs.numElements;
          numElements = rhs.numElements;
-         for (int i = 0; i < numElements; i++)
+         for (size_t i = 0; i < numElements; i++)
          {
-            alloc.construct(data + i, rhs.data[i]);
+            Traits::construct(alloc, data + i, rhs.data[i]);
          }
       }
       else
@@ -317,7 +319,7 @@ namespace custom
     * Steal the values from the RHS and set it to zero.
     ****************************************/
    template <typename T, typename A>
-   vector <T, A> ::vector(vector&& rhs)
+   vector <T, A> ::vector(vector&& rhs) : alloc(rhs.alloc)
    {
       data = rhs.data;
       rhs.data = nullptr;
@@ -335,11 +337,12 @@ namespace custom
    template <typename T, typename A>
    vector <T, A> :: ~vector()
    {
-      for (int i = 0; i < numElements; i++)
+      for (size_t i = 0; i < numElements; i++)
       {
-         alloc.destroy(data + i);
+         Traits::destroy(alloc, data + i);
       }
-      alloc.deallocate(data, numCapacity);
+      if (data)
+         alloc.deallocate(data, numCapacity);
    }
 
    /***************************************
@@ -356,7 +359,7 @@ namespace custom
       {
          for (size_t i = newElements; i < numElements; i++)
          {
-            alloc.destroy(data + i);
+            Traits::destroy(alloc, data + i);
          }
       }
       else if (newElements > numElements)
@@ -364,7 +367,7 @@ namespace custom
          if (newElements > numCapacity)
             reserve(newElements);
          for (size_t i = numElements; i < newElements; i++)
-            alloc.construct(data + i);
+            Traits::construct(alloc, data + i);
       }
       numElements = newElements;
    }
@@ -375,14 +378,14 @@ namespace custom
       if (newElements < numElements)
       {
          for (size_t i = newElements; i < numElements; i++)
-            alloc.destroy(data + i);
+            Traits::destroy(alloc, data + i);
       }
       else if (newElements > numElements)
       {
          if (newElements > numCapacity)
             reserve(newElements);
          for (size_t i = numElements; i < newElements; i++)
-            alloc.construct(data + i, t);
+            Traits::construct(alloc, data + i, t);
       }
       numElements = newElements;
    }
@@ -404,10 +407,11 @@ namespace custom
       T* dataNew = alloc.allocate(newCapacity);
       for (size_t i = 0; i < numElements; i++)
       {
-         alloc.construct(dataNew + i, std::move(data[i]));
-         alloc.destroy(data + i);
+         Traits::construct(alloc, dataNew + i, std::move(data[i]));
+         Traits::destroy(alloc, data + i);
       }
-      alloc.deallocate(data, numCapacity);
+      if (data)
+         alloc.deallocate(data, numCapacity);
 
       data = dataNew;
       numCapacity = newCapacity;
@@ -431,8 +435,8 @@ namespace custom
             T* newData = alloc.allocate(numElements);
             for (size_t i = 0; i < numElements; i++)
             {
-               alloc.construct(newData + i, data[i]);
-               alloc.destroy(data + i);
+               Traits::construct(alloc, newData + i, data[i]);
+               Traits::destroy(alloc, data + i);
             }
             alloc.deallocate(data, numCapacity);
             data = newData;
@@ -525,7 +529,7 @@ namespace custom
       {
          reserve((numCapacity != 0 ? numCapacity * 2 : 1));
       }
-      alloc.construct(data + numElements, t);
+      Traits::construct(alloc, data + numElements, t);
       numElements++;
    }
 
@@ -536,7 +540,7 @@ namespace custom
       {
          reserve((numCapacity != 0 ? numCapacity * 2 : 1));
       }
-      alloc.construct(data + numElements, std::move(t));
+      Traits::construct(alloc, data + numElements, std::move(t));
       numElements++;
    }
 
@@ -558,7 +562,7 @@ namespace custom
          {
             // Clear existing elements and reallocate
             for (size_t i = 0; i < numElements; i++)
-               alloc.destroy(data + i);
+               Traits::destroy(alloc, data + i);
             if (data)
                alloc.deallocate(data, numCapacity);
 
@@ -568,7 +572,7 @@ namespace custom
 
             // Copy construct all elements
             for (size_t i = 0; i < rhs.numElements; i++)
-               alloc.construct(data + i, rhs.data[i]);
+               Traits::construct(alloc, data + i, rhs.data[i]);
          }
          else
          {
@@ -580,13 +584,13 @@ namespace custom
             if (rhs.numElements < numElements)
             {
                for (size_t i = rhs.numElements; i < numElements; i++)
-                  alloc.destroy(data + i);
+                  Traits::destroy(alloc, data + i);
             }
             // If rhs is larger, construct new elements
             else if (rhs.numElements > numElements)
             {
                for (size_t i = numElements; i < rhs.numElements; i++)
-                  alloc.construct(data + i, rhs.data[i]);
+                  Traits::construct(alloc, data + i, rhs.data[i]);
             }
          }
 
@@ -599,8 +603,25 @@ namespace custom
    vector <T, A>& vector <T, A> :: operator = (vector&& rhs)
    {
       clear();
-      shrink_to_fit();
-      swap(rhs);
+
+      // The buffer can only change hands if our allocator can free it.
+      if (Traits::propagate_on_container_move_assignment::value || alloc == rhs.alloc)
+      {
+         shrink_to_fit();
+         std::swap(data, rhs.data);
+         std::swap(numElements, rhs.numElements);
+         std::swap(numCapacity, rhs.numCapacity);
+         if constexpr (Traits::propagate_on_container_move_assignment::value)
+            alloc = rhs.alloc;
+      }
+      else
+      {
+         reserve(rhs.numElements);
+         for (size_t i = 0; i < rhs.numElements; i++)
+            Traits::construct(alloc, data + i, std::move(rhs.data[i]));
+         numElements = rhs.numElements;
+         rhs.clear();
+      }
 
       return *this;
    }
@@ -608,5 +629,15 @@ namespace custom
 
 
 
+   namespace pmr
+   {
+      /*****************************************
+       * PMR VECTOR
+       * A vector whose buffer comes from a std::pmr::memory_resource
+       ****************************************/
+      template <typename T>
+      using vector = custom::vector<T, std::pmr::polymorphic_allocator<T>>;
+   }
+
 } // namespace custom
 